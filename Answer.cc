@@ -30,6 +30,17 @@
 #include "ns3/energy-module.h"
 #include "ns3/wifi-radio-energy-model-helper.h"
 #include "ns3/constant-velocity-mobility-model.h"
+#include "ns3/traffic-control-module.h"
+
+#include "failure-schedule.h"
+#include "incremental-global-routing.h"
+#include "batched-path-loss-model.h"
+#include "lookup-table-error-rate-model.h"
+#include "lazy-wifi-energy.h"
+#include "queue-disc-type.h"
+#include "wifi-aggregation.h"
+
+#include <chrono>
 
 // Default Network Topology
 //
@@ -45,26 +56,55 @@ using namespace std;
 
 NS_LOG_COMPONENT_DEFINE ("SecondScriptExample");
 
-void TearDownLink (Ptr<Node> nodeA, Ptr<Node> nodeB, uint32_t interfaceA, uint32_t interfaceB)
+void Stop_node(Ptr<ConstantVelocityMobilityModel> m)
 {
-  nodeA->GetObject<Ipv4> ()->SetDown (interfaceA);
-  nodeB->GetObject<Ipv4> ()->SetDown (interfaceB);
+  m->SetVelocity(Vector(0.0,0.0,0.0));
 }
 
-void Stop_node(Ptr<ConstantVelocityMobilityModel> m)
+// Full Dijkstra on every router, timed for comparison with --routeUpdate=incremental
+void Recompute_routes ()
 {
-  m->SetVelocity(Vector(0.0,0.0,0.0));
+  auto start = std::chrono::steady_clock::now ();
+  Ipv4GlobalRoutingHelper::RecomputeRoutingTables ();
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now () - start;
+  NS_LOG_UNCOND (Simulator::Now ().GetSeconds () << "s full route recompute: "
+                 << elapsed.count () * 1e3 << " ms");
 }
 
-void Join_link (Ptr<Node> nodeA, Ptr<Node> nodeB, uint32_t interfaceA, uint32_t interfaceB)
+void Routes_updated (uint32_t roots, double seconds)
 {
-  nodeA->GetObject<Ipv4> ()->SetUp(interfaceA);
-  nodeB->GetObject<Ipv4> ()->SetUp (interfaceB);
+  NS_LOG_UNCOND (Simulator::Now ().GetSeconds () << "s incremental route update: " << roots
+                 << " router(s) recomputed in " << seconds * 1e3 << " ms");
 }
 
 int 
 main (int argc, char *argv[])
 {
+  std::string routeUpdate ("full");
+  uint32_t spfThreads = 1;
+  std::string queueDisc ("none");
+  std::string failures;
+  bool dynamicArp = false;
+  std::string errorModel ("yans");
+  std::string pathLoss ("friis");
+  std::string energy ("none");
+  std::string wifiStandard ("b");
+  std::string aggregation ("none");
+
+  CommandLine cmd (__FILE__);
+  cmd.AddValue ("routeUpdate", "Route update on link events (full, incremental)", routeUpdate);
+  cmd.AddValue ("spfThreads", "SPF threads with --routeUpdate=incremental, 0 for all cores", spfThreads);
+  cmd.AddValue ("failures", "Link failure schedule file, e.g. scratch/answerfinal.failures", failures);
+  cmd.AddValue ("queueDisc", "Queue disc above the N10-N8 DropTail queue (none, DropTail, FqCoDel, CoDel, PIE, RED)", queueDisc);
+  cmd.AddValue ("dynamicArp", "Resolve the CSMA LAN addresses with ARP instead of filling the caches", dynamicArp);
+  cmd.AddValue ("errorModel", "Error rate model of the wireless cell (yans, table: Yans from precomputed tables)", errorModel);
+  cmd.AddValue ("pathLoss", "Path loss model of the wireless cell (friis, batched: Friis for all receivers at once, positions evaluated once per timestamp)", pathLoss);
+  cmd.AddValue ("energy", "Energy accounting of the wireless STAs (none, lazy: integrated from the PHY states at the end, model: WifiRadioEnergyModel)", energy);
+  cmd.AddValue ("wifiStandard", "Standard of the wireless cell (b: 802.11b DsssRate11Mbps, n: 802.11n HtMcs7 at 5 GHz, ac: 802.11ac VhtMcs7 at 80 MHz)", wifiStandard);
+  cmd.AddValue ("aggregation", "Frame aggregation of the n/ac cell, with block ack (none, ampdu, amsdu, both)", aggregation);
+  cmd.Parse (argc, argv);
+  NS_ABORT_MSG_UNLESS (wifiStandard != "b" || aggregation == "none", "802.11b has no aggregation");
+  NS_ABORT_MSG_UNLESS (energy == "none" || energy == "lazy" || energy == "model", "Unknown energy accounting " << energy);
 
   LogComponentEnable ("OnOffApplication", LOG_LEVEL_INFO);
   //LogComponentEnable ("UdpEchoClientApplication", LOG_LEVEL_INFO);
@@ -100,20 +140,33 @@ main (int argc, char *argv[])
    //wifi
   WifiMacHelper wifiMac;
   WifiHelper wifiHelper;
-  wifiHelper.SetStandard (WIFI_STANDARD_80211b);
 
   /* Set up Legacy Channel */
   YansWifiChannelHelper wifiChannel;
-  wifiChannel.SetPropagationDelay ("ns3::ConstantSpeedPropagationDelayModel");
-  wifiChannel.AddPropagationLoss ("ns3::FriisPropagationLossModel", "Frequency", DoubleValue (5e9));
+  if (pathLoss == "batched")
+    {
+      wifiChannel.SetPropagationDelay ("ns3::SnapshotDelayModel");
+      wifiChannel.AddPropagationLoss ("ns3::BatchedPathLossModel", "Frequency", DoubleValue (5e9));
+    }
+  else
+    {
+      wifiChannel.SetPropagationDelay ("ns3::ConstantSpeedPropagationDelayModel");
+      wifiChannel.AddPropagationLoss ("ns3::FriisPropagationLossModel", "Frequency", DoubleValue (5e9));
+    }
 
   /* Setup Physical Layer */
   YansWifiPhyHelper wifiPhy;
   wifiPhy.SetChannel (wifiChannel.Create ());
-  wifiPhy.SetErrorRateModel ("ns3::YansErrorRateModel");
-  wifiHelper.SetRemoteStationManager ("ns3::ConstantRateWifiManager",
-                                      "DataMode", StringValue ("HtMcs7"),
-                                      "ControlMode", StringValue ("HtMcs0"));
+  if (errorModel == "table")
+    {
+      wifiPhy.SetErrorRateModel ("ns3::LookupTableErrorRateModel");
+    }
+  else
+    {
+      wifiPhy.SetErrorRateModel ("ns3::YansErrorRateModel");
+    }
+  // Standard, channel and rates, the same as in wifi-aggregation-bench.cc
+  SetWifiStandard (wifiHelper, wifiPhy, wifiStandard);
 
   
   PointToPointHelper pointToPoint;
@@ -149,6 +202,26 @@ main (int argc, char *argv[])
 
   NetDeviceContainer staDevices, devices;
   staDevices = wifiHelper.Install (wifiPhy, wifiMac, wireless_sta);
+  if (wifiStandard != "b")
+    {
+      SetWifiAggregation (NetDeviceContainer (apDevice, staDevices), aggregation);
+    }
+
+  // lazy only adds up the time in each PHY state; model updates an energy
+  // source at every state change and every second
+  Ptr<LazyWifiEnergyMeter> energyMeter;
+  DeviceEnergyModelContainer energyModels;
+  if (energy == "lazy")
+    {
+      energyMeter = Create<LazyWifiEnergyMeter> ();
+      energyMeter->Install (staDevices);
+    }
+  else if (energy == "model")
+    {
+      BasicEnergySourceHelper energySource;
+      WifiRadioEnergyModelHelper radioEnergy;
+      energyModels = radioEnergy.Install (staDevices, energySource.Install (wireless_sta));
+    }
   
   
   
@@ -188,6 +261,17 @@ main (int argc, char *argv[])
   
   InternetStackHelper stack;
   stack.Install (nodes);
+
+  // Before addressing, which installs the default FqCoDel queue disc where
+  // none is set, so none and FqCoDel run the same disc (see queue-disc-type.h);
+  // compare them all with scratch/queue-disc-compare
+  TrafficControlHelper tch;
+  std::string queueDiscType = QueueDiscType (queueDisc);
+  if (!queueDiscType.empty ())
+    {
+      tch.SetRootQueueDisc (queueDiscType);
+      tch.Install (p2pd3.Get (0));//N10
+    }
   
   Ipv4AddressHelper address;
   Ipv4InterfaceContainer p2pi1,p2pi2,p2pi3,csmai;
@@ -203,6 +287,10 @@ main (int argc, char *argv[])
   //droptail
   address.SetBase ("10.1.3.0", "255.255.255.0");
   p2pi3 = address.Assign (p2pd3);
+  if (queueDisc == "DropTail")
+    {
+      tch.Uninstall (p2pd3.Get (0));
+    }
   
   //csma
   address.SetBase ("10.1.4.0", "255.255.255.0");
@@ -214,9 +302,30 @@ main (int argc, char *argv[])
   Ipv4InterfaceContainer staInterface;
   staInterface = address.Assign (staDevices);
 
+  // Fill the ARP caches of the CSMA LAN so the first packets do not wait
+  // for (or broadcast) ARP requests
+  if (!dynamicArp)
+    {
+      NeighborCacheHelper neighborCache;
+      neighborCache.PopulateNeighborCache (csmai);
+    }
+
 
   Ipv4GlobalRoutingHelper routingHelper;
-  routingHelper.PopulateRoutingTables();
+  Ptr<IncrementalGlobalRouting> spf;
+  if (routeUpdate == "incremental")
+    {
+      // SetDown/SetUp trigger the update, only affected routers are recomputed
+      spf = Create<IncrementalGlobalRouting> ();
+      spf->SetThreads (spfThreads);
+      spf->SetUpdateCallback (MakeCallback (&Routes_updated));
+      spf->Install ();
+      spf->Populate ();
+    }
+  else
+    {
+      routingHelper.PopulateRoutingTables();
+    }
   
 //   uint16_t port = 9;   // Discard port (RFC 863)
 //   OnOffHelper TcpOnoff ("ns3::TcpSocketFactory", Address (InetSocketAddress (staInterface.GetAddress(0), port)));
@@ -257,11 +366,24 @@ main (int argc, char *argv[])
 //   routingHelper.PrintRoutingTableAt (Seconds (8.5), nodes.Get(6), routingStream);
 //   routingHelper.PrintRoutingTableAt (Seconds (10.5), nodes.Get(6), routingStream);
   
-//   Simulator::Schedule (Seconds (8.0), &TearDownLink, nodes.Get(7), nodes.Get(9), 1, 0);
-//   Simulator::Schedule(Seconds(8.2), &(Ipv4GlobalRoutingHelper::RecomputeRoutingTables));
-//   Simulator::Schedule (Seconds (10.1), &Join_link, nodes.Get(7), nodes.Get(9), 1, 0);
-//   Simulator::Schedule(Seconds(10.3), &(Ipv4GlobalRoutingHelper::RecomputeRoutingTables));
 //   cout << 1 << '\n';
+  // Interfaces are resolved from the node pairs; routing losses and the
+  // time of the last one are reported per event after the run
+  Ptr<FailureSchedule> failureSchedule;
+  if (!failures.empty ())
+    {
+      failureSchedule = Create<FailureSchedule> ();
+      failureSchedule->Load (failures);
+      if (routeUpdate == "incremental")
+        {
+          failureSchedule->SetRecomputeCallback (MakeCallback (&IncrementalGlobalRouting::Flush, spf));
+        }
+      else
+        {
+          failureSchedule->SetRecomputeCallback (MakeCallback (&Recompute_routes));
+        }
+      failureSchedule->Start ();
+    }
   AnimationInterface Anim("pract.xml");
   AsciiTraceHelper ascii;
   Ptr<OutputStreamWrapper> stream = ascii.CreateFileStream ("mixed-global-routing.tr");
@@ -271,6 +393,19 @@ main (int argc, char *argv[])
   
   Simulator::Stop (Seconds(17.0));
   Simulator::Run ();
+  if (failureSchedule)
+    {
+      failureSchedule->PrintReport (std::cout);
+    }
+  if (energyMeter)
+    {
+      energyMeter->PrintReport (std::cout);
+    }
+  for (uint32_t i = 0; i < energyModels.GetN (); i++)
+    {
+      std::cout << "WifiRadioEnergyModel node " << wireless_sta.Get (i)->GetId () << ": "
+                << energyModels.Get (i)->GetTotalEnergyConsumption () << " J" << std::endl;
+    }
   Simulator::Destroy ();
   return 0;
 }
\ No newline at end of file
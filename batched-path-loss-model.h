@@ -0,0 +1,355 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Friis or log-distance path loss computed for all receivers at once.
+ *
+ * YansWifiChannel::Send asks its loss model for one receiver after the
+ * other, and FriisPropagationLossModel answers each call with two virtual
+ * GetPosition() calls (each updating the mobility model's helper) and a
+ * distance.  This model reads positions from a PositionSnapshot (see
+ * position-snapshot.h), which evaluates every tracked node once per
+ * timestamp and shares the result with SnapshotDelayModel.
+ *
+ * The first query of a transmitter at a given time computes the distance
+ * and loss to every tracked node in one pass over the snapshot arrays
+ * (built for AVX2 and plain x86-64, picked at load time); the following
+ * queries of the same transmission read the result.  Both models give the
+ * same loss as their ns-3 counterpart, with the same attributes:
+ *   Friis:       L = 10 log10(16 pi^2 d^2 SystemLoss / lambda^2), >= MinLoss
+ *   LogDistance: L = ReferenceLoss + 10 Exponent log10(d / ReferenceDistance)
+ * path-loss-bench.cc compares both against the ns-3 models.
+ *
+ * Nodes are tracked when first queried; Track() adds them up front so the
+ * first transmission already covers every receiver.
+ *
+ *   YansWifiChannelHelper wifiChannel;
+ *   wifiChannel.AddPropagationLoss("ns3::BatchedPathLossModel",
+ *                                  "Frequency", DoubleValue(5e9));
+ */
+
+#ifndef BATCHED_PATH_LOSS_MODEL_H
+#define BATCHED_PATH_LOSS_MODEL_H
+
+#include "ns3/double.h"
+#include "ns3/enum.h"
+#include "ns3/mobility-model.h"
+#include "ns3/node-container.h"
+#include "ns3/propagation-loss-model.h"
+#include "ns3/simulator.h"
+
+#include "position-snapshot.h"
+
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define BATCHED_PATH_LOSS_MODEL_CLONES __attribute__((target_clones("avx2", "default")))
+#else
+#define BATCHED_PATH_LOSS_MODEL_CLONES
+#endif
+
+namespace ns3
+{
+
+/**
+ * Path loss to all receivers per transmitter and time, from shared positions.
+ */
+class BatchedPathLossModel : public PropagationLossModel
+{
+  public:
+    /** Path loss formula. */
+    enum Formula
+    {
+        FRIIS,       //!< FriisPropagationLossModel.
+        LOG_DISTANCE //!< LogDistancePropagationLossModel.
+    };
+
+    /**
+     * \brief Get the type ID.
+     * \return the object TypeId
+     */
+    static TypeId GetTypeId();
+
+    BatchedPathLossModel();
+
+    /**
+     * \param snapshot The snapshot to read, instead of the default one.
+     */
+    void SetSnapshot(Ptr<PositionSnapshot> snapshot);
+
+    /**
+     * Track a mobility model from now on.
+     * \param model The model.
+     */
+    void Track(Ptr<MobilityModel> model);
+
+    /**
+     * Track the mobility models of nodes.
+     * \param nodes The nodes.
+     */
+    void Track(NodeContainer nodes);
+
+    /** \return the number of tracked mobility models. */
+    uint32_t GetNTracked() const;
+
+    /** \return the number of passes over all tracked models. */
+    uint64_t GetNBatches() const;
+
+  private:
+    double DoCalcRxPower(double txPowerDbm,
+                         Ptr<MobilityModel> a,
+                         Ptr<MobilityModel> b) const override;
+    int64_t DoAssignStreams(int64_t stream) override;
+    void DoDispose() override;
+
+    /**
+     * Compute the loss from a transmitter to every slot, now.
+     * \param sender The slot of the transmitter.
+     */
+    void Batch(uint32_t sender) const;
+
+    /**
+     * Squared distances from one point to n points.
+     * \param n The number of points.
+     * \param sx Transmitter x.
+     * \param sy Transmitter y.
+     * \param sz Transmitter z.
+     * \param x Positions x.
+     * \param y Positions y.
+     * \param z Positions z.
+     * \param d2 The squared distances, written.
+     */
+    BATCHED_PATH_LOSS_MODEL_CLONES static void Distances(std::size_t n,
+                                                         double sx,
+                                                         double sy,
+                                                         double sz,
+                                                         const double* x,
+                                                         const double* y,
+                                                         const double* z,
+                                                         double* d2);
+
+    Formula m_formula;          //!< Path loss formula.
+    double m_frequency;         //!< Friis carrier frequency in Hz.
+    double m_systemLoss;        //!< Friis system loss, linear.
+    double m_minLoss;           //!< Friis minimum loss in dB.
+    double m_exponent;          //!< Log-distance exponent.
+    double m_referenceDistance; //!< Log-distance reference distance in m.
+    double m_referenceLoss;     //!< Log-distance loss at the reference distance in dB.
+
+    Ptr<PositionSnapshot> m_snapshot; //!< The positions.
+
+    mutable std::vector<double> m_loss; //!< Squared distance, then loss in dB, per slot.
+    mutable uint32_t m_sender;          //!< Transmitter of m_loss.
+    mutable uint64_t m_version;         //!< Snapshot version of m_loss.
+    mutable bool m_valid;               //!< Whether m_loss is up to date.
+    mutable uint64_t m_batches;         //!< Passes over all slots.
+};
+
+NS_OBJECT_ENSURE_REGISTERED(BatchedPathLossModel);
+
+TypeId
+BatchedPathLossModel::GetTypeId()
+{
+    static TypeId tid =
+        TypeId("ns3::BatchedPathLossModel")
+            .SetParent<PropagationLossModel>()
+            .SetGroupName("Propagation")
+            .AddConstructor<BatchedPathLossModel>()
+            .AddAttribute("Formula",
+                          "Path loss formula",
+                          EnumValue(FRIIS),
+                          MakeEnumAccessor(&BatchedPathLossModel::m_formula),
+                          MakeEnumChecker(FRIIS, "Friis", LOG_DISTANCE, "LogDistance"))
+            .AddAttribute("Frequency",
+                          "Friis: carrier frequency in Hz",
+                          DoubleValue(5.150e9),
+                          MakeDoubleAccessor(&BatchedPathLossModel::m_frequency),
+                          MakeDoubleChecker<double>(1))
+            .AddAttribute("SystemLoss",
+                          "Friis: system loss, linear",
+                          DoubleValue(1.0),
+                          MakeDoubleAccessor(&BatchedPathLossModel::m_systemLoss),
+                          MakeDoubleChecker<double>(0))
+            .AddAttribute("MinLoss",
+                          "Friis: minimum loss in dB, returned at or near zero distance",
+                          DoubleValue(0.0),
+                          MakeDoubleAccessor(&BatchedPathLossModel::m_minLoss),
+                          MakeDoubleChecker<double>())
+            .AddAttribute("Exponent",
+                          "LogDistance: path loss exponent",
+                          DoubleValue(3.0),
+                          MakeDoubleAccessor(&BatchedPathLossModel::m_exponent),
+                          MakeDoubleChecker<double>())
+            .AddAttribute("ReferenceDistance",
+                          "LogDistance: distance of ReferenceLoss in m",
+                          DoubleValue(1.0),
+                          MakeDoubleAccessor(&BatchedPathLossModel::m_referenceDistance),
+                          MakeDoubleChecker<double>(0))
+            .AddAttribute("ReferenceLoss",
+                          "LogDistance: loss at ReferenceDistance in dB",
+                          DoubleValue(46.6777),
+                          MakeDoubleAccessor(&BatchedPathLossModel::m_referenceLoss),
+                          MakeDoubleChecker<double>());
+    return tid;
+}
+
+BatchedPathLossModel::BatchedPathLossModel()
+    : m_formula(FRIIS),
+      m_frequency(5.150e9),
+      m_systemLoss(1.0),
+      m_minLoss(0.0),
+      m_exponent(3.0),
+      m_referenceDistance(1.0),
+      m_referenceLoss(46.6777),
+      m_snapshot(PositionSnapshot::GetDefault()),
+      m_sender(0),
+      m_version(0),
+      m_valid(false),
+      m_batches(0)
+{
+}
+
+void
+BatchedPathLossModel::SetSnapshot(Ptr<PositionSnapshot> snapshot)
+{
+    m_snapshot = snapshot;
+    m_valid = false;
+}
+
+void
+BatchedPathLossModel::Track(Ptr<MobilityModel> model)
+{
+    m_snapshot->Track(model);
+}
+
+void
+BatchedPathLossModel::Track(NodeContainer nodes)
+{
+    m_snapshot->Track(nodes);
+}
+
+uint32_t
+BatchedPathLossModel::GetNTracked() const
+{
+    return m_snapshot->GetN();
+}
+
+uint64_t
+BatchedPathLossModel::GetNBatches() const
+{
+    return m_batches;
+}
+
+void
+BatchedPathLossModel::Distances(std::size_t n,
+                                double sx,
+                                double sy,
+                                double sz,
+                                const double* x,
+                                const double* y,
+                                const double* z,
+                                double* d2)
+{
+    for (std::size_t i = 0; i < n; i++)
+    {
+        double dx = x[i] - sx;
+        double dy = y[i] - sy;
+        double dz = z[i] - sz;
+        d2[i] = dx * dx + dy * dy + dz * dz;
+    }
+}
+
+void
+BatchedPathLossModel::Batch(uint32_t sender) const
+{
+    const double* x = m_snapshot->GetX();
+    const double* y = m_snapshot->GetY();
+    const double* z = m_snapshot->GetZ();
+    std::size_t n = m_snapshot->GetN();
+    m_loss.resize(n);
+    Distances(n, x[sender], y[sender], z[sender], x, y, z, m_loss.data());
+
+    // Both formulas are offset + slope * log10(d^2) above a clamp distance
+    double offset;
+    double slope;
+    double clamp2;
+    double clampLoss;
+    double floor;
+    if (m_formula == FRIIS)
+    {
+        double lambda = 299792458.0 / m_frequency;
+        offset = 10 * std::log10(16 * M_PI * M_PI * m_systemLoss / (lambda * lambda));
+        slope = 10;
+        clamp2 = 0;
+        clampLoss = m_minLoss;
+        floor = m_minLoss;
+    }
+    else
+    {
+        clamp2 = m_referenceDistance * m_referenceDistance;
+        slope = 5 * m_exponent;
+        offset = m_referenceLoss - slope * std::log10(clamp2);
+        clampLoss = m_referenceLoss;
+        floor = -std::numeric_limits<double>::infinity();
+    }
+    for (std::size_t i = 0; i < n; i++)
+    {
+        double d2 = m_loss[i];
+        m_loss[i] = d2 <= clamp2 ? clampLoss : std::max(offset + slope * std::log10(d2), floor);
+    }
+    m_sender = sender;
+    m_version = m_snapshot->GetVersion();
+    m_valid = true;
+    m_batches++;
+}
+
+double
+BatchedPathLossModel::DoCalcRxPower(double txPowerDbm,
+                                    Ptr<MobilityModel> a,
+                                    Ptr<MobilityModel> b) const
+{
+    uint32_t sender = m_snapshot->Track(a);
+    uint32_t receiver = m_snapshot->Track(b);
+    m_snapshot->Update();
+    if (!m_valid || sender != m_sender || m_version != m_snapshot->GetVersion())
+    {
+        Batch(sender);
+        // Checking every receiver would cost the GetPosition() calls the
+        // batch saves, so only the one that triggered it is checked.
+        NS_ASSERT_MSG(CalculateDistance(m_snapshot->GetPosition(receiver), b->GetPosition()) < 1e-6,
+                      "BatchedPathLossModel: " << b->GetInstanceTypeId().GetName()
+                                               << " moved off its straight line");
+    }
+    return txPowerDbm - m_loss[receiver];
+}
+
+int64_t
+BatchedPathLossModel::DoAssignStreams(int64_t stream)
+{
+    return 0;
+}
+
+void
+BatchedPathLossModel::DoDispose()
+{
+    m_snapshot = nullptr;
+    PropagationLossModel::DoDispose();
+}
+
+} // namespace ns3
+
+#endif /* BATCHED_PATH_LOSS_MODEL_H */
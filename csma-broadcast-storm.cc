@@ -0,0 +1,144 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Cost of UDP broadcast fan-out on a large CSMA LAN.
+ *
+ * The l4q1b LAN scaled up: --devices nodes share one CSMA channel, and
+ * --senders of them broadcast --rate of --size byte UDP packets to
+ * 255.255.255.255 for --duration simulated seconds, received by a
+ * PacketSink on every node.  Each frame is delivered to every other device,
+ * so the work grows with senders x devices.
+ *
+ * CsmaChannel hands every receiver Packet::Copy() of the frame.  That copy
+ * only takes references to the frame's buffer, tags and metadata; the
+ * bytes are copied when a receiver writes to them, which the receive path
+ * does not do (it removes headers by moving offsets).  So delivery is
+ * already copy-on-write, and what remains per receiver is the Packet object
+ * and its trace and socket work, which is what this measures.  The
+ * senders are OnOffApplications; their payloads are ns-3 zero areas, so no
+ * payload bytes are allocated to begin with.
+ *
+ * One line is printed:
+ *   devices,senders,frames_sent,deliveries,wall_s,us_per_delivery,max_rss_kb
+ *
+ *   ./ns3 run "scratch/csma-broadcast-storm --devices=4"
+ *   ./ns3 run "scratch/csma-broadcast-storm --devices=500 --senders=10"
+ */
+
+#include "ns3/applications-module.h"
+#include "ns3/core-module.h"
+#include "ns3/csma-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/network-module.h"
+
+#include <sys/resource.h>
+
+#include <chrono>
+#include <iostream>
+#include <string>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE("CsmaBroadcastStorm");
+
+static uint64_t g_sent = 0;      //!< Frames sent by the senders.
+static uint64_t g_delivered = 0; //!< Frames received by a device.
+
+/**
+ * Count a sent frame.
+ * \param packet The frame.
+ */
+static void
+Sent(Ptr<const Packet> packet)
+{
+    g_sent++;
+}
+
+/**
+ * Count a delivered frame.
+ * \param packet The frame.
+ */
+static void
+Delivered(Ptr<const Packet> packet)
+{
+    g_delivered++;
+}
+
+int
+main(int argc, char* argv[])
+{
+    uint32_t devices = 200;
+    uint32_t senders = 1;
+    std::string rate("500kb/s");
+    uint32_t size = 512;
+    double duration = 5;
+
+    CommandLine cmd(__FILE__);
+    cmd.AddValue("devices", "Devices on the LAN", devices);
+    cmd.AddValue("senders", "Devices that broadcast", senders);
+    cmd.AddValue("rate", "Broadcast rate of each sender", rate);
+    cmd.AddValue("size", "Payload size in bytes", size);
+    cmd.AddValue("duration", "Simulated seconds of traffic", duration);
+    cmd.Parse(argc, argv);
+
+    NS_ABORT_MSG_UNLESS(senders >= 1 && senders <= devices, "Need 1 to --devices senders");
+
+    NodeContainer nodes;
+    nodes.Create(devices);
+    CsmaHelper csma;
+    csma.SetChannelAttribute("DataRate", DataRateValue(DataRate("1Gbps")));
+    csma.SetChannelAttribute("Delay", TimeValue(MicroSeconds(1)));
+    NetDeviceContainer lan = csma.Install(nodes);
+    InternetStackHelper internet;
+    internet.Install(nodes);
+    Ipv4AddressHelper ipv4;
+    ipv4.SetBase("10.0.0.0", "255.255.0.0");
+    ipv4.Assign(lan);
+
+    uint16_t port = 9;
+    InetSocketAddress broadcast(Ipv4Address("255.255.255.255"), port);
+    OnOffHelper onoff("ns3::UdpSocketFactory", broadcast);
+    onoff.SetConstantRate(DataRate(rate), size);
+    Ptr<UniformRandomVariable> jitter = CreateObject<UniformRandomVariable>();
+    for (uint32_t i = 0; i < senders; i++)
+    {
+        Ptr<Node> node = nodes.Get(i * devices / senders);
+        ApplicationContainer app = onoff.Install(node);
+        app.Get(0)->TraceConnectWithoutContext("Tx", MakeCallback(&Sent));
+        app.Start(Seconds(1 + jitter->GetValue(0, 0.01)));
+        app.Stop(Seconds(1 + duration));
+    }
+    PacketSinkHelper sink("ns3::UdpSocketFactory", InetSocketAddress(Ipv4Address::GetAny(), port));
+    sink.Install(nodes);
+    for (uint32_t i = 0; i < lan.GetN(); i++)
+    {
+        lan.Get(i)->TraceConnectWithoutContext("MacRx", MakeCallback(&Delivered));
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    Simulator::Stop(Seconds(1.1 + duration));
+    Simulator::Run();
+    std::chrono::duration<double> wall = std::chrono::steady_clock::now() - start;
+
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    std::cout << devices << "," << senders << "," << g_sent << "," << g_delivered << ","
+              << wall.count() << "," << (g_delivered ? wall.count() * 1e6 / g_delivered : 0.0)
+              << "," << usage.ru_maxrss << std::endl;
+
+    Simulator::Destroy();
+    return 0;
+}
@@ -0,0 +1,144 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Accuracy and speed of LookupTableErrorRateModel against
+ * YansErrorRateModel.
+ *
+ * For the 802.11b DSSS, 802.11a/g OFDM and 802.11n HT modes used by the
+ * wireless programs, the chunk success rate of both models is compared on a
+ * fine SNR sweep (off the table grid) for several frame sizes, and both are
+ * timed on --evaluations random SNRs.
+ *
+ * One line is printed per mode, then the worst error:
+ *   mode,max_abs_error,reference_ns,table_ns,speedup
+ *
+ *   ./ns3 run "scratch/error-rate-table-check"
+ *   ./ns3 run "scratch/error-rate-table-check --step=0.1"
+ */
+
+#include "ns3/core-module.h"
+#include "ns3/wifi-module.h"
+
+#include "lookup-table-error-rate-model.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE("ErrorRateTableCheck");
+
+/**
+ * Time the chunk success rate of a model.
+ * \param model The model.
+ * \param mode The mode.
+ * \param txVector The TXVECTOR.
+ * \param snrs The SNRs to evaluate, linear.
+ * \param evaluations The number of evaluations.
+ * \return the mean time of one evaluation in ns.
+ */
+static double
+TimeModel(Ptr<ErrorRateModel> model,
+          WifiMode mode,
+          const WifiTxVector& txVector,
+          const std::vector<double>& snrs,
+          uint32_t evaluations)
+{
+    volatile double sink = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < evaluations; i++)
+    {
+        sink = sink + model->GetChunkSuccessRate(mode, txVector, snrs[i % snrs.size()], 8000);
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() * 1e9 / evaluations;
+}
+
+int
+main(int argc, char* argv[])
+{
+    double step = 0.05;
+    uint32_t evaluations = 1000000;
+
+    CommandLine cmd(__FILE__);
+    cmd.AddValue("step", "SNR step of the tables in dB", step);
+    cmd.AddValue("evaluations", "Timed evaluations per mode and model", evaluations);
+    cmd.Parse(argc, argv);
+
+    struct Case
+    {
+        std::string mode;      //!< Mode name.
+        WifiPreamble preamble; //!< Preamble.
+        uint16_t width;        //!< Channel width in MHz.
+    };
+
+    std::vector<Case> cases;
+    for (std::string mode : {"DsssRate1Mbps", "DsssRate2Mbps", "DsssRate5_5Mbps", "DsssRate11Mbps"})
+    {
+        cases.push_back({mode, WIFI_PREAMBLE_LONG, 22});
+    }
+    for (uint32_t rate : {6, 9, 12, 18, 24, 36, 48, 54})
+    {
+        cases.push_back({"OfdmRate" + std::to_string(rate) + "Mbps", WIFI_PREAMBLE_LONG, 20});
+    }
+    for (uint32_t mcs = 0; mcs < 8; mcs++)
+    {
+        cases.push_back({"HtMcs" + std::to_string(mcs), WIFI_PREAMBLE_HT_MF, 20});
+    }
+
+    Ptr<UniformRandomVariable> random = CreateObject<UniformRandomVariable>();
+    std::vector<double> snrs;
+    for (uint32_t i = 0; i < 4096; i++)
+    {
+        snrs.push_back(std::pow(10.0, random->GetValue(-5, 35) / 10));
+    }
+
+    double worst = 0;
+    std::cout << "mode,max_abs_error,reference_ns,table_ns,speedup" << std::endl;
+    for (const auto& c : cases)
+    {
+        WifiMode mode(c.mode);
+        WifiTxVector txVector(mode, 0, c.preamble, 800, 1, 1, 0, c.width, false);
+        Ptr<ErrorRateModel> reference = CreateObject<YansErrorRateModel>();
+        Ptr<LookupTableErrorRateModel> table = CreateObjectWithAttributes<LookupTableErrorRateModel>(
+            "StepDb",
+            DoubleValue(step));
+
+        double error = 0;
+        for (double db = -5; db < 35; db += 0.0137)
+        {
+            double snr = std::pow(10.0, db / 10);
+            for (uint64_t nbits : {112, 800, 12000, 524280})
+            {
+                double expected = reference->GetChunkSuccessRate(mode, txVector, snr, nbits);
+                double actual = table->GetChunkSuccessRate(mode, txVector, snr, nbits);
+                error = std::max(error, std::abs(expected - actual));
+            }
+        }
+        worst = std::max(worst, error);
+
+        double referenceNs = TimeModel(reference, mode, txVector, snrs, evaluations);
+        double tableNs = TimeModel(table, mode, txVector, snrs, evaluations);
+        std::cout << c.mode << "," << error << "," << referenceNs << "," << tableNs << ","
+                  << referenceNs / tableNs << std::endl;
+    }
+    std::cout << "# worst absolute error of the chunk success rate: " << worst << std::endl;
+    return 0;
+}
@@ -0,0 +1,404 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Link failures and repairs read from a schedule, with their cost in
+ * routing work and lost traffic.
+ *
+ * The schedule has one event per line, '#' starts a comment:
+ *
+ *   <time in s> <node id> <node id> down|up
+ *
+ * The interfaces are found by looking for the channel both nodes are
+ * attached to, so no interface index is written by hand.  Each event sets
+ * the Ipv4 interfaces at both ends down or up and then runs the recompute
+ * callback (e.g. Ipv4GlobalRoutingHelper::RecomputeRoutingTables, or
+ * IncrementalGlobalRouting::Flush), timing it in wall-clock time.
+ *
+ * From each event until the next one, packets lost for routing reasons are
+ * charged to the event:
+ *
+ * - dropped by the IP layer of any node (no route, interface down, TTL
+ *   expired, route error)
+ * - UDP sends that fail in RouteOutput, which drops nothing and fires no
+ *   trace; a passive protocol at the lowest priority of every node's
+ *   Ipv4ListRouting sees the lookups no other protocol answered.  OnOff
+ *   retries the packet at its next send time, so each failed attempt counts.
+ *
+ * There is no direct measure of when traffic flows again, so the report
+ * gives the time of the last loss after the event, an upper bound of its
+ * time to reroute.  The cost per event is O(1) plus the recomputation, so
+ * it works on generated topologies of any size.
+ *
+ *   Ptr<FailureSchedule> failures = Create<FailureSchedule>();
+ *   failures->Load("failures.txt");
+ *   failures->SetRecomputeCallback(MakeCallback(&Ipv4GlobalRoutingHelper::RecomputeRoutingTables));
+ *   failures->Start();
+ *   Simulator::Run();
+ *   failures->PrintReport(std::cout);
+ */
+
+#ifndef FAILURE_SCHEDULE_H
+#define FAILURE_SCHEDULE_H
+
+#include "ns3/abort.h"
+#include "ns3/callback.h"
+#include "ns3/channel.h"
+#include "ns3/ipv4-l3-protocol.h"
+#include "ns3/ipv4-list-routing.h"
+#include "ns3/ipv4-routing-protocol.h"
+#include "ns3/net-device-container.h"
+#include "ns3/node-list.h"
+#include "ns3/node.h"
+#include "ns3/simple-ref-count.h"
+#include "ns3/simulator.h"
+#include "ns3/udp-l4-protocol.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <limits>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * Applies scheduled link failures and measures their effect.
+ */
+class FailureSchedule : public SimpleRefCount<FailureSchedule>
+{
+  public:
+    /** A scheduled change and what it cost. */
+    struct Event
+    {
+        Time time;                  //!< When the link changes.
+        uint32_t nodeA;             //!< One end.
+        uint32_t nodeB;             //!< The other end.
+        bool up;                    //!< The new state.
+        NetDeviceContainer devices; //!< Devices at both ends, once started.
+        double recomputeSeconds;    //!< Wall-clock time of the recompute callback.
+        uint64_t lost;              //!< Routing losses charged to the event.
+        Time lastLoss;              //!< Time of the last of them.
+        std::string origin;         //!< "<file>:<line>" if loaded, empty if added.
+    };
+
+    /**
+     * Read events from a schedule file.
+     * \param filename The file.
+     */
+    void Load(const std::string& filename);
+
+    /**
+     * Add an event.
+     * \param time When the link changes.
+     * \param nodeA One end.
+     * \param nodeB The other end.
+     * \param up The new state.
+     */
+    void Add(Time time, uint32_t nodeA, uint32_t nodeB, bool up);
+
+    /**
+     * \param cb Called after every event to update the routes.
+     */
+    void SetRecomputeCallback(Callback<void> cb);
+
+    /**
+     * Resolve the links, schedule the events and start counting losses.
+     * Call once the network is built and addressed, and no later than the
+     * first event; an event in the past aborts, naming its schedule line.
+     */
+    void Start();
+
+    /** \return the events, in time order once started. */
+    const std::vector<Event>& GetEvents() const;
+
+    /**
+     * Print one line per event:
+     * time_s,action,node_a,node_b,recompute_ms,lost,last_loss_s
+     * where last_loss_s is the time from the event to its last loss.
+     * \param os The output stream.
+     */
+    void PrintReport(std::ostream& os) const;
+
+  private:
+    /** Passive routing protocol that sees the failed route lookups. */
+    class NoRouteHook : public Ipv4RoutingProtocol
+    {
+      public:
+        /**
+         * \param schedule The owner.
+         */
+        NoRouteHook(FailureSchedule* schedule)
+            : m_schedule(schedule)
+        {
+        }
+
+        Ptr<Ipv4Route> RouteOutput(Ptr<Packet> p,
+                                   const Ipv4Header& header,
+                                   Ptr<NetDevice> oif,
+                                   Socket::SocketErrno& sockerr) override
+        {
+            // TCP and ICMP sends without a route end in a DROP_NO_ROUTE.
+            if (header.GetProtocol() == UdpL4Protocol::PROT_NUMBER)
+            {
+                m_schedule->Lost();
+            }
+            sockerr = Socket::ERROR_NOROUTETOHOST;
+            return nullptr;
+        }
+
+        bool RouteInput(Ptr<const Packet> p,
+                        const Ipv4Header& header,
+                        Ptr<const NetDevice> idev,
+                        const UnicastForwardCallback& ucb,
+                        const MulticastForwardCallback& mcb,
+                        const LocalDeliverCallback& lcb,
+                        const ErrorCallback& ecb) override
+        {
+            return false;
+        }
+
+        void NotifyInterfaceUp(uint32_t interface) override
+        {
+        }
+
+        void NotifyInterfaceDown(uint32_t interface) override
+        {
+        }
+
+        void NotifyAddAddress(uint32_t interface, Ipv4InterfaceAddress address) override
+        {
+        }
+
+        void NotifyRemoveAddress(uint32_t interface, Ipv4InterfaceAddress address) override
+        {
+        }
+
+        void SetIpv4(Ptr<Ipv4> ipv4) override
+        {
+        }
+
+        void PrintRoutingTable(Ptr<OutputStreamWrapper> stream,
+                               Time::Unit unit = Time::S) const override
+        {
+        }
+
+      private:
+        FailureSchedule* m_schedule; //!< The owner.
+    };
+
+    /**
+     * Apply an event.
+     * \param index The event.
+     */
+    void Apply(std::size_t index);
+
+    /**
+     * Ipv4L3Protocol drop trace sink.
+     * \param schedule The owner.
+     * \param header The IPv4 header.
+     * \param packet The packet.
+     * \param reason Why it was dropped.
+     * \param ipv4 The stack.
+     * \param interface The interface.
+     */
+    static void Drop(FailureSchedule* schedule,
+                     const Ipv4Header& header,
+                     Ptr<const Packet> packet,
+                     Ipv4L3Protocol::DropReason reason,
+                     Ptr<Ipv4> ipv4,
+                     uint32_t interface);
+
+    /** Charge a loss to the current event. */
+    void Lost();
+
+    std::vector<Event> m_events; //!< All events.
+    Callback<void> m_recompute;  //!< Route update after each event.
+    std::size_t m_current = 0;   //!< Events applied so far.
+};
+
+void
+FailureSchedule::Load(const std::string& filename)
+{
+    std::ifstream in(filename);
+    NS_ABORT_MSG_UNLESS(in, "Cannot open failure schedule " << filename);
+    std::string text;
+    for (uint32_t line = 1; std::getline(in, text); line++)
+    {
+        std::istringstream words(text.substr(0, text.find('#')));
+        double seconds;
+        uint32_t a;
+        uint32_t b;
+        std::string action;
+        if (!(words >> seconds))
+        {
+            continue;
+        }
+        NS_ABORT_MSG_UNLESS((words >> a >> b >> action) && (action == "down" || action == "up"),
+                            filename << ":" << line << ": expected <time> <node> <node> down|up");
+        Add(Seconds(seconds), a, b, action == "up");
+        m_events.back().origin = filename + ":" + std::to_string(line);
+    }
+}
+
+void
+FailureSchedule::Add(Time time, uint32_t nodeA, uint32_t nodeB, bool up)
+{
+    m_events.push_back({time, nodeA, nodeB, up, NetDeviceContainer(), 0, 0, Time(), ""});
+}
+
+void
+FailureSchedule::SetRecomputeCallback(Callback<void> cb)
+{
+    m_recompute = cb;
+}
+
+void
+FailureSchedule::Start()
+{
+    std::stable_sort(m_events.begin(), m_events.end(), [](const Event& x, const Event& y) {
+        return x.time < y.time;
+    });
+    for (std::size_t i = 0; i < m_events.size(); i++)
+    {
+        Event& event = m_events[i];
+        std::string where = event.origin.empty() ? "Failure schedule" : event.origin;
+        NS_ABORT_MSG_IF(event.time < Simulator::Now(),
+                        where << ": event at " << event.time.As(Time::S)
+                              << " is before the schedule starts at "
+                              << Simulator::Now().As(Time::S));
+        NS_ABORT_MSG_UNLESS(event.nodeA < NodeList::GetNNodes() &&
+                                event.nodeB < NodeList::GetNNodes(),
+                            where << ": no node " << std::max(event.nodeA, event.nodeB));
+        Ptr<Node> a = NodeList::GetNode(event.nodeA);
+        for (uint32_t d = 0; d < a->GetNDevices() && event.devices.GetN() == 0; d++)
+        {
+            Ptr<Channel> channel = a->GetDevice(d)->GetChannel();
+            for (std::size_t j = 0; channel && j < channel->GetNDevices(); j++)
+            {
+                if (channel->GetDevice(j)->GetNode()->GetId() == event.nodeB)
+                {
+                    event.devices.Add(a->GetDevice(d));
+                    event.devices.Add(channel->GetDevice(j));
+                    break;
+                }
+            }
+        }
+        NS_ABORT_MSG_IF(event.devices.GetN() == 0,
+                        where << ": nodes " << event.nodeA << " and " << event.nodeB
+                              << " share no channel");
+        Simulator::Schedule(event.time - Simulator::Now(), &FailureSchedule::Apply, this, i);
+    }
+
+    for (uint32_t n = 0; n < NodeList::GetNNodes(); n++)
+    {
+        Ptr<Ipv4L3Protocol> ipv4 = NodeList::GetNode(n)->GetObject<Ipv4L3Protocol>();
+        if (!ipv4)
+        {
+            continue;
+        }
+        ipv4->TraceConnectWithoutContext("Drop", MakeBoundCallback(&FailureSchedule::Drop, this));
+        Ptr<Ipv4ListRouting> list = DynamicCast<Ipv4ListRouting>(ipv4->GetRoutingProtocol());
+        if (list)
+        {
+            list->AddRoutingProtocol(CreateObject<NoRouteHook>(this),
+                                     std::numeric_limits<int16_t>::min());
+        }
+    }
+}
+
+void
+FailureSchedule::Apply(std::size_t index)
+{
+    Event& event = m_events[index];
+    for (uint32_t i = 0; i < event.devices.GetN(); i++)
+    {
+        Ptr<Ipv4> ipv4 = event.devices.Get(i)->GetNode()->GetObject<Ipv4>();
+        int32_t ifIndex = ipv4->GetInterfaceForDevice(event.devices.Get(i));
+        if (ifIndex < 0)
+        {
+            continue;
+        }
+        if (event.up)
+        {
+            ipv4->SetUp(ifIndex);
+        }
+        else
+        {
+            ipv4->SetDown(ifIndex);
+        }
+    }
+    m_current = index + 1;
+    if (!m_recompute.IsNull())
+    {
+        auto start = std::chrono::steady_clock::now();
+        m_recompute();
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        event.recomputeSeconds = elapsed.count();
+    }
+}
+
+void
+FailureSchedule::Drop(FailureSchedule* schedule,
+                      const Ipv4Header& header,
+                      Ptr<const Packet> packet,
+                      Ipv4L3Protocol::DropReason reason,
+                      Ptr<Ipv4> ipv4,
+                      uint32_t interface)
+{
+    if (reason == Ipv4L3Protocol::DROP_NO_ROUTE || reason == Ipv4L3Protocol::DROP_INTERFACE_DOWN ||
+        reason == Ipv4L3Protocol::DROP_TTL_EXPIRED || reason == Ipv4L3Protocol::DROP_ROUTE_ERROR)
+    {
+        schedule->Lost();
+    }
+}
+
+void
+FailureSchedule::Lost()
+{
+    if (m_current == 0)
+    {
+        return;
+    }
+    Event& event = m_events[m_current - 1];
+    event.lost++;
+    event.lastLoss = Simulator::Now();
+}
+
+const std::vector<FailureSchedule::Event>&
+FailureSchedule::GetEvents() const
+{
+    return m_events;
+}
+
+void
+FailureSchedule::PrintReport(std::ostream& os) const
+{
+    os << "time_s,action,node_a,node_b,recompute_ms,lost,last_loss_s" << std::endl;
+    for (const auto& event : m_events)
+    {
+        os << event.time.GetSeconds() << "," << (event.up ? "up" : "down") << "," << event.nodeA
+           << "," << event.nodeB << "," << event.recomputeSeconds * 1e3 << "," << event.lost << ","
+           << (event.lost ? (event.lastLoss - event.time).GetSeconds() : 0.0) << std::endl;
+    }
+}
+
+} // namespace ns3
+
+#endif /* FAILURE_SCHEDULE_H */
@@ -0,0 +1,185 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Cost of reacting to link flaps with global routing.
+ *
+ * A rows x cols grid of routers is joined by point-to-point links (one /30
+ * per link).  After the routing tables are populated, --flaps randomly
+ * chosen links are taken down and brought back up, one per simulated
+ * second.  With --mode=full every change is followed by
+ * Ipv4GlobalRoutingHelper::RecomputeRoutingTables(); with
+ * --mode=incremental IncrementalGlobalRouting reacts to the interface
+ * events and only recomputes the routers whose shortest-path tree changed.
+ * In incremental mode --threads spreads the SPF runs of the initial
+ * population (and of large updates) over several cores.
+ *
+ * One line is printed:
+ *   mode,threads,routers,links,populate_ms,updates,mean_update_ms,mean_routers_per_update
+ *
+ *   ./ns3 run "scratch/global-routing-bench --rows=30 --cols=30 --mode=full"
+ *   ./ns3 run "scratch/global-routing-bench --rows=30 --cols=30 --mode=incremental"
+ *   ./ns3 run "scratch/global-routing-bench --rows=100 --cols=100 --flaps=0 --threads=0"
+ */
+
+#include "ns3/core-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/network-module.h"
+#include "ns3/point-to-point-module.h"
+
+#include "incremental-global-routing.h"
+
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE("GlobalRoutingBench");
+
+static uint32_t g_updates = 0;        //!< Number of route updates.
+static double g_updateSeconds = 0;    //!< Wall-clock time spent updating routes.
+static uint64_t g_routersUpdated = 0; //!< Sum of routers recomputed per update.
+
+/**
+ * Account for one route update.
+ * \param routers The number of routers recomputed.
+ * \param seconds The wall-clock time the update took.
+ */
+static void
+RecordUpdate(uint32_t routers, double seconds)
+{
+    g_updates++;
+    g_updateSeconds += seconds;
+    g_routersUpdated += routers;
+}
+
+/**
+ * Change the state of both ends of a link.
+ * \param link The devices at both ends.
+ * \param up The new state.
+ * \param recompute Whether to run a timed full recomputation afterwards.
+ */
+static void
+SetLink(NetDeviceContainer link, bool up, bool recompute)
+{
+    for (uint32_t i = 0; i < link.GetN(); i++)
+    {
+        Ptr<Ipv4> ipv4 = link.Get(i)->GetNode()->GetObject<Ipv4>();
+        uint32_t ifIndex = ipv4->GetInterfaceForDevice(link.Get(i));
+        if (up)
+        {
+            ipv4->SetUp(ifIndex);
+        }
+        else
+        {
+            ipv4->SetDown(ifIndex);
+        }
+    }
+    if (recompute)
+    {
+        auto start = std::chrono::steady_clock::now();
+        Ipv4GlobalRoutingHelper::RecomputeRoutingTables();
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        RecordUpdate(NodeList::GetNNodes(), elapsed.count());
+    }
+}
+
+int
+main(int argc, char* argv[])
+{
+    uint32_t rows = 20;
+    uint32_t cols = 20;
+    uint32_t flaps = 20;
+    uint32_t threads = 1;
+    std::string mode("incremental");
+
+    CommandLine cmd(__FILE__);
+    cmd.AddValue("rows", "Rows of the router grid", rows);
+    cmd.AddValue("cols", "Columns of the router grid", cols);
+    cmd.AddValue("flaps", "Number of links taken down and up again", flaps);
+    cmd.AddValue("mode", "Route update on link events (full, incremental)", mode);
+    cmd.AddValue("threads", "SPF threads in incremental mode, 0 for all cores", threads);
+    cmd.Parse(argc, argv);
+
+    NS_ABORT_MSG_UNLESS(mode == "full" || mode == "incremental", "Unknown mode " << mode);
+
+    NodeContainer routers;
+    routers.Create(rows * cols);
+
+    InternetStackHelper internet;
+    internet.Install(routers);
+
+    PointToPointHelper p2p;
+    p2p.SetDeviceAttribute("DataRate", StringValue("1Gbps"));
+    p2p.SetChannelAttribute("Delay", StringValue("1ms"));
+
+    Ipv4AddressHelper ipv4;
+    ipv4.SetBase("10.0.0.0", "255.255.255.252");
+    std::vector<NetDeviceContainer> links;
+    for (uint32_t r = 0; r < rows; r++)
+    {
+        for (uint32_t c = 0; c < cols; c++)
+        {
+            uint32_t n = r * cols + c;
+            if (c + 1 < cols)
+            {
+                links.push_back(p2p.Install(routers.Get(n), routers.Get(n + 1)));
+            }
+            if (r + 1 < rows)
+            {
+                links.push_back(p2p.Install(routers.Get(n), routers.Get(n + cols)));
+            }
+        }
+    }
+    for (const auto& link : links)
+    {
+        ipv4.Assign(link);
+        ipv4.NewNetwork();
+    }
+
+    Ptr<IncrementalGlobalRouting> spf;
+    auto start = std::chrono::steady_clock::now();
+    if (mode == "incremental")
+    {
+        spf = Create<IncrementalGlobalRouting>();
+        spf->SetThreads(threads);
+        spf->SetUpdateCallback(MakeCallback(&RecordUpdate));
+        spf->Install();
+        spf->Populate();
+    }
+    else
+    {
+        Ipv4GlobalRoutingHelper::PopulateRoutingTables();
+    }
+    std::chrono::duration<double> populate = std::chrono::steady_clock::now() - start;
+
+    Ptr<UniformRandomVariable> pick = CreateObject<UniformRandomVariable>();
+    for (uint32_t i = 0; i < flaps; i++)
+    {
+        NetDeviceContainer link = links[pick->GetInteger(0, links.size() - 1)];
+        Simulator::Schedule(Seconds(i + 1.0), &SetLink, link, false, mode == "full");
+        Simulator::Schedule(Seconds(i + 1.5), &SetLink, link, true, mode == "full");
+    }
+
+    Simulator::Run();
+    Simulator::Destroy();
+
+    std::cout << mode << "," << (mode == "full" ? 1 : threads) << "," << rows * cols << "," << links.size() << ","
+              << populate.count() * 1e3 << "," << g_updates << ","
+              << (g_updates ? g_updateSeconds * 1e3 / g_updates : 0.0) << ","
+              << (g_updates ? double(g_routersUpdated) / g_updates : 0.0) << std::endl;
+    return 0;
+}
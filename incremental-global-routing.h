@@ -0,0 +1,738 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Incremental shortest-path routing for the global routing scratch programs.
+ *
+ * Ipv4GlobalRoutingHelper::RecomputeRoutingTables() throws away every route
+ * and runs one Dijkstra per router, whatever changed.  This helper keeps its
+ * own link-state graph (routers and the networks their interfaces attach
+ * to, OSPF style) and writes its results into each node's
+ * Ipv4GlobalRouting.  When an interface goes down or up only the routers
+ * whose shortest paths are affected are recomputed:
+ *
+ * - down: routers with a shortest path over the router<->network edge of
+ *         that interface
+ * - up:   routers for which the new edge gives a strictly shorter distance
+ *
+ * The trees are not kept (one per router is O(N^2) memory, gigabytes for
+ * 10k routers).  Instead each change runs two Dijkstras on the reversed
+ * graph, towards both ends of the edge, which gives the distance of every
+ * router to them; a tie counts as using the edge.
+ *
+ * Install() adds a passive protocol to every node's Ipv4ListRouting, so
+ * Ipv4::SetDown()/SetUp() trigger the update by themselves.  Changes that
+ * happen at the same simulation time are processed in one batch.
+ *
+ *   Ptr<IncrementalGlobalRouting> spf = Create<IncrementalGlobalRouting>();
+ *   spf->Install();
+ *   spf->Populate(); // instead of Ipv4GlobalRoutingHelper::PopulateRoutingTables()
+ *
+ * The per-router SPF runs only read the graph, so SetThreads() spreads them
+ * over a pool of threads that lives for the whole recompute.  The routes are
+ * still written from the simulation thread, because ns-3 objects are not
+ * thread safe; it installs each router's routes as soon as they are
+ * computed while the pool works ahead.
+ *
+ * Do not enable ns3::Ipv4GlobalRouting::RespondToInterfaceEvents together
+ * with this helper; both would rewrite the same tables.
+ */
+
+#ifndef INCREMENTAL_GLOBAL_ROUTING_H
+#define INCREMENTAL_GLOBAL_ROUTING_H
+
+#include "ns3/abort.h"
+#include "ns3/callback.h"
+#include "ns3/channel.h"
+#include "ns3/ipv4-global-routing.h"
+#include "ns3/ipv4-list-routing.h"
+#include "ns3/ipv4-routing-protocol.h"
+#include "ns3/ipv4.h"
+#include "ns3/net-device.h"
+#include "ns3/node-list.h"
+#include "ns3/node.h"
+#include "ns3/simple-ref-count.h"
+#include "ns3/simulator.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * Keeps Ipv4GlobalRouting tables up to date with incremental SPF runs.
+ */
+class IncrementalGlobalRouting : public SimpleRefCount<IncrementalGlobalRouting>
+{
+  public:
+    IncrementalGlobalRouting();
+
+    /**
+     * Attach the interface-event hooks to every node with an Ipv4 stack.
+     * Call after the internet stack is installed.
+     */
+    void Install();
+
+    /**
+     * Build the link-state graph from the current addressing and compute
+     * the routes of every router.  Call after the addresses are assigned.
+     */
+    void Populate();
+
+    /**
+     * Recompute the routes of every router on the current graph.
+     */
+    void RecomputeAll();
+
+    /**
+     * Process pending interface changes now instead of at the end of the
+     * current simulation time.
+     */
+    void Flush();
+
+    /**
+     * \param threads Number of threads running SPF computations, 0 for one
+     * per hardware thread.  The default is 1.
+     */
+    void SetThreads(uint32_t threads);
+
+    /**
+     * \param cb Called after every update with the number of routers whose
+     * tree was recomputed and the wall-clock time the update took, in seconds.
+     */
+    void SetUpdateCallback(Callback<void, uint32_t, double> cb);
+
+    /**
+     * Called by the hooks when an interface changes state.
+     * \param nodeId The node id.
+     * \param ifIndex The Ipv4 interface index.
+     * \param up The new state.
+     */
+    void NotifyInterfaceChange(uint32_t nodeId, uint32_t ifIndex, bool up);
+
+    /**
+     * Called by the hooks when an address is added or removed.  The graph is
+     * rebuilt from scratch on the next update.
+     */
+    void NotifyAddressChange();
+
+  private:
+    /** Passive routing protocol that forwards interface events. */
+    class Hook : public Ipv4RoutingProtocol
+    {
+      public:
+        /**
+         * \param owner The helper to notify.
+         */
+        Hook(Ptr<IncrementalGlobalRouting> owner)
+            : m_owner(owner)
+        {
+        }
+
+        Ptr<Ipv4Route> RouteOutput(Ptr<Packet> p,
+                                   const Ipv4Header& header,
+                                   Ptr<NetDevice> oif,
+                                   Socket::SocketErrno& sockerr) override
+        {
+            sockerr = Socket::ERROR_NOROUTETOHOST;
+            return nullptr;
+        }
+
+        bool RouteInput(Ptr<const Packet> p,
+                        const Ipv4Header& header,
+                        Ptr<const NetDevice> idev,
+                        const UnicastForwardCallback& ucb,
+                        const MulticastForwardCallback& mcb,
+                        const LocalDeliverCallback& lcb,
+                        const ErrorCallback& ecb) override
+        {
+            return false;
+        }
+
+        void NotifyInterfaceUp(uint32_t interface) override
+        {
+            m_owner->NotifyInterfaceChange(NodeId(), interface, true);
+        }
+
+        void NotifyInterfaceDown(uint32_t interface) override
+        {
+            m_owner->NotifyInterfaceChange(NodeId(), interface, false);
+        }
+
+        void NotifyAddAddress(uint32_t interface, Ipv4InterfaceAddress address) override
+        {
+            m_owner->NotifyAddressChange();
+        }
+
+        void NotifyRemoveAddress(uint32_t interface, Ipv4InterfaceAddress address) override
+        {
+            m_owner->NotifyAddressChange();
+        }
+
+        void SetIpv4(Ptr<Ipv4> ipv4) override
+        {
+            m_ipv4 = ipv4;
+        }
+
+        void PrintRoutingTable(Ptr<OutputStreamWrapper> stream,
+                               Time::Unit unit = Time::S) const override
+        {
+        }
+
+      private:
+        /** \return the id of the node this hook is installed on. */
+        uint32_t NodeId() const
+        {
+            return m_ipv4->GetObject<Node>()->GetId();
+        }
+
+        Ptr<IncrementalGlobalRouting> m_owner; //!< The helper to notify.
+        Ptr<Ipv4> m_ipv4;                      //!< The Ipv4 of the node.
+    };
+
+    /** An interface attaching a router to a network. */
+    struct Member
+    {
+        uint32_t router;     //!< Node id.
+        uint32_t net;        //!< Network index.
+        uint32_t ifIndex;    //!< Ipv4 interface index on the router.
+        Ipv4Address address; //!< Interface address, next hop for the others.
+        uint32_t metric;     //!< Cost of leaving the router on this interface.
+        bool up;             //!< Whether the interface is up.
+    };
+
+    /** A network (p2p link, CSMA segment, Wi-Fi BSS) with its prefix. */
+    struct Net
+    {
+        Ipv4Address network;           //!< Network address.
+        Ipv4Mask mask;                 //!< Network mask.
+        std::vector<uint32_t> members; //!< Attached interfaces.
+    };
+
+    /** First hop towards a vertex. */
+    struct FirstHop
+    {
+        uint32_t outIf;      //!< Interface of the root.
+        uint32_t nextMember; //!< Member whose address is the next hop, INF if none.
+    };
+
+    static constexpr uint32_t INF = std::numeric_limits<uint32_t>::max(); //!< Unreachable.
+
+    /** Build the graph from the nodes' Ipv4 configuration. */
+    void BuildGraph();
+
+    /**
+     * Run Dijkstra from a router.
+     * \param root The router.
+     * \param dist Scratch distances, over routers then networks.
+     * \param hops The first hops to fill.
+     */
+    void Spf(uint32_t root, std::vector<uint32_t>& dist, std::vector<FirstHop>& hops) const;
+
+    /**
+     * Run Dijkstra towards a vertex on the reversed graph.
+     * \param target A router or network vertex.
+     * \param dist Filled with the distance of every vertex to the target.
+     */
+    void SpfTo(uint32_t target, std::vector<uint32_t>& dist) const;
+
+    /**
+     * Recompute the routes of a set of routers.
+     * \param roots The routers.
+     */
+    void Recompute(const std::vector<uint32_t>& roots);
+
+    /**
+     * Replace the global routes of a router.
+     * \param root The router.
+     * \param hops The first hops computed by Spf().
+     */
+    void InstallRoutes(uint32_t root, const std::vector<FirstHop>& hops);
+
+    /**
+     * \param toRouter Distance from a root to the router of the member.
+     * \param toNet Distance from the root to the network of the member.
+     * \param m A member changing state.
+     * \param up The new state.
+     * \return whether the change can alter the shortest paths of the root.
+     */
+    bool Affects(uint32_t toRouter, uint32_t toNet, const Member& m, bool up) const;
+
+    /** Process the pending changes. */
+    void Update();
+
+    std::vector<Member> m_members;                  //!< All interfaces.
+    std::vector<Net> m_nets;                        //!< All networks.
+    std::vector<std::vector<uint32_t>> m_adjacency; //!< Members per router.
+    std::map<std::pair<uint32_t, uint32_t>, uint32_t> m_memberOf; //!< (node, ifIndex) to member.
+    std::vector<Ptr<Ipv4GlobalRouting>> m_routing;  //!< Global routing per router.
+    uint32_t m_nRouters;                            //!< Number of router vertices.
+    uint32_t m_threads;                             //!< SPF threads.
+
+    std::vector<std::pair<uint32_t, bool>> m_pending; //!< Pending (member, up) changes.
+    bool m_rebuild;                                   //!< Whether the graph must be rebuilt.
+    EventId m_updateEvent;                            //!< Batched update.
+    Callback<void, uint32_t, double> m_updateCb;      //!< Update report.
+};
+
+IncrementalGlobalRouting::IncrementalGlobalRouting()
+    : m_nRouters(0),
+      m_threads(1),
+      m_rebuild(false)
+{
+}
+
+void
+IncrementalGlobalRouting::Install()
+{
+    for (uint32_t i = 0; i < NodeList::GetNNodes(); i++)
+    {
+        Ptr<Ipv4> ipv4 = NodeList::GetNode(i)->GetObject<Ipv4>();
+        if (!ipv4)
+        {
+            continue;
+        }
+        Ptr<Ipv4ListRouting> list = DynamicCast<Ipv4ListRouting>(ipv4->GetRoutingProtocol());
+        NS_ABORT_MSG_UNLESS(list, "IncrementalGlobalRouting needs Ipv4ListRouting");
+        list->AddRoutingProtocol(CreateObject<Hook>(Ptr<IncrementalGlobalRouting>(this)), -20);
+    }
+}
+
+void
+IncrementalGlobalRouting::SetThreads(uint32_t threads)
+{
+    m_threads = threads ? threads : std::max(1U, std::thread::hardware_concurrency());
+}
+
+void
+IncrementalGlobalRouting::SetUpdateCallback(Callback<void, uint32_t, double> cb)
+{
+    m_updateCb = cb;
+}
+
+void
+IncrementalGlobalRouting::BuildGraph()
+{
+    m_members.clear();
+    m_nets.clear();
+    m_memberOf.clear();
+    m_nRouters = NodeList::GetNNodes();
+    m_adjacency.assign(m_nRouters, {});
+    m_routing.assign(m_nRouters, nullptr);
+
+    std::map<std::tuple<uint32_t, uint32_t, uint32_t>, uint32_t> netOf;
+    for (uint32_t r = 0; r < m_nRouters; r++)
+    {
+        Ptr<Ipv4> ipv4 = NodeList::GetNode(r)->GetObject<Ipv4>();
+        if (!ipv4)
+        {
+            continue;
+        }
+        Ptr<Ipv4ListRouting> list = DynamicCast<Ipv4ListRouting>(ipv4->GetRoutingProtocol());
+        for (uint32_t i = 0; list && i < list->GetNRoutingProtocols(); i++)
+        {
+            int16_t priority;
+            Ptr<Ipv4GlobalRouting> global =
+                DynamicCast<Ipv4GlobalRouting>(list->GetRoutingProtocol(i, priority));
+            if (global)
+            {
+                m_routing[r] = global;
+            }
+        }
+
+        // Interface 0 is the loopback.
+        for (uint32_t ifIndex = 1; ifIndex < ipv4->GetNInterfaces(); ifIndex++)
+        {
+            Ptr<Channel> channel = ipv4->GetNetDevice(ifIndex)->GetChannel();
+            if (!channel || ipv4->GetNAddresses(ifIndex) == 0)
+            {
+                continue;
+            }
+            Ipv4InterfaceAddress ifAddr = ipv4->GetAddress(ifIndex, 0);
+            Ipv4Address network = ifAddr.GetLocal().CombineMask(ifAddr.GetMask());
+            std::tuple<uint32_t, uint32_t, uint32_t> key{static_cast<uint32_t>(channel->GetId()),
+                                                         network.Get(),
+                                                         ifAddr.GetMask().Get()};
+            auto it = netOf.find(key);
+            if (it == netOf.end())
+            {
+                it = netOf.emplace(key, m_nets.size()).first;
+                m_nets.push_back({network, ifAddr.GetMask(), {}});
+            }
+
+            uint32_t m = m_members.size();
+            m_members.push_back({r,
+                                 it->second,
+                                 ifIndex,
+                                 ifAddr.GetLocal(),
+                                 ipv4->GetMetric(ifIndex),
+                                 ipv4->IsUp(ifIndex)});
+            m_nets[it->second].members.push_back(m);
+            m_adjacency[r].push_back(m);
+            m_memberOf[{r, ifIndex}] = m;
+        }
+    }
+}
+
+void
+IncrementalGlobalRouting::Spf(uint32_t root,
+                              std::vector<uint32_t>& dist,
+                              std::vector<FirstHop>& hops) const
+{
+    uint32_t nVertices = m_nRouters + m_nets.size();
+    dist.assign(nVertices, INF);
+    hops.assign(nVertices, {0, INF});
+
+    using Item = std::pair<uint32_t, uint32_t>; // (distance, vertex)
+    std::priority_queue<Item, std::vector<Item>, std::greater<Item>> queue;
+    dist[root] = 0;
+    queue.emplace(0, root);
+    while (!queue.empty())
+    {
+        auto [d, u] = queue.top();
+        queue.pop();
+        if (d > dist[u])
+        {
+            continue;
+        }
+        if (u < m_nRouters)
+        {
+            // router -> network, paying the interface metric
+            for (uint32_t m : m_adjacency[u])
+            {
+                const Member& member = m_members[m];
+                uint32_t x = m_nRouters + member.net;
+                if (member.up && d + member.metric < dist[x])
+                {
+                    dist[x] = d + member.metric;
+                    hops[x] = (u == root) ? FirstHop{member.ifIndex, INF} : hops[u];
+                    queue.emplace(dist[x], x);
+                }
+            }
+        }
+        else
+        {
+            // network -> router, for free; a network without next hop is
+            // attached to the root
+            for (uint32_t m : m_nets[u - m_nRouters].members)
+            {
+                const Member& member = m_members[m];
+                uint32_t v = member.router;
+                if (member.up && d < dist[v])
+                {
+                    dist[v] = d;
+                    hops[v] = (hops[u].nextMember == INF) ? FirstHop{hops[u].outIf, m} : hops[u];
+                    queue.emplace(d, v);
+                }
+            }
+        }
+    }
+}
+
+void
+IncrementalGlobalRouting::SpfTo(uint32_t target, std::vector<uint32_t>& dist) const
+{
+    dist.assign(m_nRouters + m_nets.size(), INF);
+
+    using Item = std::pair<uint32_t, uint32_t>; // (distance, vertex)
+    std::priority_queue<Item, std::vector<Item>, std::greater<Item>> queue;
+    dist[target] = 0;
+    queue.emplace(0, target);
+    while (!queue.empty())
+    {
+        auto [d, u] = queue.top();
+        queue.pop();
+        if (d > dist[u])
+        {
+            continue;
+        }
+        if (u < m_nRouters)
+        {
+            // reversed network -> router edges, for free
+            for (uint32_t m : m_adjacency[u])
+            {
+                const Member& member = m_members[m];
+                uint32_t x = m_nRouters + member.net;
+                if (member.up && d < dist[x])
+                {
+                    dist[x] = d;
+                    queue.emplace(d, x);
+                }
+            }
+        }
+        else
+        {
+            // reversed router -> network edges, paying the interface metric
+            for (uint32_t m : m_nets[u - m_nRouters].members)
+            {
+                const Member& member = m_members[m];
+                uint32_t v = member.router;
+                if (member.up && d + member.metric < dist[v])
+                {
+                    dist[v] = d + member.metric;
+                    queue.emplace(dist[v], v);
+                }
+            }
+        }
+    }
+}
+
+void
+IncrementalGlobalRouting::InstallRoutes(uint32_t root, const std::vector<FirstHop>& hops)
+{
+    Ptr<Ipv4GlobalRouting> routing = m_routing[root];
+    while (routing->GetNRoutes() > 0)
+    {
+        routing->RemoveRoute(0);
+    }
+    for (uint32_t n = 0; n < m_nets.size(); n++)
+    {
+        const FirstHop& hop = hops[m_nRouters + n];
+        // Unreachable, or directly connected (handled by static routing).
+        if (hop.nextMember == INF)
+        {
+            continue;
+        }
+        routing->AddNetworkRouteTo(m_nets[n].network,
+                                   m_nets[n].mask,
+                                   m_members[hop.nextMember].address,
+                                   hop.outIf);
+    }
+}
+
+void
+IncrementalGlobalRouting::Recompute(const std::vector<uint32_t>& roots)
+{
+    std::size_t nThreads = std::min<std::size_t>(m_threads, roots.size());
+    if (nThreads <= 1)
+    {
+        std::vector<uint32_t> dist;
+        std::vector<FirstHop> hops;
+        for (uint32_t root : roots)
+        {
+            Spf(root, dist, hops);
+            InstallRoutes(root, hops);
+        }
+        return;
+    }
+
+    // The workers live for the whole recompute and run ahead of the
+    // simulation thread, which installs the routes in root order, by at
+    // most one window of roots, so that only a window of first hops is
+    // alive at the same time.
+    const std::size_t window = 64 * nThreads;
+    std::vector<std::vector<FirstHop>> hops(window);
+    std::vector<std::size_t> computed(window, std::numeric_limits<std::size_t>::max());
+    std::size_t next = 0;
+    std::size_t installed = 0;
+    std::mutex mutex;
+    std::condition_variable ready; // a root's first hops are computed
+    std::condition_variable space; // a slot of the window is free
+    auto worker = [&]() {
+        std::vector<uint32_t> dist;
+        for (;;)
+        {
+            std::size_t i;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                space.wait(lock,
+                           [&]() { return next == roots.size() || next < installed + window; });
+                if (next == roots.size())
+                {
+                    return;
+                }
+                i = next++;
+            }
+            Spf(roots[i], dist, hops[i % window]);
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                computed[i % window] = i;
+            }
+            ready.notify_one();
+        }
+    };
+    std::vector<std::thread> pool;
+    for (std::size_t t = 0; t < nThreads; t++)
+    {
+        pool.emplace_back(worker);
+    }
+    for (std::size_t i = 0; i < roots.size(); i++)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            ready.wait(lock, [&]() { return computed[i % window] == i; });
+        }
+        InstallRoutes(roots[i], hops[i % window]);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            installed = i + 1;
+        }
+        space.notify_all();
+    }
+    for (auto& thread : pool)
+    {
+        thread.join();
+    }
+}
+
+void
+IncrementalGlobalRouting::Populate()
+{
+    BuildGraph();
+    RecomputeAll();
+}
+
+void
+IncrementalGlobalRouting::RecomputeAll()
+{
+    std::vector<uint32_t> roots;
+    for (uint32_t r = 0; r < m_nRouters; r++)
+    {
+        if (m_routing[r])
+        {
+            roots.push_back(r);
+        }
+    }
+    Recompute(roots);
+}
+
+bool
+IncrementalGlobalRouting::Affects(uint32_t toRouter,
+                                  uint32_t toNet,
+                                  const Member& m,
+                                  bool up) const
+{
+    if (!up)
+    {
+        // Only an edge on a shortest path going away can change the routes.
+        return toNet != INF && toRouter != INF &&
+               (toRouter + m.metric == toNet || toNet == toRouter);
+    }
+    // A new edge matters only if it strictly shortens a path.
+    return (toRouter != INF && toRouter + m.metric < toNet) ||
+           (toNet != INF && toNet < toRouter);
+}
+
+void
+IncrementalGlobalRouting::NotifyInterfaceChange(uint32_t nodeId, uint32_t ifIndex, bool up)
+{
+    auto it = m_memberOf.find({nodeId, ifIndex});
+    if (it == m_memberOf.end())
+    {
+        // Not part of the graph yet (e.g. before Populate()).
+        return;
+    }
+    m_pending.emplace_back(it->second, up);
+    if (!m_updateEvent.IsRunning())
+    {
+        m_updateEvent = Simulator::ScheduleNow(&IncrementalGlobalRouting::Update, this);
+    }
+}
+
+void
+IncrementalGlobalRouting::NotifyAddressChange()
+{
+    if (m_nRouters == 0)
+    {
+        return;
+    }
+    m_rebuild = true;
+    if (!m_updateEvent.IsRunning())
+    {
+        m_updateEvent = Simulator::ScheduleNow(&IncrementalGlobalRouting::Update, this);
+    }
+}
+
+void
+IncrementalGlobalRouting::Flush()
+{
+    m_updateEvent.Cancel();
+    Update();
+}
+
+void
+IncrementalGlobalRouting::Update()
+{
+    auto start = std::chrono::steady_clock::now();
+    uint32_t nRoots = 0;
+    if (m_rebuild)
+    {
+        m_rebuild = false;
+        m_pending.clear();
+        Populate();
+        nRoots = m_nRouters;
+    }
+    else if (!m_pending.empty())
+    {
+        // Decide on the old graph, then apply the changes.
+        std::vector<bool> affected(m_nRouters, false);
+        std::vector<uint32_t> toRouter;
+        std::vector<uint32_t> toNet;
+        for (const auto& [m, up] : m_pending)
+        {
+            const Member& member = m_members[m];
+            if (member.up == up)
+            {
+                continue;
+            }
+            SpfTo(member.router, toRouter);
+            SpfTo(m_nRouters + member.net, toNet);
+            for (uint32_t r = 0; r < m_nRouters; r++)
+            {
+                affected[r] = affected[r] || Affects(toRouter[r], toNet[r], member, up);
+            }
+        }
+        std::vector<uint32_t> roots;
+        for (uint32_t r = 0; r < m_nRouters; r++)
+        {
+            if (m_routing[r] && affected[r])
+            {
+                roots.push_back(r);
+            }
+        }
+        for (const auto& [m, up] : m_pending)
+        {
+            m_members[m].up = up;
+        }
+        m_pending.clear();
+        Recompute(roots);
+        nRoots = roots.size();
+    }
+    else
+    {
+        return;
+    }
+
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    if (!m_updateCb.IsNull())
+    {
+        m_updateCb(nRoots, elapsed.count());
+    }
+}
+
+} // namespace ns3
+
+#endif /* INCREMENTAL_GLOBAL_ROUTING_H */
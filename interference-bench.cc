@@ -0,0 +1,470 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Interference bookkeeping of one PHY in a dense single-channel cell.
+ *
+ * One PHY hears --transmitters others, as a node of the 50-node l9q1.cc
+ * MANET does.  Each transmitter sends frames of 0.5 to 1.5 x --frameUs
+ * microseconds, idle in between for an exponential time so that it is on
+ * the air a --load fraction of the time; the frames reach the PHY at -50 to
+ * -100 dBm.  Carrier sense is not modelled, so this is the hidden-node
+ * worst case.  The PHY locks onto a frame above -82 dBm when it is not
+ * already receiving one, and reads the interference over it in chunks when
+ * it ends.
+ *
+ * --tracker=ns3 feeds the frames to an ns3::InterferenceHelper, as
+ * YansWifiPhy does: one event per frame, NotifyRxStart()/NotifyRxEnd()
+ * around the locked frame and CalculateSnr() when it ends, which copies the
+ * power changes over it.  --tracker=ring uses InterferenceTracker (see
+ * interference-tracker.h) and reads the interference chunks when the frame
+ * ends.  Either way every frame is a simulator event at its start.
+ * --tracker=both runs both; InterferenceHelper does not expose the
+ * interference over a frame, so the ring's is then checked against a copy
+ * of the helper's bookkeeping (a multimap of power changes, pruned only
+ * when a signal arrives while the PHY is idle) in a third, untimed run.
+ * Run ns3 and ring as separate processes to compare their RSS.
+ *
+ * One line is printed per tracker:
+ *   tracker,transmitters,signals,receptions,signals_per_s,max_changes,max_rss_kb
+ * where max_changes is empty for ns3, whose changes are private, and with
+ * --tracker=both the largest relative difference.
+ *
+ *   ./ns3 run "scratch/interference-bench --tracker=both"
+ *   ./ns3 run "scratch/interference-bench --tracker=ns3 --load=0.2"
+ *   ./ns3 run "scratch/interference-bench --tracker=ring --load=0.2"
+ */
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/wifi-module.h"
+
+#include "interference-tracker.h"
+
+#include <sys/resource.h>
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <queue>
+#include <string>
+#include <vector>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE("InterferenceBench");
+
+/**
+ * Copy of the power bookkeeping of InterferenceHelper (ns-3.38) for one
+ * band, which reports the interference energy over a frame.
+ */
+class NiChangesTracker
+{
+  public:
+    NiChangesTracker()
+    {
+        m_niChanges.insert({Time(0), 0.0});
+    }
+
+    /**
+     * Add a signal.
+     * \param start Its start.
+     * \param end Its end.
+     * \param power Its power in W.
+     */
+    void Add(Time start, Time end, double power)
+    {
+        auto previousStart = std::prev(m_niChanges.upper_bound(start));
+        double powerStart = previousStart->second;
+        double powerEnd = std::prev(m_niChanges.upper_bound(end))->second;
+        if (!m_rxing)
+        {
+            m_niChanges.erase(std::next(m_niChanges.begin()), std::next(previousStart));
+        }
+        auto first = m_niChanges.insert(m_niChanges.upper_bound(start), {start, powerStart});
+        auto last = m_niChanges.insert(m_niChanges.upper_bound(end), {end, powerEnd});
+        for (auto i = first; i != last; ++i)
+        {
+            i->second += power;
+        }
+    }
+
+    /**
+     * \param rxing Whether the PHY is receiving.
+     */
+    void SetRxing(bool rxing)
+    {
+        m_rxing = rxing;
+    }
+
+    /**
+     * Interference energy over a signal.
+     * \param start Its start.
+     * \param end Its end.
+     * \param power Its power in W.
+     * \return the energy of the other signals over it in J.
+     */
+    double GetEnergy(Time start, Time end, double power) const
+    {
+        double energy = 0;
+        Time from = start;
+        auto change = m_niChanges.upper_bound(start);
+        for (; change != m_niChanges.end() && change->first < end; ++change)
+        {
+            energy += (std::prev(change)->second - power) * (change->first - from).GetSeconds();
+            from = change->first;
+        }
+        return energy + (std::prev(change)->second - power) * (end - from).GetSeconds();
+    }
+
+    /** \return the number of changes kept. */
+    std::size_t GetNChanges() const
+    {
+        return m_niChanges.size();
+    }
+
+  private:
+    std::multimap<Time, double> m_niChanges; //!< Total power from each time on.
+    bool m_rxing = false;                    //!< Whether the PHY is receiving.
+};
+
+/** A frame reaching the PHY. */
+struct Signal
+{
+    Time start;   //!< Its start.
+    Time end;     //!< Its end.
+    double power; //!< Its power in W.
+};
+
+/**
+ * Generates the frames of all transmitters in start order.
+ */
+class Cell
+{
+  public:
+    /**
+     * \param transmitters The number of transmitters.
+     * \param load Airtime fraction of each.
+     * \param frame Mean frame duration.
+     */
+    Cell(uint32_t transmitters, double load, Time frame)
+        : m_frame(frame),
+          m_idle(frame.GetSeconds() * (1 - load) / load)
+    {
+        // Fixed streams, so that every run sees the same frames
+        m_uniform = CreateObject<UniformRandomVariable>();
+        m_uniform->SetStream(1);
+        m_exponential = CreateObject<ExponentialRandomVariable>();
+        m_exponential->SetStream(2);
+        for (uint32_t i = 0; i < transmitters; i++)
+        {
+            m_next.push(Next(Time(0)));
+        }
+    }
+
+    /** \return the next frame. */
+    Signal Get()
+    {
+        Signal signal = m_next.top();
+        m_next.pop();
+        m_next.push(Next(signal.end));
+        return signal;
+    }
+
+  private:
+    /**
+     * \param after End of the transmitter's previous frame.
+     * \return its next frame.
+     */
+    Signal Next(Time after)
+    {
+        Time start = after + Seconds(m_exponential->GetValue(m_idle, 0));
+        Time end = start + m_frame * m_uniform->GetValue(0.5, 1.5);
+        double dbm = m_uniform->GetValue(-100, -50);
+        return {start, end, std::pow(10.0, dbm / 10) / 1000};
+    }
+
+    /** Orders frames by start. */
+    struct Later
+    {
+        /**
+         * \param a A frame.
+         * \param b Another.
+         * \return whether a starts after b.
+         */
+        bool operator()(const Signal& a, const Signal& b) const
+        {
+            return a.start > b.start;
+        }
+    };
+
+    Time m_frame;                                                   //!< Mean frame duration.
+    double m_idle;                                                  //!< Mean idle time in s.
+    Ptr<UniformRandomVariable> m_uniform;                           //!< Durations and powers.
+    Ptr<ExponentialRandomVariable> m_exponential;                   //!< Idle times.
+    std::priority_queue<Signal, std::vector<Signal>, Later> m_next; //!< Next frame of each.
+};
+
+/** Results of one run. */
+struct Result
+{
+    uint64_t receptions = 0;      //!< Frames the PHY locked onto.
+    double wall = 0;              //!< Wall-clock seconds.
+    std::size_t maxChanges = 0;   //!< Most changes kept at once, 0 if unknown.
+    std::vector<double> energies; //!< Interference energy of each reception (not ns3).
+};
+
+/**
+ * Feeds the frames of a cell to one tracker, one simulator event per frame.
+ */
+class CellRun
+{
+  public:
+    /**
+     * \param tracker ns3, ring or copy.
+     * \param cell The frames.
+     * \param signals The number of frames.
+     * \param result The result, filled.
+     */
+    CellRun(const std::string& tracker, Cell& cell, uint64_t signals, Result& result)
+        : m_tracker(tracker),
+          m_cell(cell),
+          m_left(signals),
+          m_result(result),
+          m_threshold(std::pow(10.0, -82.0 / 10) / 1000)
+    {
+        if (m_tracker == "ns3")
+        {
+            m_helper = CreateObject<InterferenceHelper>();
+            m_helper->AddBand(m_band);
+        }
+        ScheduleNext();
+    }
+
+  private:
+    /** Schedule the start of the next frame. */
+    void ScheduleNext()
+    {
+        if (m_left == 0)
+        {
+            return;
+        }
+        m_left--;
+        Signal signal = m_cell.Get();
+        Simulator::Schedule(signal.start - Simulator::Now(), &CellRun::Start, this, signal);
+    }
+
+    /**
+     * A frame starts.
+     * \param signal The frame.
+     */
+    void Start(Signal signal)
+    {
+        bool lock = !m_rxing && signal.power >= m_threshold;
+        if (m_tracker == "ns3")
+        {
+            RxPowerWattPerChannelBand rxPower;
+            rxPower.insert({m_band, signal.power});
+            if (lock)
+            {
+                // As InterferenceHelper::AddForeignSignal() builds its PPDU
+                WifiMacHeader header;
+                header.SetType(WIFI_MAC_QOSDATA);
+                header.SetQosTid(0);
+                Ptr<WifiPsdu> psdu = Create<WifiPsdu>(Create<Packet>(0), header);
+                Ptr<WifiPpdu> ppdu = Create<WifiPpdu>(psdu, WifiTxVector(), 0);
+                m_event = m_helper->Add(ppdu, WifiTxVector(), signal.end - signal.start, rxPower);
+                m_helper->NotifyRxStart();
+            }
+            else
+            {
+                m_helper->AddForeignSignal(signal.end - signal.start, rxPower);
+            }
+        }
+        else if (m_tracker == "ring")
+        {
+            if (lock)
+            {
+                m_id = m_ring.AddReception(signal.start, signal.end, signal.power);
+            }
+            else
+            {
+                m_ring.Add(signal.start, signal.end, signal.power);
+            }
+            m_result.maxChanges = std::max(m_result.maxChanges, m_ring.GetNChanges());
+        }
+        else
+        {
+            m_copy.Add(signal.start, signal.end, signal.power);
+            m_copy.SetRxing(m_rxing || lock);
+            m_result.maxChanges = std::max(m_result.maxChanges, m_copy.GetNChanges());
+        }
+        if (lock)
+        {
+            m_locked = signal;
+            m_rxing = true;
+            m_result.receptions++;
+            Simulator::Schedule(signal.end - signal.start, &CellRun::End, this);
+        }
+        ScheduleNext();
+    }
+
+    /** The locked frame ends. */
+    void End()
+    {
+        if (m_tracker == "ns3")
+        {
+            m_helper->CalculateSnr(m_event, 20, 1, m_band);
+            m_helper->NotifyRxEnd(Simulator::Now());
+            m_event = nullptr;
+        }
+        else if (m_tracker == "ring")
+        {
+            double energy = 0;
+            m_ring.EndReception(m_id, m_chunks);
+            for (const auto& chunk : m_chunks)
+            {
+                energy += chunk.interference * (chunk.end - chunk.start).GetSeconds();
+            }
+            m_result.energies.push_back(energy);
+        }
+        else
+        {
+            m_result.energies.push_back(
+                m_copy.GetEnergy(m_locked.start, m_locked.end, m_locked.power));
+            m_copy.SetRxing(false);
+        }
+        m_rxing = false;
+    }
+
+    std::string m_tracker;                            //!< ns3, ring or copy.
+    Cell& m_cell;                                     //!< The frames.
+    uint64_t m_left;                                  //!< Frames still to schedule.
+    Result& m_result;                                 //!< The result.
+    double m_threshold;                               //!< Lowest power locked onto, in W.
+    bool m_rxing = false;                             //!< Whether a frame is locked.
+    Signal m_locked;                                  //!< The locked frame.
+    WifiSpectrumBand m_band{0, 0};                    //!< The band, as YansWifiPhy's.
+    Ptr<InterferenceHelper> m_helper;                 //!< ns3.
+    Ptr<Event> m_event;                               //!< Event of the locked frame, ns3.
+    InterferenceTracker m_ring;                       //!< ring.
+    uint64_t m_id = 0;                                //!< Reception of the locked frame, ring.
+    std::vector<InterferenceTracker::Chunk> m_chunks; //!< Its chunks, ring.
+    NiChangesTracker m_copy;                          //!< copy.
+};
+
+/**
+ * Run the cell through one tracker.
+ * \param tracker ns3, ring or copy.
+ * \param transmitters The number of transmitters.
+ * \param load Airtime fraction of each.
+ * \param frame Mean frame duration.
+ * \param signals The number of frames.
+ * \return the result.
+ */
+static Result
+RunCell(const std::string& tracker,
+        uint32_t transmitters,
+        double load,
+        Time frame,
+        uint64_t signals)
+{
+    Cell cell(transmitters, load, frame);
+    Result result;
+    auto start = std::chrono::steady_clock::now();
+    {
+        CellRun run(tracker, cell, signals, result);
+        Simulator::Run();
+        Simulator::Destroy();
+    }
+    std::chrono::duration<double> wall = std::chrono::steady_clock::now() - start;
+    result.wall = wall.count();
+    return result;
+}
+
+int
+main(int argc, char* argv[])
+{
+    std::string tracker("both");
+    uint32_t transmitters = 49;
+    double load = 0.1;
+    double frameUs = 1000;
+    uint64_t signals = 2000000;
+
+    CommandLine cmd(__FILE__);
+    cmd.AddValue("tracker", "Interference bookkeeping (ns3, ring, both)", tracker);
+    cmd.AddValue("transmitters", "Transmitters heard by the PHY", transmitters);
+    cmd.AddValue("load", "Airtime fraction of each transmitter", load);
+    cmd.AddValue("frameUs", "Mean frame duration in microseconds", frameUs);
+    cmd.AddValue("signals", "Frames to process", signals);
+    cmd.Parse(argc, argv);
+
+    NS_ABORT_MSG_UNLESS(tracker == "ns3" || tracker == "ring" || tracker == "both",
+                        "Unknown tracker " << tracker);
+    NS_ABORT_MSG_UNLESS(load > 0 && load < 1, "--load must be between 0 and 1");
+
+    std::vector<std::string> runs;
+    if (tracker == "both")
+    {
+        runs = {"ns3", "ring"};
+    }
+    else
+    {
+        runs = {tracker};
+    }
+
+    std::cout << "tracker,transmitters,signals,receptions,signals_per_s,max_changes,max_rss_kb"
+              << std::endl;
+    std::vector<Result> results;
+    for (const auto& run : runs)
+    {
+        results.push_back(RunCell(run, transmitters, load, MicroSeconds(frameUs), signals));
+        const Result& result = results.back();
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        std::cout << run << "," << transmitters << "," << signals << "," << result.receptions
+                  << "," << signals / result.wall << ",";
+        if (result.maxChanges > 0)
+        {
+            std::cout << result.maxChanges;
+        }
+        std::cout << "," << usage.ru_maxrss << std::endl;
+    }
+
+    if (results.size() == 2)
+    {
+        NS_ABORT_MSG_UNLESS(results[0].receptions == results[1].receptions,
+                            "The trackers locked onto different frames");
+        Result copy = RunCell("copy", transmitters, load, MicroSeconds(frameUs), signals);
+        const Result& ring = results[1];
+        NS_ABORT_MSG_UNLESS(copy.energies.size() == ring.energies.size(),
+                            "The trackers finished different receptions");
+        double worst = 0;
+        for (std::size_t i = 0; i < copy.energies.size(); i++)
+        {
+            double a = copy.energies[i];
+            double b = ring.energies[i];
+            if (a != b)
+            {
+                worst = std::max(worst, std::abs(a - b) / std::max(std::abs(a), std::abs(b)));
+            }
+        }
+        std::cout << "# largest relative difference of the interference energy: " << worst
+                  << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,280 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Interference of one band over time, with bounded memory.
+ *
+ * InterferenceHelper keeps, per band, a multimap from time to the total
+ * power after each signal start or end.  Adding a signal inserts its start
+ * and end and adds its power to every entry in between, and entries are
+ * only dropped when a signal arrives while the PHY is not receiving, so in
+ * a busy cell the map keeps growing while a frame is received and every
+ * signal touches everything that overlaps it.
+ *
+ * InterferenceTracker exploits that signals are added when they start, in
+ * time order.  It keeps:
+ * - the total power of the signals on the air, updated as they start and
+ *   end (ends wait in a heap until time passes them);
+ * - a time-ordered ring (deque) of (time, total power) changes that have
+ *   happened, each appended in O(1);
+ * - the receptions still being decoded; changes older than the start of the
+ *   oldest of them can no longer matter and are dropped at once.
+ * The interference over a reception is read back as chunks of constant
+ * power when it ends, exactly as InterferenceHelper splits it for the
+ * chunk success rates.  interference-bench.cc compares both on a dense
+ * single-channel cell such as l9q1.cc.
+ *
+ *   InterferenceTracker tracker;
+ *   tracker.Add(start, end, powerW);               // a signal not decoded
+ *   uint64_t id = tracker.AddReception(start, end, powerW);
+ *   ...
+ *   tracker.EndReception(id, chunks);              // at or after its end
+ */
+
+#ifndef INTERFERENCE_TRACKER_H
+#define INTERFERENCE_TRACKER_H
+
+#include "ns3/abort.h"
+#include "ns3/nstime.h"
+
+#include <algorithm>
+#include <deque>
+#include <functional>
+#include <iterator>
+#include <map>
+#include <queue>
+#include <set>
+#include <utility>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * Total signal power of one band, as time-ordered changes.
+ */
+class InterferenceTracker
+{
+  public:
+    /** Interference constant over part of a reception. */
+    struct Chunk
+    {
+        Time start;          //!< Start of the chunk.
+        Time end;            //!< End of the chunk.
+        double interference; //!< Power of the other signals in W.
+    };
+
+    InterferenceTracker();
+
+    /**
+     * Add a signal that is not decoded.
+     * \param start Its start, not before that of the previous signal.
+     * \param end Its end.
+     * \param power Its power in W.
+     */
+    void Add(Time start, Time end, double power);
+
+    /**
+     * Add a signal that is decoded.
+     * \param start Its start, not before that of the previous signal.
+     * \param end Its end.
+     * \param power Its power in W.
+     * \return the reception id.
+     */
+    uint64_t AddReception(Time start, Time end, double power);
+
+    /**
+     * Finish a reception.
+     * \param id The reception id.
+     * \param chunks The interference over the reception, written.
+     */
+    void EndReception(uint64_t id, std::vector<Chunk>& chunks);
+
+    /**
+     * Finish a reception without reading its interference, e.g. when the
+     * PHY drops it.
+     * \param id The reception id.
+     */
+    void AbortReception(uint64_t id);
+
+    /**
+     * \param now The current time.
+     * \return the total power of the signals on the air in W.
+     */
+    double GetPower(Time now);
+
+    /** \return the number of changes kept. */
+    std::size_t GetNChanges() const;
+
+  private:
+    /** Total power from a time on. */
+    struct Change
+    {
+        Time time;    //!< When the total changed.
+        double power; //!< Total power from then on in W.
+    };
+
+    /** A reception being decoded. */
+    struct Reception
+    {
+        Time start;   //!< Start of the signal.
+        Time end;     //!< End of the signal.
+        double power; //!< Power of the signal in W.
+    };
+
+    /** A pending signal end. */
+    using End = std::pair<Time, double>;
+
+    /**
+     * Apply the signal ends up to a time.
+     * \param now The time.
+     */
+    void Advance(Time now);
+
+    /**
+     * Record the total power from a time on.
+     * \param time The time.
+     */
+    void Append(Time time);
+
+    /** Drop the changes no reception needs. */
+    void Prune();
+
+    double m_power;                                                       //!< On-air power in W.
+    std::deque<Change> m_changes;                                         //!< Oldest first.
+    std::priority_queue<End, std::vector<End>, std::greater<End>> m_ends; //!< Pending ends.
+    std::map<uint64_t, Reception> m_receptions;                           //!< Receptions by id.
+    std::multiset<Time> m_starts;                                         //!< Their starts.
+    uint64_t m_nextId;                                                    //!< Next reception id.
+};
+
+InterferenceTracker::InterferenceTracker()
+    : m_power(0),
+      m_nextId(0)
+{
+    m_changes.push_back({Time(0), 0});
+}
+
+void
+InterferenceTracker::Advance(Time now)
+{
+    while (!m_ends.empty() && m_ends.top().first <= now)
+    {
+        Time time = m_ends.top().first;
+        m_power -= m_ends.top().second;
+        m_ends.pop();
+        if (m_ends.empty())
+        {
+            m_power = 0; // no rounding left over once the air is clear
+        }
+        Append(time);
+    }
+}
+
+void
+InterferenceTracker::Append(Time time)
+{
+    if (m_changes.back().time == time)
+    {
+        m_changes.back().power = m_power;
+    }
+    else
+    {
+        m_changes.push_back({time, m_power});
+    }
+}
+
+void
+InterferenceTracker::Add(Time start, Time end, double power)
+{
+    NS_ABORT_MSG_UNLESS(start >= m_changes.back().time,
+                        "InterferenceTracker: signals must be added in start order");
+    Advance(start);
+    m_power += power;
+    Append(start);
+    m_ends.emplace(end, power);
+    Prune();
+}
+
+uint64_t
+InterferenceTracker::AddReception(Time start, Time end, double power)
+{
+    Add(start, end, power);
+    m_receptions[m_nextId] = {start, end, power};
+    m_starts.insert(start);
+    return m_nextId++;
+}
+
+void
+InterferenceTracker::EndReception(uint64_t id, std::vector<Chunk>& chunks)
+{
+    auto it = m_receptions.find(id);
+    NS_ABORT_MSG_UNLESS(it != m_receptions.end(), "InterferenceTracker: unknown reception " << id);
+    const Reception& reception = it->second;
+    Advance(reception.end);
+
+    chunks.clear();
+    auto change = std::upper_bound(m_changes.begin(),
+                                   m_changes.end(),
+                                   reception.start,
+                                   [](Time t, const Change& c) { return t < c.time; });
+    Time from = reception.start; // the change before holds the power at the start
+    for (; change != m_changes.end() && change->time < reception.end; ++change)
+    {
+        chunks.push_back({from, change->time, std::prev(change)->power - reception.power});
+        from = change->time;
+    }
+    chunks.push_back({from, reception.end, std::prev(change)->power - reception.power});
+    AbortReception(id);
+}
+
+void
+InterferenceTracker::AbortReception(uint64_t id)
+{
+    auto it = m_receptions.find(id);
+    NS_ABORT_MSG_UNLESS(it != m_receptions.end(), "InterferenceTracker: unknown reception " << id);
+    m_starts.erase(m_starts.find(it->second.start));
+    m_receptions.erase(it);
+    Prune();
+}
+
+void
+InterferenceTracker::Prune()
+{
+    // Keep the last change at or before the oldest start: it holds the
+    // power at that start
+    Time oldest = m_starts.empty() ? m_changes.back().time : *m_starts.begin();
+    while (m_changes.size() > 1 && m_changes[1].time <= oldest)
+    {
+        m_changes.pop_front();
+    }
+}
+
+double
+InterferenceTracker::GetPower(Time now)
+{
+    Advance(now);
+    return m_power;
+}
+
+std::size_t
+InterferenceTracker::GetNChanges() const
+{
+    return m_changes.size();
+}
+
+} // namespace ns3
+
+#endif /* INTERFERENCE_TRACKER_H */
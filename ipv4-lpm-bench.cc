@@ -0,0 +1,180 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Route lookup latency: Ipv4StaticRouting list walk vs. Ipv4RouteIndex trie.
+ *
+ * For each table size a router gets that many random /8../32 network routes
+ * (plus a default route) through Ipv4RouteIndex, which adds them to the
+ * node's Ipv4StaticRouting and to the trie.  Random destinations are then
+ * looked up with Ipv4StaticRouting::RouteOutput() and with the index, and
+ * the gateways chosen by both are compared.  Then --removals random routes
+ * are removed through the index and the comparison is repeated.
+ *
+ * Output, one line per table size:
+ *   routes,static_ns_per_lookup,trie_ns_per_lookup,speedup,agree,agree_after_remove
+ *
+ *   ./ns3 run "scratch/ipv4-lpm-bench --sizes=10,1000,100000"
+ */
+
+#include "ns3/core-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/network-module.h"
+#include "ns3/point-to-point-module.h"
+
+#include "ipv4-route-trie.h"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE("Ipv4LpmBench");
+
+/**
+ * Percentage of destinations for which both lookups pick the same route.
+ * \param routing The static routing protocol.
+ * \param index Its index.
+ * \param headers The destinations.
+ * \return the percentage.
+ */
+static double
+Agreement(Ptr<Ipv4StaticRouting> routing,
+          const Ipv4RouteIndex& index,
+          const std::vector<Ipv4Header>& headers)
+{
+    uint32_t agree = 0;
+    Socket::SocketErrno sockerr;
+    for (const auto& header : headers)
+    {
+        Ptr<Ipv4Route> viaStatic = routing->RouteOutput(nullptr, header, nullptr, sockerr);
+        const Ipv4RoutingTableEntry* viaTrie = index.Lookup(header.GetDestination());
+        agree += viaStatic && viaTrie ? viaStatic->GetGateway() == viaTrie->GetGateway()
+                                      : !viaStatic && !viaTrie;
+    }
+    return 100.0 * agree / headers.size();
+}
+
+/**
+ * Run one table size.
+ * \param nRoutes The number of routes.
+ * \param lookups The number of lookups to time.
+ * \param removals The number of routes to remove before checking again.
+ */
+static void
+RunSize(uint32_t nRoutes, uint32_t lookups, uint32_t removals)
+{
+    NodeContainer nodes;
+    nodes.Create(2);
+    InternetStackHelper internet;
+    internet.Install(nodes);
+    PointToPointHelper p2p;
+    NetDeviceContainer devices = p2p.Install(nodes);
+    Ipv4AddressHelper address;
+    address.SetBase("192.168.0.0", "255.255.255.252");
+    address.Assign(devices);
+
+    Ptr<Ipv4> ipv4 = nodes.Get(0)->GetObject<Ipv4>();
+    uint32_t ifIndex = ipv4->GetInterfaceForDevice(devices.Get(0));
+    Ipv4StaticRoutingHelper staticHelper;
+    Ptr<Ipv4StaticRouting> routing = staticHelper.GetStaticRouting(ipv4);
+    Ipv4RouteIndex index(routing);
+
+    // Gateways are fake; only the choice of route is compared.
+    Ptr<UniformRandomVariable> rng = CreateObject<UniformRandomVariable>();
+    index.AddNetworkRouteTo("0.0.0.0", "0.0.0.0", "192.168.0.2", ifIndex);
+    for (uint32_t i = 0; i < nRoutes; i++)
+    {
+        uint32_t len = rng->GetInteger(8, 32);
+        Ipv4Mask mask(~0U << (32 - len));
+        Ipv4Address network(rng->GetInteger(0x0b000000, 0x0bffffff) & mask.Get());
+        Ipv4Address gateway(0xc0a80000 + rng->GetInteger(1, 0xfffe));
+        index.AddNetworkRouteTo(network, mask, gateway, ifIndex);
+    }
+
+    std::vector<Ipv4Header> headers(lookups);
+    for (auto& header : headers)
+    {
+        header.SetDestination(Ipv4Address(rng->GetInteger(0x0b000000, 0x0bffffff)));
+    }
+
+    std::vector<Ipv4Address> viaStatic(lookups);
+    Socket::SocketErrno sockerr;
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < lookups; i++)
+    {
+        viaStatic[i] = routing->RouteOutput(nullptr, headers[i], nullptr, sockerr)->GetGateway();
+    }
+    std::chrono::duration<double> staticTime = std::chrono::steady_clock::now() - start;
+
+    std::vector<Ipv4Address> viaTrie(lookups);
+    start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < lookups; i++)
+    {
+        viaTrie[i] = index.Lookup(headers[i].GetDestination())->GetGateway();
+    }
+    std::chrono::duration<double> trieTime = std::chrono::steady_clock::now() - start;
+
+    uint32_t agree = 0;
+    for (uint32_t i = 0; i < lookups; i++)
+    {
+        agree += (viaStatic[i] == viaTrie[i]);
+    }
+
+    // Removal renumbers the routes and rebuilds the index; the lookups must
+    // still match the routing protocol's.
+    for (uint32_t i = 0; i < removals && routing->GetNRoutes() > 0; i++)
+    {
+        index.RemoveRoute(rng->GetInteger(0, routing->GetNRoutes() - 1));
+    }
+    double agreeAfterRemove = Agreement(routing, index, headers);
+
+    double staticNs = staticTime.count() * 1e9 / lookups;
+    double trieNs = trieTime.count() * 1e9 / lookups;
+    std::cout << nRoutes << "," << staticNs << "," << trieNs << "," << staticNs / trieNs << ","
+              << 100.0 * agree / lookups << "%," << agreeAfterRemove << "%" << std::endl;
+}
+
+int
+main(int argc, char* argv[])
+{
+    std::string sizes("10,1000,100000");
+    uint64_t budget = 20000000; // route comparisons per size for the list walk
+    uint32_t removals = 10;
+
+    CommandLine cmd(__FILE__);
+    cmd.AddValue("sizes", "Comma-separated routing table sizes", sizes);
+    cmd.AddValue("budget", "Roughly lookups x routes per size", budget);
+    cmd.AddValue("removals", "Routes removed before the second comparison", removals);
+    cmd.Parse(argc, argv);
+
+    std::cout << "routes,static_ns_per_lookup,trie_ns_per_lookup,speedup,agree,agree_after_remove"
+              << std::endl;
+    std::istringstream list(sizes);
+    std::string size;
+    while (std::getline(list, size, ','))
+    {
+        uint32_t nRoutes = std::stoul(size);
+        uint32_t lookups = std::max<uint64_t>(1000, std::min<uint64_t>(1000000, budget / nRoutes));
+        RunSize(nRoutes, lookups, removals);
+    }
+
+    Simulator::Destroy();
+    return 0;
+}
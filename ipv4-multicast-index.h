@@ -0,0 +1,357 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Hashed multicast forwarding for routers with many groups.
+ *
+ * Ipv4StaticRouting keeps its multicast routes in a list and walks it for
+ * every multicast packet it forwards, so the cost per packet grows with the
+ * number of groups.  Ipv4MulticastIndex is a routing protocol that only
+ * forwards multicast: its routes live in a hash table keyed by (source,
+ * group, input interface), and a packet that matches no source-specific
+ * route falls back to the (*, group, input interface) route.  The
+ * Ipv4MulticastRoute of every entry is built once when the route is added
+ * and handed to the forwarding callback as is.
+ *
+ * It goes into the node's Ipv4ListRouting ahead of static routing, which
+ * still handles unicast and the sender's default multicast route.
+ *
+ *   Ptr<Ipv4MulticastIndex> index = Ipv4MulticastIndex::Install(router);
+ *   index->AddRoute(Ipv4Address::GetAny(), group, inputDevice, outputDevices);
+ */
+
+#ifndef IPV4_MULTICAST_INDEX_H
+#define IPV4_MULTICAST_INDEX_H
+
+#include "ns3/abort.h"
+#include "ns3/ipv4-list-routing.h"
+#include "ns3/ipv4-route.h"
+#include "ns3/ipv4-routing-protocol.h"
+#include "ns3/ipv4.h"
+#include "ns3/net-device-container.h"
+#include "ns3/node.h"
+#include "ns3/output-stream-wrapper.h"
+#include "ns3/simulator.h"
+
+#include <cstdint>
+#include <iomanip>
+#include <ostream>
+#include <sstream>
+#include <unordered_map>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * Multicast-only routing protocol with a hashed forwarding table.
+ */
+class Ipv4MulticastIndex : public Ipv4RoutingProtocol
+{
+  public:
+    /**
+     * \brief Get the type ID.
+     * \return the object TypeId
+     */
+    static TypeId GetTypeId();
+
+    /**
+     * Add an index to a node's Ipv4ListRouting.
+     * \param node The node.
+     * \param priority Its priority; static routing has 0.
+     * \return the index.
+     */
+    static Ptr<Ipv4MulticastIndex> Install(Ptr<Node> node, int16_t priority = 10);
+
+    /**
+     * Add or replace a route.
+     * \param origin The source, or Ipv4Address::GetAny() for any source.
+     * \param group The multicast group.
+     * \param inputInterface The interface the packets arrive on.
+     * \param outputInterfaces The interfaces to forward them to.
+     */
+    void AddRoute(Ipv4Address origin,
+                  Ipv4Address group,
+                  uint32_t inputInterface,
+                  const std::vector<uint32_t>& outputInterfaces);
+
+    /**
+     * Add or replace a route, like Ipv4StaticRoutingHelper::AddMulticastRoute.
+     * \param origin The source, or Ipv4Address::GetAny() for any source.
+     * \param group The multicast group.
+     * \param input The device the packets arrive on.
+     * \param outputs The devices to forward them to.
+     */
+    void AddRoute(Ipv4Address origin,
+                  Ipv4Address group,
+                  Ptr<NetDevice> input,
+                  NetDeviceContainer outputs);
+
+    /**
+     * Remove a route.
+     * \param origin The source, or Ipv4Address::GetAny().
+     * \param group The multicast group.
+     * \param inputInterface The input interface.
+     * \return whether the route existed.
+     */
+    bool RemoveRoute(Ipv4Address origin, Ipv4Address group, uint32_t inputInterface);
+
+    /** \return the number of routes. */
+    uint32_t GetNRoutes() const;
+
+    /**
+     * Find the route for a packet.
+     * \param origin The source of the packet.
+     * \param group Its destination group.
+     * \param inputInterface The interface it arrived on.
+     * \return the route, or nullptr.
+     */
+    Ptr<Ipv4MulticastRoute> Lookup(Ipv4Address origin,
+                                   Ipv4Address group,
+                                   uint32_t inputInterface) const;
+
+    Ptr<Ipv4Route> RouteOutput(Ptr<Packet> p,
+                               const Ipv4Header& header,
+                               Ptr<NetDevice> oif,
+                               Socket::SocketErrno& sockerr) override;
+    bool RouteInput(Ptr<const Packet> p,
+                    const Ipv4Header& header,
+                    Ptr<const NetDevice> idev,
+                    const UnicastForwardCallback& ucb,
+                    const MulticastForwardCallback& mcb,
+                    const LocalDeliverCallback& lcb,
+                    const ErrorCallback& ecb) override;
+    void NotifyInterfaceUp(uint32_t interface) override;
+    void NotifyInterfaceDown(uint32_t interface) override;
+    void NotifyAddAddress(uint32_t interface, Ipv4InterfaceAddress address) override;
+    void NotifyRemoveAddress(uint32_t interface, Ipv4InterfaceAddress address) override;
+    void SetIpv4(Ptr<Ipv4> ipv4) override;
+    void PrintRoutingTable(Ptr<OutputStreamWrapper> stream,
+                           Time::Unit unit = Time::S) const override;
+
+  private:
+    /** (source, group, input interface). */
+    struct Key
+    {
+        uint32_t origin;    //!< Source, 0 for any.
+        uint32_t group;     //!< Group.
+        uint32_t interface; //!< Input interface.
+
+        /**
+         * \param other Another key.
+         * \return whether both are equal.
+         */
+        bool operator==(const Key& other) const
+        {
+            return origin == other.origin && group == other.group &&
+                   interface == other.interface;
+        }
+    };
+
+    /** Mixes the three fields of a key. */
+    struct KeyHash
+    {
+        /**
+         * \param key The key.
+         * \return its hash.
+         */
+        std::size_t operator()(const Key& key) const
+        {
+            uint64_t h = (uint64_t(key.group) << 32 | key.origin) * 0x9e3779b97f4a7c15ULL;
+            return h ^ (h >> 29) ^ (uint64_t(key.interface) * 0xbf58476d1ce4e5b9ULL);
+        }
+    };
+
+    void DoDispose() override;
+
+    std::unordered_map<Key, Ptr<Ipv4MulticastRoute>, KeyHash> m_routes; //!< Forwarding table.
+    Ptr<Ipv4> m_ipv4;                                                    //!< The node's Ipv4.
+};
+
+NS_OBJECT_ENSURE_REGISTERED(Ipv4MulticastIndex);
+
+TypeId
+Ipv4MulticastIndex::GetTypeId()
+{
+    static TypeId tid = TypeId("ns3::Ipv4MulticastIndex")
+                            .SetParent<Ipv4RoutingProtocol>()
+                            .SetGroupName("Internet")
+                            .AddConstructor<Ipv4MulticastIndex>();
+    return tid;
+}
+
+Ptr<Ipv4MulticastIndex>
+Ipv4MulticastIndex::Install(Ptr<Node> node, int16_t priority)
+{
+    Ptr<Ipv4> ipv4 = node->GetObject<Ipv4>();
+    NS_ABORT_MSG_UNLESS(ipv4, "Ipv4MulticastIndex: node " << node->GetId() << " has no Ipv4");
+    Ptr<Ipv4ListRouting> list = DynamicCast<Ipv4ListRouting>(ipv4->GetRoutingProtocol());
+    NS_ABORT_MSG_UNLESS(list, "Ipv4MulticastIndex needs Ipv4ListRouting");
+    Ptr<Ipv4MulticastIndex> index = CreateObject<Ipv4MulticastIndex>();
+    list->AddRoutingProtocol(index, priority);
+    return index;
+}
+
+void
+Ipv4MulticastIndex::AddRoute(Ipv4Address origin,
+                             Ipv4Address group,
+                             uint32_t inputInterface,
+                             const std::vector<uint32_t>& outputInterfaces)
+{
+    NS_ABORT_MSG_UNLESS(group.IsMulticast(), "Ipv4MulticastIndex: " << group << " is no group");
+    Ptr<Ipv4MulticastRoute> route = Create<Ipv4MulticastRoute>();
+    route->SetOrigin(origin);
+    route->SetGroup(group);
+    route->SetParent(inputInterface);
+    for (uint32_t oif : outputInterfaces)
+    {
+        route->SetOutputTtl(oif, Ipv4MulticastRoute::MAX_TTL - 1);
+    }
+    m_routes[{origin.Get(), group.Get(), inputInterface}] = route;
+}
+
+void
+Ipv4MulticastIndex::AddRoute(Ipv4Address origin,
+                             Ipv4Address group,
+                             Ptr<NetDevice> input,
+                             NetDeviceContainer outputs)
+{
+    NS_ABORT_MSG_UNLESS(m_ipv4, "Ipv4MulticastIndex: not installed");
+    std::vector<uint32_t> oifs;
+    for (uint32_t i = 0; i < outputs.GetN(); i++)
+    {
+        oifs.push_back(m_ipv4->GetInterfaceForDevice(outputs.Get(i)));
+    }
+    AddRoute(origin, group, m_ipv4->GetInterfaceForDevice(input), oifs);
+}
+
+bool
+Ipv4MulticastIndex::RemoveRoute(Ipv4Address origin, Ipv4Address group, uint32_t inputInterface)
+{
+    return m_routes.erase({origin.Get(), group.Get(), inputInterface}) > 0;
+}
+
+uint32_t
+Ipv4MulticastIndex::GetNRoutes() const
+{
+    return m_routes.size();
+}
+
+Ptr<Ipv4MulticastRoute>
+Ipv4MulticastIndex::Lookup(Ipv4Address origin, Ipv4Address group, uint32_t inputInterface) const
+{
+    auto it = m_routes.find({origin.Get(), group.Get(), inputInterface});
+    if (it == m_routes.end())
+    {
+        it = m_routes.find({Ipv4Address::GetAny().Get(), group.Get(), inputInterface});
+    }
+    return it == m_routes.end() ? nullptr : it->second;
+}
+
+Ptr<Ipv4Route>
+Ipv4MulticastIndex::RouteOutput(Ptr<Packet> p,
+                                const Ipv4Header& header,
+                                Ptr<NetDevice> oif,
+                                Socket::SocketErrno& sockerr)
+{
+    // Locally sent multicast keeps using the default multicast route of
+    // static routing.
+    sockerr = Socket::ERROR_NOROUTETOHOST;
+    return nullptr;
+}
+
+bool
+Ipv4MulticastIndex::RouteInput(Ptr<const Packet> p,
+                               const Ipv4Header& header,
+                               Ptr<const NetDevice> idev,
+                               const UnicastForwardCallback& ucb,
+                               const MulticastForwardCallback& mcb,
+                               const LocalDeliverCallback& lcb,
+                               const ErrorCallback& ecb)
+{
+    if (!header.GetDestination().IsMulticast())
+    {
+        return false;
+    }
+    Ptr<Ipv4MulticastRoute> route =
+        Lookup(header.GetSource(), header.GetDestination(), m_ipv4->GetInterfaceForDevice(idev));
+    if (!route)
+    {
+        return false;
+    }
+    mcb(idev, route, p, header);
+    return true;
+}
+
+void
+Ipv4MulticastIndex::NotifyInterfaceUp(uint32_t interface)
+{
+}
+
+void
+Ipv4MulticastIndex::NotifyInterfaceDown(uint32_t interface)
+{
+}
+
+void
+Ipv4MulticastIndex::NotifyAddAddress(uint32_t interface, Ipv4InterfaceAddress address)
+{
+}
+
+void
+Ipv4MulticastIndex::NotifyRemoveAddress(uint32_t interface, Ipv4InterfaceAddress address)
+{
+}
+
+void
+Ipv4MulticastIndex::SetIpv4(Ptr<Ipv4> ipv4)
+{
+    m_ipv4 = ipv4;
+}
+
+void
+Ipv4MulticastIndex::PrintRoutingTable(Ptr<OutputStreamWrapper> stream, Time::Unit unit) const
+{
+    std::ostream* os = stream->GetStream();
+    *os << "Node: " << m_ipv4->GetObject<Node>()->GetId() << ", Time: " << Now().As(unit)
+        << ", Ipv4MulticastIndex table, " << m_routes.size() << " routes" << std::endl;
+    *os << "Origin          Group           Iif  Oifs" << std::endl;
+    for (const auto& [key, route] : m_routes)
+    {
+        std::ostringstream origin;
+        std::ostringstream group;
+        origin << route->GetOrigin();
+        group << route->GetGroup();
+        *os << std::left << std::setw(16) << origin.str() << std::setw(16) << group.str()
+            << std::setw(5) << route->GetParent();
+        for (const auto& [oif, ttl] : route->GetOutputTtlMap())
+        {
+            *os << oif << " ";
+        }
+        *os << std::endl;
+    }
+}
+
+void
+Ipv4MulticastIndex::DoDispose()
+{
+    m_routes.clear();
+    m_ipv4 = nullptr;
+    Ipv4RoutingProtocol::DoDispose();
+}
+
+} // namespace ns3
+
+#endif /* IPV4_MULTICAST_INDEX_H */
@@ -0,0 +1,469 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Longest-prefix-match side index for Ipv4StaticRouting.
+ *
+ * Ipv4StaticRouting keeps its routes in a list and walks all of them on
+ * every lookup.  Ipv4RouteTrie is a multibit trie with a stride of 8 bits
+ * (at most four memory accesses per lookup) built with controlled prefix
+ * expansion.  Ipv4RouteIndex mirrors the route list of one
+ * Ipv4StaticRouting into such a trie.  It is a side index, not a routing
+ * protocol: RouteOutput() still walks the list, and the index only stays in
+ * sync for routes added and removed through it (call Rebuild() after
+ * changing the routes any other way).
+ *
+ *   Ipv4RouteIndex index(staticRouting);
+ *   index.AddNetworkRouteTo("10.2.0.0", "255.255.0.0", "10.1.1.2", 1);
+ *   const Ipv4RoutingTableEntry* route = index.Lookup(destination);
+ */
+
+#ifndef IPV4_ROUTE_TRIE_H
+#define IPV4_ROUTE_TRIE_H
+
+#include "ns3/abort.h"
+#include "ns3/ipv4-address.h"
+#include "ns3/ipv4-routing-table-entry.h"
+#include "ns3/ipv4-static-routing.h"
+#include "ns3/ptr.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <map>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * Stride-8 multibit trie mapping IPv4 prefixes to values.
+ */
+class Ipv4RouteTrie
+{
+  public:
+    Ipv4RouteTrie();
+
+    /**
+     * Add or replace a prefix.
+     * \param network The network address.
+     * \param mask The network mask; must be contiguous.
+     * \param value The value returned by lookups matching this prefix.
+     */
+    void Insert(Ipv4Address network, Ipv4Mask mask, uint32_t value);
+
+    /**
+     * Remove a prefix.
+     * \param network The network address.
+     * \param mask The network mask.
+     * \return whether the prefix was present.
+     */
+    bool Remove(Ipv4Address network, Ipv4Mask mask);
+
+    /**
+     * Find the longest prefix containing an address.
+     * \param dest The address.
+     * \param value The value of the matching prefix.
+     * \return whether a prefix matched.
+     */
+    bool Lookup(Ipv4Address dest, uint32_t& value) const;
+
+    /** Remove all prefixes. */
+    void Clear();
+
+    /** \return the number of prefixes. */
+    uint32_t GetN() const;
+
+  private:
+    static constexpr int32_t NONE = -1; //!< No route / no child.
+
+    /** One of the 256 entries of a node. */
+    struct Slot
+    {
+        int32_t value{NONE}; //!< Value of the longest prefix ending here.
+        uint8_t len{0};      //!< Length of that prefix.
+        int32_t child{NONE}; //!< Next-level node.
+    };
+
+    /** A trie node covers 8 bits of the address. */
+    using Node = std::array<Slot, 256>;
+
+    /**
+     * Walk down to the node holding prefixes of a given length.
+     * \param prefix The prefix.
+     * \param len The prefix length, 1 to 32.
+     * \param create Whether to create missing nodes.
+     * \return the node index, or NONE.
+     */
+    int32_t Descend(uint32_t prefix, uint8_t len, bool create);
+
+    /**
+     * Write a prefix into the slots it expands to, unless they already hold
+     * a longer prefix.
+     * \param node The node.
+     * \param prefix The prefix.
+     * \param len The prefix length.
+     * \param value The value.
+     */
+    void Expand(int32_t node, uint32_t prefix, uint8_t len, int32_t value);
+
+    std::vector<Node> m_nodes; //!< Node 0 is the root.
+    std::map<std::pair<uint8_t, uint32_t>, uint32_t> m_prefixes; //!< (len, prefix) to value.
+    int32_t m_default; //!< Value of 0.0.0.0/0.
+};
+
+Ipv4RouteTrie::Ipv4RouteTrie()
+{
+    Clear();
+}
+
+void
+Ipv4RouteTrie::Clear()
+{
+    m_nodes.assign(1, Node{});
+    m_prefixes.clear();
+    m_default = NONE;
+}
+
+uint32_t
+Ipv4RouteTrie::GetN() const
+{
+    return m_prefixes.size();
+}
+
+int32_t
+Ipv4RouteTrie::Descend(uint32_t prefix, uint8_t len, bool create)
+{
+    int32_t node = 0;
+    for (uint8_t level = 0; len > 8 * (level + 1); level++)
+    {
+        uint8_t byte = prefix >> (24 - 8 * level);
+        int32_t child = m_nodes[node][byte].child;
+        if (child == NONE)
+        {
+            if (!create)
+            {
+                return NONE;
+            }
+            child = m_nodes.size();
+            m_nodes.emplace_back();
+            m_nodes[node][byte].child = child;
+        }
+        node = child;
+    }
+    return node;
+}
+
+void
+Ipv4RouteTrie::Expand(int32_t node, uint32_t prefix, uint8_t len, int32_t value)
+{
+    uint8_t level = (len - 1) / 8;
+    uint8_t bits = len - 8 * level;
+    uint32_t first = (prefix >> (24 - 8 * level)) & 0xff & (0xff << (8 - bits));
+    for (uint32_t i = first; i < first + (1U << (8 - bits)); i++)
+    {
+        Slot& slot = m_nodes[node][i];
+        if (slot.len <= len)
+        {
+            slot.value = value;
+            slot.len = len;
+        }
+    }
+}
+
+void
+Ipv4RouteTrie::Insert(Ipv4Address network, Ipv4Mask mask, uint32_t value)
+{
+    uint8_t len = mask.GetPrefixLength();
+    uint32_t prefix = network.Get() & mask.Get();
+    m_prefixes[{len, prefix}] = value;
+    if (len == 0)
+    {
+        m_default = value;
+        return;
+    }
+    Expand(Descend(prefix, len, true), prefix, len, value);
+}
+
+bool
+Ipv4RouteTrie::Remove(Ipv4Address network, Ipv4Mask mask)
+{
+    uint8_t len = mask.GetPrefixLength();
+    uint32_t prefix = network.Get() & mask.Get();
+    if (m_prefixes.erase({len, prefix}) == 0)
+    {
+        return false;
+    }
+    if (len == 0)
+    {
+        m_default = NONE;
+        return true;
+    }
+
+    // Clear the slots the prefix expanded to, then re-expand the shorter
+    // prefixes of the same node that cover them, shortest first.
+    int32_t node = Descend(prefix, len, false);
+    uint8_t level = (len - 1) / 8;
+    uint8_t bits = len - 8 * level;
+    uint32_t first = (prefix >> (24 - 8 * level)) & 0xff & (0xff << (8 - bits));
+    for (uint32_t i = first; i < first + (1U << (8 - bits)); i++)
+    {
+        Slot& slot = m_nodes[node][i];
+        if (slot.len == len)
+        {
+            slot.value = NONE;
+            slot.len = 0;
+        }
+    }
+    // Outside the cleared range these slots already hold the covering
+    // prefix or a longer one, so only the cleared slots change.
+    for (uint8_t shorter = 8 * level + 1; shorter < len; shorter++)
+    {
+        uint32_t covering = prefix & (~0U << (32 - shorter));
+        auto it = m_prefixes.find({shorter, covering});
+        if (it != m_prefixes.end())
+        {
+            Expand(node, covering, shorter, it->second);
+        }
+    }
+    return true;
+}
+
+bool
+Ipv4RouteTrie::Lookup(Ipv4Address dest, uint32_t& value) const
+{
+    uint32_t addr = dest.Get();
+    int32_t best = m_default;
+    int32_t node = 0;
+    for (uint8_t level = 0; level < 4 && node != NONE; level++)
+    {
+        const Slot& slot = m_nodes[node][(addr >> (24 - 8 * level)) & 0xff];
+        if (slot.value != NONE)
+        {
+            best = slot.value;
+        }
+        node = slot.child;
+    }
+    if (best == NONE)
+    {
+        return false;
+    }
+    value = best;
+    return true;
+}
+
+/**
+ * Longest-prefix-match side index of an Ipv4StaticRouting.
+ *
+ * The index holds its own copy of the routes and only sees those added or
+ * removed through it; routes added to the routing protocol directly (for
+ * example by Ipv4StaticRouting when an interface comes up) are picked up
+ * by Rebuild() only.  Among routes with the same prefix the one with the
+ * lowest metric, then the last added, wins, as in
+ * Ipv4StaticRouting::LookupStatic; interface state is not checked.
+ *
+ * Only Ipv4StaticRouting is supported: Ipv4GlobalRouting takes the first
+ * host, then network, then external route that matches, which is not a
+ * longest prefix match.
+ */
+class Ipv4RouteIndex
+{
+  public:
+    /**
+     * \param routing The routing protocol whose routes are indexed.
+     */
+    Ipv4RouteIndex(Ptr<Ipv4StaticRouting> routing);
+
+    /** Re-read every route of the routing protocol. */
+    void Rebuild();
+
+    /**
+     * Add a network route to the routing protocol and the index.
+     * \param network The network address.
+     * \param mask The network mask.
+     * \param nextHop The gateway.
+     * \param interface The output interface.
+     * \param metric The metric.
+     */
+    void AddNetworkRouteTo(Ipv4Address network,
+                           Ipv4Mask mask,
+                           Ipv4Address nextHop,
+                           uint32_t interface,
+                           uint32_t metric = 0);
+
+    /**
+     * Add a host route to the routing protocol and the index.
+     * \param dest The host address.
+     * \param nextHop The gateway.
+     * \param interface The output interface.
+     * \param metric The metric.
+     */
+    void AddHostRouteTo(Ipv4Address dest,
+                        Ipv4Address nextHop,
+                        uint32_t interface,
+                        uint32_t metric = 0);
+
+    /**
+     * Remove a route from the routing protocol and the index.
+     * \param i The route index, as in Ipv4StaticRouting::GetRoute().
+     */
+    void RemoveRoute(uint32_t i);
+
+    /**
+     * \param dest A destination.
+     * \return the best matching route, or nullptr.
+     */
+    const Ipv4RoutingTableEntry* Lookup(Ipv4Address dest) const;
+
+  private:
+    /** (network, mask) of a prefix. */
+    using Prefix = std::pair<uint32_t, uint32_t>;
+
+    /**
+     * Add a route at the end of the mirrored route list.
+     * \param route The route.
+     * \param metric Its metric.
+     */
+    void Index(const Ipv4RoutingTableEntry& route, uint32_t metric);
+
+    /**
+     * Point the trie at the best remaining route of a prefix, or remove
+     * the prefix if none is left.
+     * \param prefix The prefix.
+     */
+    void Update(Prefix prefix);
+
+    Ptr<Ipv4StaticRouting> m_routing;             //!< Indexed routing protocol.
+    Ipv4RouteTrie m_trie;                         //!< Prefix to entry slot.
+    std::vector<Ipv4RoutingTableEntry> m_entries; //!< Routes by slot.
+    std::vector<uint32_t> m_metrics;              //!< Metric by slot.
+    std::vector<uint32_t> m_freeSlots;            //!< Slots of removed routes.
+    std::vector<uint32_t> m_slots;                //!< Slot of each route, in route index order.
+    std::map<Prefix, std::vector<uint32_t>> m_prefixSlots; //!< Slots per prefix, oldest first.
+};
+
+Ipv4RouteIndex::Ipv4RouteIndex(Ptr<Ipv4StaticRouting> routing)
+    : m_routing(routing)
+{
+    Rebuild();
+}
+
+void
+Ipv4RouteIndex::Rebuild()
+{
+    m_trie.Clear();
+    m_entries.clear();
+    m_metrics.clear();
+    m_freeSlots.clear();
+    m_slots.clear();
+    m_prefixSlots.clear();
+    for (uint32_t i = 0; i < m_routing->GetNRoutes(); i++)
+    {
+        Index(m_routing->GetRoute(i), m_routing->GetMetric(i));
+    }
+}
+
+void
+Ipv4RouteIndex::AddNetworkRouteTo(Ipv4Address network,
+                                  Ipv4Mask mask,
+                                  Ipv4Address nextHop,
+                                  uint32_t interface,
+                                  uint32_t metric)
+{
+    m_routing->AddNetworkRouteTo(network, mask, nextHop, interface, metric);
+    Index(Ipv4RoutingTableEntry::CreateNetworkRouteTo(network, mask, nextHop, interface),
+          metric);
+}
+
+void
+Ipv4RouteIndex::AddHostRouteTo(Ipv4Address dest,
+                               Ipv4Address nextHop,
+                               uint32_t interface,
+                               uint32_t metric)
+{
+    m_routing->AddHostRouteTo(dest, nextHop, interface, metric);
+    Index(Ipv4RoutingTableEntry::CreateHostRouteTo(dest, nextHop, interface), metric);
+}
+
+void
+Ipv4RouteIndex::RemoveRoute(uint32_t i)
+{
+    NS_ABORT_MSG_IF(i >= m_slots.size(),
+                    "Ipv4RouteIndex: no route " << i << ", or routes were added around the index");
+    m_routing->RemoveRoute(i);
+    uint32_t slot = m_slots[i];
+    m_slots.erase(m_slots.begin() + i);
+    m_freeSlots.push_back(slot);
+    const Ipv4RoutingTableEntry& route = m_entries[slot];
+    Prefix prefix{route.GetDestNetwork().Get(), route.GetDestNetworkMask().Get()};
+    std::vector<uint32_t>& slots = m_prefixSlots[prefix];
+    slots.erase(std::find(slots.begin(), slots.end(), slot));
+    Update(prefix);
+}
+
+const Ipv4RoutingTableEntry*
+Ipv4RouteIndex::Lookup(Ipv4Address dest) const
+{
+    uint32_t slot;
+    return m_trie.Lookup(dest, slot) ? &m_entries[slot] : nullptr;
+}
+
+void
+Ipv4RouteIndex::Index(const Ipv4RoutingTableEntry& route, uint32_t metric)
+{
+    uint32_t slot;
+    if (m_freeSlots.empty())
+    {
+        slot = m_entries.size();
+        m_entries.push_back(route);
+        m_metrics.push_back(metric);
+    }
+    else
+    {
+        slot = m_freeSlots.back();
+        m_freeSlots.pop_back();
+        m_entries[slot] = route;
+        m_metrics[slot] = metric;
+    }
+    m_slots.push_back(slot);
+    Prefix prefix{route.GetDestNetwork().Get(), route.GetDestNetworkMask().Get()};
+    m_prefixSlots[prefix].push_back(slot);
+    Update(prefix);
+}
+
+void
+Ipv4RouteIndex::Update(Prefix prefix)
+{
+    auto it = m_prefixSlots.find(prefix);
+    if (it->second.empty())
+    {
+        m_prefixSlots.erase(it);
+        m_trie.Remove(Ipv4Address(prefix.first), Ipv4Mask(prefix.second));
+        return;
+    }
+    uint32_t best = it->second.front();
+    for (uint32_t slot : it->second)
+    {
+        if (m_metrics[slot] <= m_metrics[best])
+        {
+            best = slot;
+        }
+    }
+    m_trie.Insert(Ipv4Address(prefix.first), Ipv4Mask(prefix.second), best);
+}
+
+} // namespace ns3
+
+#endif /* IPV4_ROUTE_TRIE_H */
@@ -22,6 +22,8 @@
 #include "ns3/point-to-point-module.h"
 #include "ns3/netanim-module.h"
 
+#include "shared-payload-source.h"
+
 using namespace ns3;
 
 NS_LOG_COMPONENT_DEFINE ("l4q1b");
@@ -38,8 +40,15 @@ main (int argc, char *argv[])
 
   // Allow the user to override any of the defaults and the above
   // Bind()s at run-time, via command-line arguments
-  //CommandLine cmd (__FILE__);
-  //cmd.Parse (argc, argv);
+  // --burst=K sends the broadcast from a SharedPayloadSource, K packets per
+  // event: K times fewer events, but the K frames of a burst go out back to
+  // back, so the timing on the LAN is not OnOff's (see shared-payload-source.h)
+  uint32_t burst = 1;
+  bool dynamicArp = false;
+  CommandLine cmd (__FILE__);
+  cmd.AddValue ("burst", "Packets per send event, 1 for OnOffApplication; above 1 the frames of a burst leave back to back", burst);
+  cmd.AddValue ("dynamicArp", "Resolve the LAN addresses with ARP instead of filling the caches", dynamicArp);
+  cmd.Parse (argc, argv);
 
   NS_LOG_INFO ("Create nodes.");
   NodeContainer c;
@@ -66,7 +75,15 @@ main (int argc, char *argv[])
   ipv4.SetBase ("10.1.0.0", "255.255.255.0");
   ipv4.Assign (n0);
   ipv4.SetBase ("192.168.1.0", "255.255.255.0");
-  ipv4.Assign (n1);
+  Ipv4InterfaceContainer i1 = ipv4.Assign (n1);
+
+  // Fill the ARP caches of the LAN so the first packets do not wait for
+  // (or broadcast) ARP requests
+  if (!dynamicArp)
+    {
+      NeighborCacheHelper neighborCache;
+      neighborCache.PopulateNeighborCache (i1);
+    }
 
 
   // RFC 863 discard port ("9") indicates packet should be thrown away
@@ -80,8 +97,11 @@ main (int argc, char *argv[])
   OnOffHelper onoff ("ns3::UdpSocketFactory", 
                      Address (InetSocketAddress (Ipv4Address ("255.255.255.255"), port)));
   onoff.SetConstantRate (DataRate ("500kb/s"));
+  SharedPayloadSourceHelper burstSource ("ns3::UdpSocketFactory",
+                                         Address (InetSocketAddress (Ipv4Address ("255.255.255.255"), port)));
+  burstSource.SetAttribute ("BurstSize", UintegerValue (burst));
 
-  ApplicationContainer app = onoff.Install (c0.Get (1));
+  ApplicationContainer app = burst > 1 ? burstSource.Install (c0.Get (1)) : onoff.Install (c0.Get (1));
   // Start the application
   app.Start (Seconds (1.0));
   app.Stop (Seconds (10.0));
@@ -23,6 +23,8 @@
 #include "ns3/internet-module.h"
 #include "ns3/point-to-point-module.h"
 #include "ns3/netanim-module.h"
+
+#include "ipv4-multicast-index.h"
 using namespace ns3;
 
 NS_LOG_COMPONENT_DEFINE ("l4q1m");
@@ -46,8 +48,14 @@ main (int argc, char *argv[])
 
   // Allow the user to override any of the defaults at
   // run-time, via command-line arguments
-  //CommandLine cmd (__FILE__);
-  //cmd.Parse (argc, argv);
+  // --multicastIndex puts the router's multicast route in a hashed
+  // Ipv4MulticastIndex (see multicast-forwarding-bench.cc for many groups)
+  bool multicastIndex = false;
+  bool dynamicArp = false;
+  CommandLine cmd (__FILE__);
+  cmd.AddValue ("multicastIndex", "Route multicast through Ipv4MulticastIndex", multicastIndex);
+  cmd.AddValue ("dynamicArp", "Resolve the LAN addresses with ARP instead of filling the caches", dynamicArp);
+  cmd.Parse (argc, argv);
 
   NS_LOG_INFO ("Create nodes.");
   NodeContainer c;
@@ -78,7 +86,15 @@ main (int argc, char *argv[])
   ipv4Addr.SetBase ("10.1.1.0", "255.255.255.0");
   ipv4Addr.Assign (nd0);
   ipv4Addr.SetBase ("10.1.2.0", "255.255.255.0");
-  ipv4Addr.Assign (nd1);
+  Ipv4InterfaceContainer i1 = ipv4Addr.Assign (nd1);
+
+  // Fill the ARP caches of the LAN so the first packets do not wait for
+  // (or broadcast) ARP requests
+  if (!dynamicArp)
+    {
+      NeighborCacheHelper neighborCache;
+      neighborCache.PopulateNeighborCache (i1);
+    }
 
   NS_LOG_INFO ("Configure multicasting.");
   //
@@ -105,8 +121,16 @@ main (int argc, char *argv[])
   NetDeviceContainer outputDevices;  // A container of output NetDevices
   outputDevices.Add (nd1.Get (1));  // (we only need one NetDevice here)
 
-  multicast.AddMulticastRoute (multicastRouter, multicastSource, 
-                               multicastGroup, inputIf, outputDevices);
+  if (multicastIndex)
+    {
+      Ipv4MulticastIndex::Install (multicastRouter)->AddRoute (multicastSource, multicastGroup,
+                                                               inputIf, outputDevices);
+    }
+  else
+    {
+      multicast.AddMulticastRoute (multicastRouter, multicastSource, 
+                                   multicastGroup, inputIf, outputDevices);
+    }
 
   // 2) Set up a default multicast route on the sender n0 
   Ptr<Node> sender = c.Get (0);
@@ -10,6 +10,9 @@
 #include "ns3/yans-wifi-helper.h"
 #include "ns3/netanim-module.h"
 
+#include "batched-path-loss-model.h"
+#include "lookup-table-error-rate-model.h"
+
 #include <fstream>
 #include <iostream>
 
@@ -42,6 +45,8 @@ private:
   double m_txp;
   bool m_traceMobility;
   uint32_t m_protocol;
+  std::string m_errorModel;
+  std::string m_pathLoss;
 };
 
 RoutingExperiment::RoutingExperiment ()
@@ -50,7 +55,9 @@ RoutingExperiment::RoutingExperiment ()
     packetsReceived (0),
     m_CSVfileName ("manet-routing.output_q2.csv"),
     m_traceMobility (false),
-    m_protocol (2) // AODV
+    m_protocol (2), // AODV
+    m_errorModel ("default"),
+    m_pathLoss ("friis")
 {
 }
 
@@ -126,6 +133,8 @@ RoutingExperiment::CommandSetup (int argc, char **argv)
   cmd.AddValue ("CSVfileName", "The name of the CSV output file name", m_CSVfileName);
   cmd.AddValue ("traceMobility", "Enable mobility tracing", m_traceMobility);
   cmd.AddValue ("protocol", "1=OLSR;2=AODV;3=DSDV;4=DSR", m_protocol);
+  cmd.AddValue ("errorModel", "Error rate model (default, table: Yans from precomputed tables)", m_errorModel);
+  cmd.AddValue ("pathLoss", "Path loss model (friis, batched: Friis for all receivers at once, positions evaluated once per timestamp)", m_pathLoss);
   cmd.Parse (argc, argv);
   return m_CSVfileName;
 }
@@ -186,9 +195,21 @@ RoutingExperiment::Run (int nSinks, double txp, std::string CSVfileName)
 
     YansWifiPhyHelper wifiPhy;
     YansWifiChannelHelper wifiChannel;
-    wifiChannel.SetPropagationDelay("ns3::ConstantSpeedPropagationDelayModel");
-    wifiChannel.AddPropagationLoss("ns3::FriisPropagationLossModel");
+    if (m_pathLoss == "batched")
+    {
+        wifiChannel.SetPropagationDelay("ns3::SnapshotDelayModel");
+        wifiChannel.AddPropagationLoss("ns3::BatchedPathLossModel");
+    }
+    else
+    {
+        wifiChannel.SetPropagationDelay("ns3::ConstantSpeedPropagationDelayModel");
+        wifiChannel.AddPropagationLoss("ns3::FriisPropagationLossModel");
+    }
     wifiPhy.SetChannel(wifiChannel.Create());
+    if (m_errorModel == "table")
+    {
+        wifiPhy.SetErrorRateModel("ns3::LookupTableErrorRateModel");
+    }
 
     // Add a mac and disable rate control
     WifiMacHelper wifiMac;
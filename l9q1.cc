@@ -62,6 +62,17 @@
  *   to a comma-separated value (csv) file
  * - some tracing and flow monitor configuration that used to work is
  *   left commented inline in the program
+ * - with --errorModel=table, receptions use Yans error rates from
+ *   precomputed tables (see lookup-table-error-rate-model.h)
+ * - with --pathLoss=batched, the Friis loss of a transmission is computed
+ *   for all receivers at once (see batched-path-loss-model.h), and loss and
+ *   delay read node positions from one snapshot per timestamp (see
+ *   position-snapshot.h)
+ * - with --profile, a table of wall-clock time per event type (PHY
+ *   reception, routing timers, application sends, trace sinks, ...) and a
+ *   folded-stacks file for flamegraph.pl (see --profileFile)
+ * - at the end, the wall-clock time of Simulator::Run() and the number of
+ *   executed events, to compare runs with and without --profile
  */
 
 #include "ns3/aodv-module.h"
@@ -76,6 +87,11 @@
 #include "ns3/yans-wifi-helper.h"
 #include "ns3/netanim-module.h"
 
+#include "batched-path-loss-model.h"
+#include "lookup-table-error-rate-model.h"
+#include "profiling-simulator-impl.h"
+
+#include <chrono>
 #include <fstream>
 #include <iostream>
 
@@ -138,6 +154,10 @@ class RoutingExperiment
     double m_txp;               //!< Tx power.
     bool m_traceMobility;       //!< Enavle mobility tracing.
     uint32_t m_protocol;        //!< Protocol type.
+    bool m_profile;             //!< Enable the per-event-type profiler.
+    std::string m_profileFile;  //!< Folded-stacks output filename.
+    std::string m_errorModel;   //!< Error rate model (default, table).
+    std::string m_pathLoss;     //!< Path loss model (friis, batched).
 };
 
 RoutingExperiment::RoutingExperiment()
@@ -146,7 +166,11 @@ RoutingExperiment::RoutingExperiment()
       packetsReceived(0),
       m_CSVfileName("manet-routing.output.csv"),
       m_traceMobility(false),
-      m_protocol(2) // AODV
+      m_protocol(2), // AODV
+      m_profile(false),
+      m_profileFile("manet-routing-compare.folded"),
+      m_errorModel("default"),
+      m_pathLoss("friis")
 {
 }
 
@@ -217,7 +241,23 @@ RoutingExperiment::CommandSetup(int argc, char** argv)
     cmd.AddValue("CSVfileName", "The name of the CSV output file name", m_CSVfileName);
     cmd.AddValue("traceMobility", "Enable mobility tracing", m_traceMobility);
     cmd.AddValue("protocol", "1=OLSR;2=AODV;3=DSDV;4=DSR", m_protocol);
+    cmd.AddValue("profile", "Attribute wall-clock time to each event type", m_profile);
+    cmd.AddValue("profileFile", "Folded-stacks output of the profiler", m_profileFile);
+    cmd.AddValue("errorModel",
+                 "Error rate model (default, table: Yans from precomputed tables)",
+                 m_errorModel);
+    cmd.AddValue("pathLoss",
+                 "Path loss model (friis, batched: Friis for all receivers at once, "
+                 "positions evaluated once per timestamp)",
+                 m_pathLoss);
     cmd.Parse(argc, argv);
+
+    // Must be selected before anything touches the simulator.
+    if (m_profile)
+    {
+        GlobalValue::Bind("SimulatorImplementationType",
+                          StringValue("ns3::ProfilingSimulatorImpl"));
+    }
     return m_CSVfileName;
 }
 
@@ -280,9 +320,21 @@ RoutingExperiment::Run(int nSinks, double txp, std::string CSVfileName)
 
     YansWifiPhyHelper wifiPhy;
     YansWifiChannelHelper wifiChannel;
-    wifiChannel.SetPropagationDelay("ns3::ConstantSpeedPropagationDelayModel");
-    wifiChannel.AddPropagationLoss("ns3::FriisPropagationLossModel");
+    if (m_pathLoss == "batched")
+    {
+        wifiChannel.SetPropagationDelay("ns3::SnapshotDelayModel");
+        wifiChannel.AddPropagationLoss("ns3::BatchedPathLossModel");
+    }
+    else
+    {
+        wifiChannel.SetPropagationDelay("ns3::ConstantSpeedPropagationDelayModel");
+        wifiChannel.AddPropagationLoss("ns3::FriisPropagationLossModel");
+    }
     wifiPhy.SetChannel(wifiChannel.Create());
+    if (m_errorModel == "table")
+    {
+        wifiPhy.SetErrorRateModel("ns3::LookupTableErrorRateModel");
+    }
 
     // Add a mac and disable rate control
     WifiMacHelper wifiMac;
@@ -424,7 +476,17 @@ RoutingExperiment::Run(int nSinks, double txp, std::string CSVfileName)
     CheckThroughput();
 
     Simulator::Stop(Seconds(TotalTime));
+    auto start = std::chrono::steady_clock::now();
     Simulator::Run();
+    std::chrono::duration<double> wall = std::chrono::steady_clock::now() - start;
+    std::cout << "Simulator::Run: " << wall.count() << " s wall-clock, "
+              << Simulator::GetEventCount() << " events" << std::endl;
+
+    if (m_profile)
+    {
+        ProfilingSimulatorImpl::PrintReport(std::cout);
+        ProfilingSimulatorImpl::WriteFoldedStacks(m_profileFile);
+    }
 
     // flowmon->SerializeToXmlFile(tr_name + ".flowmon", false, false);
 
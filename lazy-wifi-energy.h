@@ -0,0 +1,297 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Wi-Fi radio energy, integrated only when asked for.
+ *
+ * WifiRadioEnergyModel computes the energy of the previous state at every
+ * PHY state change, hands it to its energy source, which updates the
+ * remaining energy and checks for depletion, and the source also updates
+ * itself periodically (BasicEnergySource: every second).
+ * LazyWifiEnergyMeter only adds the duration of each state the PHY logs
+ * (WifiPhyStateHelper "State" trace) to a per-state total; nothing is
+ * scheduled.  GetEnergy() multiplies the totals by the currents of
+ * WifiRadioEnergyModel (same defaults) and the supply voltage, clipping the
+ * state in progress to the current time.
+ *
+ * The meter also counts the bits each device delivers: MSDUs its MAC
+ * passes up (MacRx) and MPDUs of its own that are acknowledged (AckedMpdu),
+ * so that energy per delivered bit can be reported.  There is no energy
+ * source: a depleted battery does not switch the PHY off.
+ *
+ *   Ptr<LazyWifiEnergyMeter> meter = Create<LazyWifiEnergyMeter>();
+ *   meter->Install(staDevices);
+ *   ...
+ *   Simulator::Run();
+ *   meter->PrintReport(std::cout);
+ */
+
+#ifndef LAZY_WIFI_ENERGY_H
+#define LAZY_WIFI_ENERGY_H
+
+#include "ns3/abort.h"
+#include "ns3/net-device-container.h"
+#include "ns3/simple-ref-count.h"
+#include "ns3/simulator.h"
+#include "ns3/wifi-mac.h"
+#include "ns3/wifi-mpdu.h"
+#include "ns3/wifi-net-device.h"
+#include "ns3/wifi-phy-state-helper.h"
+#include "ns3/wifi-phy-state.h"
+#include "ns3/wifi-phy.h"
+
+#include <array>
+#include <deque>
+#include <ostream>
+
+namespace ns3
+{
+
+/**
+ * Per-device Wi-Fi radio energy from PHY state durations.
+ */
+class LazyWifiEnergyMeter : public SimpleRefCount<LazyWifiEnergyMeter>
+{
+  public:
+    LazyWifiEnergyMeter();
+
+    /**
+     * \param volts The supply voltage, 3 V by default as BasicEnergySource.
+     */
+    void SetVoltage(double volts);
+
+    /**
+     * \param state A PHY state.
+     * \param amperes Its current draw.
+     */
+    void SetCurrent(WifiPhyState state, double amperes);
+
+    /**
+     * Meter the Wi-Fi devices of a container.
+     * \param devices The devices.
+     */
+    void Install(NetDeviceContainer devices);
+
+    /** \return the number of metered devices. */
+    uint32_t GetN() const;
+
+    /**
+     * \param i A metered device.
+     * \return the device.
+     */
+    Ptr<WifiNetDevice> GetDevice(uint32_t i) const;
+
+    /**
+     * \param i A metered device.
+     * \param state A PHY state.
+     * \return the time spent in the state up to now.
+     */
+    Time GetTime(uint32_t i, WifiPhyState state) const;
+
+    /**
+     * \param i A metered device.
+     * \return the energy consumed up to now, in J.
+     */
+    double GetEnergy(uint32_t i) const;
+
+    /**
+     * \param i A metered device.
+     * \return the bits delivered to and by the device up to now.
+     */
+    uint64_t GetDeliveredBits(uint32_t i) const;
+
+    /**
+     * Print one line per device:
+     *   node,energy_j,delivered_bits,energy_per_bit_j
+     * \param os The output stream.
+     */
+    void PrintReport(std::ostream& os) const;
+
+  private:
+    /** The bookkeeping of one device. */
+    struct Radio
+    {
+        Ptr<WifiNetDevice> device; //!< The device.
+        std::array<Time, 7> time;  //!< Time logged per WifiPhyState.
+        Time end;                  //!< End of the last logged state.
+        WifiPhyState last;         //!< The last logged state.
+        uint64_t bits;             //!< Delivered bits.
+    };
+
+    /**
+     * WifiPhyStateHelper "State" sink.
+     * \param radio The device's bookkeeping.
+     * \param start Start of the state.
+     * \param duration Its duration.
+     * \param state The state.
+     */
+    static void StateLogged(Radio* radio, Time start, Time duration, WifiPhyState state);
+
+    /**
+     * WifiMac "MacRx" sink.
+     * \param radio The device's bookkeeping.
+     * \param packet The MSDU passed up.
+     */
+    static void Received(Radio* radio, Ptr<const Packet> packet);
+
+    /**
+     * WifiMac "AckedMpdu" sink.
+     * \param radio The device's bookkeeping.
+     * \param mpdu The acknowledged MPDU.
+     */
+    static void Acked(Radio* radio, Ptr<const WifiMpdu> mpdu);
+
+    double m_volts;                  //!< Supply voltage.
+    std::array<double, 7> m_amperes; //!< Current per WifiPhyState.
+    std::deque<Radio> m_radios;      //!< One per device, never moved.
+};
+
+LazyWifiEnergyMeter::LazyWifiEnergyMeter()
+    : m_volts(3.0)
+{
+    // WifiRadioEnergyModel defaults
+    m_amperes[WifiPhyState::IDLE] = 0.273;
+    m_amperes[WifiPhyState::CCA_BUSY] = 0.273;
+    m_amperes[WifiPhyState::TX] = 0.380;
+    m_amperes[WifiPhyState::RX] = 0.313;
+    m_amperes[WifiPhyState::SWITCHING] = 0.273;
+    m_amperes[WifiPhyState::SLEEP] = 0.033;
+    m_amperes[WifiPhyState::OFF] = 0;
+}
+
+void
+LazyWifiEnergyMeter::SetVoltage(double volts)
+{
+    m_volts = volts;
+}
+
+void
+LazyWifiEnergyMeter::SetCurrent(WifiPhyState state, double amperes)
+{
+    m_amperes[state] = amperes;
+}
+
+void
+LazyWifiEnergyMeter::Install(NetDeviceContainer devices)
+{
+    for (uint32_t i = 0; i < devices.GetN(); i++)
+    {
+        Ptr<WifiNetDevice> device = DynamicCast<WifiNetDevice>(devices.Get(i));
+        NS_ABORT_MSG_UNLESS(device, "LazyWifiEnergyMeter: device " << i << " is not Wi-Fi");
+        m_radios.push_back({device, {}, Simulator::Now(), WifiPhyState::IDLE, 0});
+        Radio* radio = &m_radios.back();
+        device->GetPhy()->GetState()->TraceConnectWithoutContext(
+            "State",
+            MakeBoundCallback(&LazyWifiEnergyMeter::StateLogged, radio));
+        device->GetMac()->TraceConnectWithoutContext(
+            "MacRx",
+            MakeBoundCallback(&LazyWifiEnergyMeter::Received, radio));
+        device->GetMac()->TraceConnectWithoutContext(
+            "AckedMpdu",
+            MakeBoundCallback(&LazyWifiEnergyMeter::Acked, radio));
+    }
+}
+
+void
+LazyWifiEnergyMeter::StateLogged(Radio* radio, Time start, Time duration, WifiPhyState state)
+{
+    radio->time[state] += duration;
+    radio->end = start + duration;
+    radio->last = state;
+}
+
+void
+LazyWifiEnergyMeter::Received(Radio* radio, Ptr<const Packet> packet)
+{
+    radio->bits += 8 * packet->GetSize();
+}
+
+void
+LazyWifiEnergyMeter::Acked(Radio* radio, Ptr<const WifiMpdu> mpdu)
+{
+    radio->bits += 8 * mpdu->GetPacketSize();
+}
+
+uint32_t
+LazyWifiEnergyMeter::GetN() const
+{
+    return m_radios.size();
+}
+
+Ptr<WifiNetDevice>
+LazyWifiEnergyMeter::GetDevice(uint32_t i) const
+{
+    return m_radios.at(i).device;
+}
+
+Time
+LazyWifiEnergyMeter::GetTime(uint32_t i, WifiPhyState state) const
+{
+    const Radio& radio = m_radios.at(i);
+    Time time = radio.time[state];
+    Time now = Simulator::Now();
+    if (radio.end > now)
+    {
+        // A TX or RX is logged with its whole duration when it starts
+        if (state == radio.last)
+        {
+            time -= radio.end - now;
+        }
+    }
+    else if (state == radio.device->GetPhy()->GetState()->GetState())
+    {
+        // The state in progress is logged only when it ends
+        time += now - radio.end;
+    }
+    return time;
+}
+
+double
+LazyWifiEnergyMeter::GetEnergy(uint32_t i) const
+{
+    double charge = 0;
+    for (uint32_t state = 0; state < m_amperes.size(); state++)
+    {
+        charge += m_amperes[state] * GetTime(i, WifiPhyState(state)).GetSeconds();
+    }
+    return m_volts * charge;
+}
+
+uint64_t
+LazyWifiEnergyMeter::GetDeliveredBits(uint32_t i) const
+{
+    return m_radios.at(i).bits;
+}
+
+void
+LazyWifiEnergyMeter::PrintReport(std::ostream& os) const
+{
+    os << "node,energy_j,delivered_bits,energy_per_bit_j" << std::endl;
+    for (uint32_t i = 0; i < GetN(); i++)
+    {
+        double energy = GetEnergy(i);
+        uint64_t bits = GetDeliveredBits(i);
+        os << m_radios[i].device->GetNode()->GetId() << "," << energy << "," << bits << ",";
+        if (bits)
+        {
+            os << energy / bits;
+        }
+        os << std::endl;
+    }
+}
+
+} // namespace ns3
+
+#endif /* LAZY_WIFI_ENERGY_H */
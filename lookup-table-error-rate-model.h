@@ -0,0 +1,433 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Error rate model answering from precomputed tables of a reference model.
+ *
+ * YansErrorRateModel evaluates erfc and, for coded OFDM/HT modes, a sum of
+ * binomial terms over the free distance of the code for every chunk of
+ * every reception.  Its chunk success rate (like NistErrorRateModel's) has
+ * the form q(mode, snr)^nbits, so a table of ln q per mode over an SNR grid
+ * answers every frame size: success = exp(nbits * ln q).  The table of a
+ * (mode, channel width, guard interval, streams, antennas, PPDU field) is
+ * built from the reference model the first time it is needed.  Between
+ * grid points ln(-ln q) is interpolated linearly in dB, which follows the
+ * erfc tails closely; outside [MinSnrDb, MaxSnrDb] the reference model
+ * answers.  error-rate-table-check.cc measures the accuracy and speed.
+ *
+ * With TableFile set, tables are read from that file on first use, and
+ * tables built during the run are written back to it when the model is
+ * disposed, so later runs skip the build.
+ *
+ *   YansWifiPhyHelper wifiPhy;
+ *   wifiPhy.SetErrorRateModel("ns3::LookupTableErrorRateModel",
+ *                             "TableFile", StringValue("yans-per.table"));
+ */
+
+#ifndef LOOKUP_TABLE_ERROR_RATE_MODEL_H
+#define LOOKUP_TABLE_ERROR_RATE_MODEL_H
+
+#include "ns3/abort.h"
+#include "ns3/double.h"
+#include "ns3/error-rate-model.h"
+#include "ns3/pointer.h"
+#include "ns3/string.h"
+#include "ns3/wifi-mode.h"
+#include "ns3/wifi-tx-vector.h"
+#include "ns3/yans-error-rate-model.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <map>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * Interpolated table lookup of the chunk success rate of a reference model.
+ */
+class LookupTableErrorRateModel : public ErrorRateModel
+{
+  public:
+    /**
+     * \brief Get the type ID.
+     * \return the object TypeId
+     */
+    static TypeId GetTypeId();
+
+    LookupTableErrorRateModel();
+
+    /** \return the number of tables built or loaded so far. */
+    uint32_t GetNTables() const;
+
+    /**
+     * Write all tables to a file.
+     * \param filename The file.
+     */
+    void Save(const std::string& filename) const;
+
+    bool IsAwgn() const override;
+
+  private:
+    /** (mode uid, width, guard interval, streams, antennas, PPDU field). */
+    using Key = std::tuple<uint32_t, uint16_t, uint16_t, uint8_t, uint8_t, uint8_t>;
+
+    /** One grid point. */
+    struct Point
+    {
+        double lnQ;  //!< ln of the success rate of one bit.
+        double lnPe; //!< ln(-lnQ), -inf when lnQ is 0, NaN when lnQ is -inf.
+    };
+
+    /** Grid of one key. */
+    struct Table
+    {
+        std::string name;          //!< Key as written to the table file.
+        std::vector<Point> points; //!< Points from MinSnrDb in StepDb steps.
+    };
+
+    double DoGetChunkSuccessRate(WifiMode mode,
+                                 const WifiTxVector& txVector,
+                                 double snr,
+                                 uint64_t nbits,
+                                 uint8_t numRxAntennas,
+                                 WifiPpduField field,
+                                 uint16_t staId) const override;
+    int64_t DoAssignStreams(int64_t stream) override;
+    void NotifyConstructionCompleted() override;
+    void DoDispose() override;
+
+    /**
+     * Build the table of a key from the reference model.
+     * \param name The file name of the key.
+     * \param mode The mode.
+     * \param txVector The TXVECTOR.
+     * \param numRxAntennas The number of receive antennas.
+     * \param field The PPDU field.
+     * \param staId The station.
+     * \return the table.
+     */
+    Table Build(const std::string& name,
+                WifiMode mode,
+                const WifiTxVector& txVector,
+                uint8_t numRxAntennas,
+                WifiPpduField field,
+                uint16_t staId) const;
+
+    /**
+     * \param lnQ ln of a one-bit success rate.
+     * \return the grid point.
+     */
+    static Point MakePoint(double lnQ);
+
+    /** Read TableFile, if it exists. */
+    void Load() const;
+
+    Ptr<ErrorRateModel> m_reference; //!< Model the tables are built from.
+    double m_minSnrDb;               //!< First grid point.
+    double m_maxSnrDb;               //!< Last grid point.
+    double m_stepDb;                 //!< Grid step.
+    std::string m_tableFile;         //!< Table file, empty for none.
+
+    mutable std::map<Key, Table> m_tables;                    //!< Tables in use.
+    mutable std::map<std::string, std::vector<Point>> m_file; //!< Tables read, not yet used.
+    mutable bool m_loaded;                                    //!< Whether TableFile was read.
+    mutable bool m_built;                                     //!< Whether a table was built.
+    mutable const Table* m_last;                              //!< Table of the last lookup.
+    mutable Key m_lastKey;                                    //!< Key of the last lookup.
+};
+
+NS_OBJECT_ENSURE_REGISTERED(LookupTableErrorRateModel);
+
+TypeId
+LookupTableErrorRateModel::GetTypeId()
+{
+    static TypeId tid =
+        TypeId("ns3::LookupTableErrorRateModel")
+            .SetParent<ErrorRateModel>()
+            .SetGroupName("Wifi")
+            .AddConstructor<LookupTableErrorRateModel>()
+            .AddAttribute("Reference",
+                          "Model the tables are built from (YansErrorRateModel if unset)",
+                          PointerValue(),
+                          MakePointerAccessor(&LookupTableErrorRateModel::m_reference),
+                          MakePointerChecker<ErrorRateModel>())
+            .AddAttribute("MinSnrDb",
+                          "Lowest SNR of the tables; below it the reference model answers",
+                          DoubleValue(-10),
+                          MakeDoubleAccessor(&LookupTableErrorRateModel::m_minSnrDb),
+                          MakeDoubleChecker<double>())
+            .AddAttribute("MaxSnrDb",
+                          "Highest SNR of the tables; above it the reference model answers",
+                          DoubleValue(40),
+                          MakeDoubleAccessor(&LookupTableErrorRateModel::m_maxSnrDb),
+                          MakeDoubleChecker<double>())
+            .AddAttribute("StepDb",
+                          "SNR step of the tables",
+                          DoubleValue(0.05),
+                          MakeDoubleAccessor(&LookupTableErrorRateModel::m_stepDb),
+                          MakeDoubleChecker<double>(1e-4))
+            .AddAttribute("TableFile",
+                          "File the tables are read from and written back to, empty for none",
+                          StringValue(""),
+                          MakeStringAccessor(&LookupTableErrorRateModel::m_tableFile),
+                          MakeStringChecker());
+    return tid;
+}
+
+LookupTableErrorRateModel::LookupTableErrorRateModel()
+    : m_minSnrDb(-10),
+      m_maxSnrDb(40),
+      m_stepDb(0.05),
+      m_loaded(false),
+      m_built(false),
+      m_last(nullptr)
+{
+}
+
+uint32_t
+LookupTableErrorRateModel::GetNTables() const
+{
+    return m_tables.size();
+}
+
+void
+LookupTableErrorRateModel::NotifyConstructionCompleted()
+{
+    if (!m_reference)
+    {
+        m_reference = CreateObject<YansErrorRateModel>();
+    }
+    ErrorRateModel::NotifyConstructionCompleted();
+}
+
+bool
+LookupTableErrorRateModel::IsAwgn() const
+{
+    return m_reference->IsAwgn();
+}
+
+LookupTableErrorRateModel::Point
+LookupTableErrorRateModel::MakePoint(double lnQ)
+{
+    if (std::isinf(lnQ))
+    {
+        return {lnQ, std::numeric_limits<double>::quiet_NaN()};
+    }
+    return {lnQ, std::log(-lnQ)};
+}
+
+LookupTableErrorRateModel::Table
+LookupTableErrorRateModel::Build(const std::string& name,
+                                 WifiMode mode,
+                                 const WifiTxVector& txVector,
+                                 uint8_t numRxAntennas,
+                                 WifiPpduField field,
+                                 uint16_t staId) const
+{
+    Table table;
+    table.name = name;
+    auto it = m_file.find(name);
+    if (it != m_file.end())
+    {
+        table.points = std::move(it->second);
+        m_file.erase(it);
+        return table;
+    }
+
+    uint32_t n = std::lround((m_maxSnrDb - m_minSnrDb) / m_stepDb) + 1;
+    table.points.reserve(n);
+    for (uint32_t i = 0; i < n; i++)
+    {
+        double snr = std::pow(10.0, (m_minSnrDb + i * m_stepDb) / 10);
+        double q =
+            m_reference->GetChunkSuccessRate(mode, txVector, snr, 1, numRxAntennas, field, staId);
+        table.points.push_back(MakePoint(std::log(q)));
+    }
+
+    // The tables rely on success(nbits) = success(1)^nbits
+    for (uint32_t i = 0; i < n; i += 20)
+    {
+        double snr = std::pow(10.0, (m_minSnrDb + i * m_stepDb) / 10);
+        double q1000 = m_reference->GetChunkSuccessRate(mode,
+                                                        txVector,
+                                                        snr,
+                                                        1000,
+                                                        numRxAntennas,
+                                                        field,
+                                                        staId);
+        NS_ABORT_MSG_UNLESS(std::abs(std::exp(1000 * table.points[i].lnQ) - q1000) <= 1e-9,
+                            "LookupTableErrorRateModel: the reference model's success rate for "
+                                << mode << " is not of the form q^nbits");
+    }
+    m_built = true;
+    return table;
+}
+
+double
+LookupTableErrorRateModel::DoGetChunkSuccessRate(WifiMode mode,
+                                                 const WifiTxVector& txVector,
+                                                 double snr,
+                                                 uint64_t nbits,
+                                                 uint8_t numRxAntennas,
+                                                 WifiPpduField field,
+                                                 uint16_t staId) const
+{
+    if (nbits == 0)
+    {
+        return 1;
+    }
+    double snrDb = 10 * std::log10(snr);
+    double x = (snrDb - m_minSnrDb) / m_stepDb;
+    if (!(x >= 0) || snrDb >= m_maxSnrDb)
+    {
+        return m_reference
+            ->GetChunkSuccessRate(mode, txVector, snr, nbits, numRxAntennas, field, staId);
+    }
+
+    Key key{mode.GetUid(),
+            txVector.GetChannelWidth(),
+            txVector.GetGuardInterval(),
+            txVector.GetNss(staId),
+            numRxAntennas,
+            field};
+    if (!m_last || key != m_lastKey)
+    {
+        auto it = m_tables.find(key);
+        if (it == m_tables.end())
+        {
+            if (!m_loaded)
+            {
+                Load();
+            }
+            std::ostringstream name;
+            name << mode.GetUniqueName() << " " << std::get<1>(key) << " " << std::get<2>(key)
+                 << " " << +std::get<3>(key) << " " << +numRxAntennas << " " << +std::get<5>(key);
+            Table table = Build(name.str(), mode, txVector, numRxAntennas, field, staId);
+            it = m_tables.emplace(key, std::move(table)).first;
+        }
+        m_last = &it->second;
+        m_lastKey = key;
+    }
+
+    const std::vector<Point>& points = m_last->points;
+    uint32_t i = x;
+    double f = x - i;
+    const Point& a = points[i];
+    const Point& b = points[std::min<std::size_t>(i + 1, points.size() - 1)];
+    double lnQ;
+    if (std::isfinite(a.lnPe) && std::isfinite(b.lnPe))
+    {
+        lnQ = -std::exp(a.lnPe + f * (b.lnPe - a.lnPe));
+    }
+    else
+    {
+        lnQ = a.lnQ + f * (b.lnQ - a.lnQ);
+    }
+    return std::exp(nbits * lnQ);
+}
+
+int64_t
+LookupTableErrorRateModel::DoAssignStreams(int64_t stream)
+{
+    return m_reference ? m_reference->AssignStreams(stream) : 0;
+}
+
+void
+LookupTableErrorRateModel::Load() const
+{
+    m_loaded = true;
+    std::ifstream in(m_tableFile);
+    if (m_tableFile.empty() || !in)
+    {
+        return;
+    }
+    std::string header;
+    while (std::getline(in, header))
+    {
+        // "<mode> <width> <gi> <nss> <antennas> <field>|<min> <step> <n>" then n values
+        std::size_t bar = header.find('|');
+        NS_ABORT_MSG_IF(bar == std::string::npos, m_tableFile << ": bad table header " << header);
+        std::istringstream grid(header.substr(bar + 1));
+        double minDb;
+        double stepDb;
+        uint32_t n;
+        NS_ABORT_MSG_UNLESS(grid >> minDb >> stepDb >> n, m_tableFile << ": bad grid " << header);
+        std::vector<Point> points;
+        points.reserve(n);
+        for (uint32_t i = 0; i < n; i++)
+        {
+            std::string value; // may be -inf, which operator>> does not read
+            NS_ABORT_MSG_UNLESS(in >> value, m_tableFile << ": truncated table " << header);
+            points.push_back(MakePoint(std::strtod(value.c_str(), nullptr)));
+        }
+        in >> std::ws;
+        // Tables of another grid are rebuilt
+        if (minDb == m_minSnrDb && stepDb == m_stepDb &&
+            n == std::lround((m_maxSnrDb - m_minSnrDb) / m_stepDb) + 1)
+        {
+            m_file[header.substr(0, bar)] = std::move(points);
+        }
+    }
+}
+
+void
+LookupTableErrorRateModel::Save(const std::string& filename) const
+{
+    std::ofstream out(filename);
+    NS_ABORT_MSG_UNLESS(out, "Cannot write " << filename);
+    out << std::setprecision(17);
+    auto write = [&out, this](const std::string& name, const std::vector<Point>& points) {
+        out << name << "|" << m_minSnrDb << " " << m_stepDb << " " << points.size() << "\n";
+        for (const auto& point : points)
+        {
+            out << point.lnQ << "\n";
+        }
+    };
+    for (const auto& [key, table] : m_tables)
+    {
+        write(table.name, table.points);
+    }
+    // Tables read from the file but not used in this run are kept
+    for (const auto& [name, points] : m_file)
+    {
+        write(name, points);
+    }
+}
+
+void
+LookupTableErrorRateModel::DoDispose()
+{
+    if (m_built && !m_tableFile.empty())
+    {
+        Save(m_tableFile);
+    }
+    m_tables.clear();
+    m_file.clear();
+    m_last = nullptr;
+    m_reference = nullptr;
+    ErrorRateModel::DoDispose();
+}
+
+} // namespace ns3
+
+#endif /* LOOKUP_TABLE_ERROR_RATE_MODEL_H */
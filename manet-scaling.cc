@@ -0,0 +1,461 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Scaling of the l9q1.cc MANET with the number of nodes.
+ *
+ * The l9q1.cc scenario (802.11b ad hoc at 11 Mbps, Friis, 7.5 dBm, random
+ * waypoint up to 20 m/s, 64-byte UDP at 2048 bps from node i + flows to
+ * node i) is run for each of --nodes, with one flow per five nodes as in
+ * l9q1.cc (10 of 50).  Two series are run, see --scaling:
+ * - density: the 300 x 1500 m rectangle grows with the node count, so
+ *   every node keeps as many neighbours as in l9q1.cc;
+ * - area: the rectangle stays 300 x 1500 m, so the neighbours per node
+ *   grow with the node count.
+ * Each point runs in a forked process, one at a time so that the
+ * wall-clock times do not compete, under ProfilingSimulatorImpl (see
+ * profiling-simulator-impl.h).  The executed events are summed per
+ * subsystem by the class they call: PHY (WifiPhy, channel), MAC (WifiMac,
+ * Txop, station managers), routing (the routing protocol, IPv4, ARP),
+ * applications (OnOff, sockets, UDP), tracing (the receive sink, which
+ * writes each packet as l9q1.cc prints it, and the per-second counter);
+ * the rest (mobility, ...) is other.  Time spent below an event counts
+ * for the event's subsystem, except trace sinks, which are carved out.
+ *
+ * One line is printed per point:
+ *   scaling,nodes,width_m,height_m,flows,wall_s,events,events_per_s,max_rss_kb,
+ *   phy_s,mac_s,routing_s,app_s,tracing_s,other_s,exponent,baseline_ratio
+ * where exponent is log(wall ratio) / log(node ratio) against the previous
+ * point of the series: about 1 at constant density, up to 2 at constant
+ * area.  Save the report of one build and pass it to the next with
+ * --baseline: baseline_ratio is then the wall-clock ratio per point, and a
+ * point whose exponent grows by more than --tolerance is reported as a
+ * super-linear regression and makes the program exit with status 1.
+ *
+ *   ./ns3 run "scratch/manet-scaling --nodes=50,100,200,500" > before.csv
+ *   ./ns3 run "scratch/manet-scaling --nodes=50,100,200,500 --baseline=before.csv"
+ */
+
+#include "ns3/aodv-module.h"
+#include "ns3/applications-module.h"
+#include "ns3/core-module.h"
+#include "ns3/dsdv-module.h"
+#include "ns3/dsr-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/mobility-module.h"
+#include "ns3/network-module.h"
+#include "ns3/olsr-module.h"
+#include "ns3/yans-wifi-helper.h"
+
+#include "batched-path-loss-model.h"
+#include "profiling-simulator-impl.h"
+
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace ns3;
+using namespace dsr;
+
+NS_LOG_COMPONENT_DEFINE("ManetScaling");
+
+static uint64_t g_packets = 0; //!< Packets received in the current second.
+static std::ofstream g_trace;  //!< Per-packet receive lines.
+
+/**
+ * Socket receive sink, as RoutingExperiment::ReceivePacket in l9q1.cc.
+ * \param socket The receiving socket.
+ */
+static void
+ReceivePacket(Ptr<Socket> socket)
+{
+    ProfilingSimulatorImpl::Section section("[tracing]");
+    Ptr<Packet> packet;
+    Address from;
+    while ((packet = socket->RecvFrom(from)))
+    {
+        g_packets++;
+        g_trace << Simulator::Now().GetSeconds() << " " << socket->GetNode()->GetId()
+                << " received one packet from " << InetSocketAddress::ConvertFrom(from).GetIpv4()
+                << "\n";
+    }
+}
+
+/**
+ * Per-second received packet count, as RoutingExperiment::CheckThroughput.
+ */
+static void
+CheckThroughput()
+{
+    ProfilingSimulatorImpl::Section section("[tracing]");
+    g_trace << "# " << Simulator::Now().GetSeconds() << " s: " << g_packets << " packets\n";
+    g_packets = 0;
+    Simulator::Schedule(Seconds(1.0), &CheckThroughput);
+}
+
+/**
+ * \param entry A profiled event type.
+ * \return its subsystem: 0 PHY, 1 MAC, 2 routing, 3 applications,
+ * 4 tracing, 5 other.
+ */
+static uint32_t
+Subsystem(const ProfilingSimulatorImpl::Entry& entry)
+{
+    static const std::vector<std::vector<std::string>> patterns{
+        {"Phy", "YansWifiChannel", "InterferenceHelper", "Propagation"},
+        {"Mac", "Txop", "ChannelAccessManager", "FrameExchangeManager", "StationManager",
+         "BlockAck", "WifiNetDevice"},
+        {"aodv::", "olsr::", "dsdv::", "dsr::", "Ipv4", "Arp", "Icmpv4"},
+        {"Application", "OnOff", "PacketSink", "Udp", "Socket"},
+        {"[tracing]", "Trace", "Ascii", "Pcap"}};
+    // Events bound to free or static functions are known by their arguments
+    const std::string& name = entry.owner == "(function)" ? entry.name : entry.owner;
+    for (uint32_t i = 0; i < patterns.size(); i++)
+    {
+        for (const auto& pattern : patterns[i])
+        {
+            if (name.find(pattern) != std::string::npos)
+            {
+                return i;
+            }
+        }
+    }
+    return patterns.size();
+}
+
+/**
+ * Run one point.
+ * \param scaling density or area.
+ * \param nodes The number of nodes.
+ * \param protocol 1=OLSR;2=AODV;3=DSDV;4=DSR.
+ * \param pathLoss friis or batched.
+ * \param warmup Seconds before the flows start.
+ * \param duration Seconds of traffic.
+ * \return the report line, without exponent and baseline_ratio.
+ */
+static std::string
+RunPoint(const std::string& scaling,
+         uint32_t nodes,
+         uint32_t protocol,
+         const std::string& pathLoss,
+         double warmup,
+         double duration)
+{
+    // Must be selected before anything touches the simulator
+    GlobalValue::Bind("SimulatorImplementationType", StringValue("ns3::ProfilingSimulatorImpl"));
+
+    double scale = scaling == "density" ? std::sqrt(nodes / 50.0) : 1;
+    double width = 300 * scale;
+    double height = 1500 * scale;
+    uint32_t flows = std::max(1U, nodes / 5);
+    std::string phyMode("DsssRate11Mbps");
+
+    Config::SetDefault("ns3::OnOffApplication::PacketSize", StringValue("64"));
+    Config::SetDefault("ns3::OnOffApplication::DataRate", StringValue("2048bps"));
+    Config::SetDefault("ns3::WifiRemoteStationManager::NonUnicastMode", StringValue(phyMode));
+
+    NodeContainer adhocNodes;
+    adhocNodes.Create(nodes);
+
+    WifiHelper wifi;
+    wifi.SetStandard(WIFI_STANDARD_80211b);
+    YansWifiPhyHelper wifiPhy;
+    YansWifiChannelHelper wifiChannel;
+    if (pathLoss == "batched")
+    {
+        wifiChannel.SetPropagationDelay("ns3::SnapshotDelayModel");
+        wifiChannel.AddPropagationLoss("ns3::BatchedPathLossModel");
+    }
+    else
+    {
+        wifiChannel.SetPropagationDelay("ns3::ConstantSpeedPropagationDelayModel");
+        wifiChannel.AddPropagationLoss("ns3::FriisPropagationLossModel");
+    }
+    wifiPhy.SetChannel(wifiChannel.Create());
+    WifiMacHelper wifiMac;
+    wifi.SetRemoteStationManager("ns3::ConstantRateWifiManager",
+                                 "DataMode",
+                                 StringValue(phyMode),
+                                 "ControlMode",
+                                 StringValue(phyMode));
+    wifiPhy.Set("TxPowerStart", DoubleValue(7.5));
+    wifiPhy.Set("TxPowerEnd", DoubleValue(7.5));
+    wifiMac.SetType("ns3::AdhocWifiMac");
+    NetDeviceContainer adhocDevices = wifi.Install(wifiPhy, wifiMac, adhocNodes);
+
+    MobilityHelper mobilityAdhoc;
+    int64_t streamIndex = 0;
+    ObjectFactory pos;
+    pos.SetTypeId("ns3::RandomRectanglePositionAllocator");
+    pos.Set("X",
+            StringValue("ns3::UniformRandomVariable[Min=0.0|Max=" + std::to_string(width) + "]"));
+    pos.Set("Y",
+            StringValue("ns3::UniformRandomVariable[Min=0.0|Max=" + std::to_string(height) + "]"));
+    Ptr<PositionAllocator> taPositionAlloc = pos.Create()->GetObject<PositionAllocator>();
+    streamIndex += taPositionAlloc->AssignStreams(streamIndex);
+    mobilityAdhoc.SetMobilityModel("ns3::RandomWaypointMobilityModel",
+                                   "Speed",
+                                   StringValue("ns3::UniformRandomVariable[Min=0.0|Max=20.0]"),
+                                   "Pause",
+                                   StringValue("ns3::ConstantRandomVariable[Constant=0.0]"),
+                                   "PositionAllocator",
+                                   PointerValue(taPositionAlloc));
+    mobilityAdhoc.SetPositionAllocator(taPositionAlloc);
+    mobilityAdhoc.Install(adhocNodes);
+    streamIndex += mobilityAdhoc.AssignStreams(adhocNodes, streamIndex);
+
+    AodvHelper aodv;
+    OlsrHelper olsr;
+    DsdvHelper dsdv;
+    DsrHelper dsr;
+    DsrMainHelper dsrMain;
+    Ipv4ListRoutingHelper list;
+    InternetStackHelper internet;
+    switch (protocol)
+    {
+    case 1:
+        list.Add(olsr, 100);
+        break;
+    case 2:
+        list.Add(aodv, 100);
+        break;
+    case 3:
+        list.Add(dsdv, 100);
+        break;
+    case 4:
+        break;
+    default:
+        NS_FATAL_ERROR("No such protocol:" << protocol);
+    }
+    if (protocol < 4)
+    {
+        internet.SetRoutingHelper(list);
+        internet.Install(adhocNodes);
+    }
+    else
+    {
+        internet.Install(adhocNodes);
+        dsrMain.Install(dsr, adhocNodes);
+    }
+
+    Ipv4AddressHelper addressAdhoc;
+    addressAdhoc.SetBase("10.0.0.0", "255.255.0.0");
+    Ipv4InterfaceContainer adhocInterfaces = addressAdhoc.Assign(adhocDevices);
+
+    uint16_t port = 9;
+    OnOffHelper onoff1("ns3::UdpSocketFactory", Address());
+    onoff1.SetAttribute("OnTime", StringValue("ns3::ConstantRandomVariable[Constant=1.0]"));
+    onoff1.SetAttribute("OffTime", StringValue("ns3::ConstantRandomVariable[Constant=0.0]"));
+    Ptr<UniformRandomVariable> var = CreateObject<UniformRandomVariable>();
+    for (uint32_t i = 0; i < flows; i++)
+    {
+        Ptr<Socket> sink = Socket::CreateSocket(adhocNodes.Get(i), UdpSocketFactory::GetTypeId());
+        sink->Bind(InetSocketAddress(adhocInterfaces.GetAddress(i), port));
+        sink->SetRecvCallback(MakeCallback(&ReceivePacket));
+
+        onoff1.SetAttribute("Remote",
+                            AddressValue(InetSocketAddress(adhocInterfaces.GetAddress(i), port)));
+        ApplicationContainer temp = onoff1.Install(adhocNodes.Get((i + flows) % nodes));
+        temp.Start(Seconds(var->GetValue(warmup, warmup + 1)));
+        temp.Stop(Seconds(warmup + duration));
+    }
+
+    g_trace.open("manet-scaling-" + scaling + "-" + std::to_string(nodes) + ".tr");
+    CheckThroughput();
+
+    auto start = std::chrono::steady_clock::now();
+    Simulator::Stop(Seconds(warmup + duration));
+    Simulator::Run();
+    std::chrono::duration<double> wall = std::chrono::steady_clock::now() - start;
+    g_trace.close();
+
+    std::vector<double> subsystems(6, 0);
+    for (const auto& entry : ProfilingSimulatorImpl::GetEntries())
+    {
+        subsystems[Subsystem(entry)] += entry.stats.wall.count() / 1e9;
+    }
+    uint64_t events = Simulator::GetEventCount();
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+
+    std::ostringstream line;
+    line << scaling << "," << nodes << "," << width << "," << height << "," << flows << ","
+         << wall.count() << "," << events << "," << events / wall.count() << ","
+         << usage.ru_maxrss;
+    for (double seconds : subsystems)
+    {
+        line << "," << seconds;
+    }
+
+    Simulator::Destroy();
+    return line.str();
+}
+
+/**
+ * \param line A report line.
+ * \return its comma-separated fields.
+ */
+static std::vector<std::string>
+Split(const std::string& line)
+{
+    std::vector<std::string> fields;
+    std::istringstream stream(line);
+    std::string field;
+    while (std::getline(stream, field, ','))
+    {
+        fields.push_back(field);
+    }
+    return fields;
+}
+
+int
+main(int argc, char* argv[])
+{
+    std::string nodeList("50,100,200,500,1000,2000,5000");
+    std::string scaling("both");
+    uint32_t protocol = 2;
+    std::string pathLoss("friis");
+    double warmup = 10;
+    double duration = 20;
+    std::string baseline;
+    double tolerance = 0.15;
+
+    CommandLine cmd(__FILE__);
+    cmd.AddValue("nodes", "Comma-separated node counts", nodeList);
+    cmd.AddValue("scaling", "Series to run (density, area, both)", scaling);
+    cmd.AddValue("protocol", "1=OLSR;2=AODV;3=DSDV;4=DSR", protocol);
+    cmd.AddValue("pathLoss", "Path loss model (friis, batched)", pathLoss);
+    cmd.AddValue("warmup", "Seconds of routing before the flows start", warmup);
+    cmd.AddValue("duration", "Seconds of traffic", duration);
+    cmd.AddValue("baseline", "Report of a previous build to compare against", baseline);
+    cmd.AddValue("tolerance", "Exponent increase reported as a regression", tolerance);
+    cmd.Parse(argc, argv);
+
+    NS_ABORT_MSG_UNLESS(scaling == "density" || scaling == "area" || scaling == "both",
+                        "Unknown scaling " << scaling);
+    NS_ABORT_MSG_UNLESS(pathLoss == "friis" || pathLoss == "batched",
+                        "Unknown path loss " << pathLoss);
+
+    std::vector<uint32_t> counts;
+    for (const auto& count : Split(nodeList))
+    {
+        counts.push_back(std::stoul(count));
+        NS_ABORT_MSG_UNLESS(counts.back() >= 2, "Need at least two nodes");
+    }
+    std::vector<std::string> series;
+    if (scaling == "both")
+    {
+        series = {"density", "area"};
+    }
+    else
+    {
+        series = {scaling};
+    }
+
+    // (scaling, nodes) -> (wall_s, exponent) of the baseline
+    std::map<std::pair<std::string, uint32_t>, std::pair<double, std::string>> base;
+    if (!baseline.empty())
+    {
+        std::ifstream in(baseline);
+        NS_ABORT_MSG_UNLESS(in, "Cannot read " << baseline);
+        std::string line;
+        while (std::getline(in, line))
+        {
+            std::vector<std::string> fields = Split(line);
+            if (fields.size() >= 16 && fields[0] != "scaling")
+            {
+                base[{fields[0], std::stoul(fields[1])}] = {std::stod(fields[5]), fields[15]};
+            }
+        }
+    }
+
+    std::cout << "scaling,nodes,width_m,height_m,flows,wall_s,events,events_per_s,max_rss_kb,"
+              << "phy_s,mac_s,routing_s,app_s,tracing_s,other_s,exponent,baseline_ratio"
+              << std::endl;
+    bool regression = false;
+    for (const auto& s : series)
+    {
+        uint32_t previousNodes = 0;
+        double previousWall = 0;
+        for (uint32_t nodes : counts)
+        {
+            // One process per point: ns-3 keeps global simulation state,
+            // and the peak RSS must be that of this point alone.
+            int fds[2];
+            NS_ABORT_MSG_IF(pipe(fds) != 0, "pipe() failed");
+            pid_t pid = fork();
+            NS_ABORT_MSG_IF(pid < 0, "fork() failed");
+            if (pid == 0)
+            {
+                close(fds[0]);
+                std::string line = RunPoint(s, nodes, protocol, pathLoss, warmup, duration);
+                NS_ABORT_MSG_IF(write(fds[1], line.data(), line.size()) < 0, "write() failed");
+                _exit(0);
+            }
+            close(fds[1]);
+            std::string line;
+            char buffer[256];
+            ssize_t n;
+            while ((n = read(fds[0], buffer, sizeof(buffer))) > 0)
+            {
+                line.append(buffer, n);
+            }
+            close(fds[0]);
+            int status;
+            waitpid(pid, &status, 0);
+            if (line.empty() || !WIFEXITED(status) || WEXITSTATUS(status) != 0)
+            {
+                std::cout << s << "," << nodes << ",failed" << std::endl;
+                previousNodes = 0;
+                continue;
+            }
+
+            double wall = std::stod(Split(line)[5]);
+            std::string exponent;
+            if (previousNodes)
+            {
+                exponent = std::to_string(std::log(wall / previousWall) /
+                                          std::log(double(nodes) / previousNodes));
+            }
+            std::string ratio;
+            auto it = base.find({s, nodes});
+            if (it != base.end())
+            {
+                ratio = std::to_string(wall / it->second.first);
+                if (!exponent.empty() && !it->second.second.empty() &&
+                    std::stod(exponent) > std::stod(it->second.second) + tolerance)
+                {
+                    std::cerr << "# super-linear regression: " << s << " " << previousNodes
+                              << " -> " << nodes << " nodes, exponent " << it->second.second
+                              << " -> " << exponent << std::endl;
+                    regression = true;
+                }
+            }
+            std::cout << line << "," << exponent << "," << ratio << std::endl;
+            previousNodes = nodes;
+            previousWall = wall;
+        }
+    }
+    return regression ? 1 : 0;
+}
@@ -0,0 +1,195 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Cost of co-located BSSs on different channels.
+ *
+ * The wirelesslatest.cc cell scaled up: --aps APs, 10 m apart on a line,
+ * each with --stas STAs 5 m away and its own SSID.  AP i operates on the
+ * i-th 20 MHz channel of the 5 GHz band (36, 40, ..., 165, then again), so
+ * with up to 25 APs no two BSSs overlap.  Every AP sends --rate of UDP to
+ * each of its STAs for --duration seconds.
+ *
+ * With --partition=shared all PHYs are attached to one YansWifiChannel, as
+ * in wirelesslatest.cc; with --partition=split each group of overlapping
+ * channels gets its own (see wifi-channel-partition.h).  Both runs should
+ * deliver the same packets; what changes is the events they take.
+ *
+ * One line is printed:
+ *   partition,aps,stas,channels,events,rx_packets,wall_s,max_rss_kb
+ *
+ *   ./ns3 run "scratch/multi-ap-bench --aps=24 --partition=shared"
+ *   ./ns3 run "scratch/multi-ap-bench --aps=24 --partition=split"
+ */
+
+#include "ns3/applications-module.h"
+#include "ns3/core-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/mobility-module.h"
+#include "ns3/network-module.h"
+#include "ns3/wifi-module.h"
+
+#include "wifi-channel-partition.h"
+
+#include <sys/resource.h>
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <string>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE("MultiApBench");
+
+static uint64_t g_received = 0; //!< Packets received by the STAs.
+
+/**
+ * Count a packet received by a sink.
+ * \param packet The packet.
+ * \param from Its source.
+ */
+static void
+Received(Ptr<const Packet> packet, const Address& from)
+{
+    g_received++;
+}
+
+int
+main(int argc, char* argv[])
+{
+    uint32_t aps = 8;
+    uint32_t stas = 2;
+    std::string rate("1Mbps");
+    double duration = 5;
+    std::string partition("split");
+
+    CommandLine cmd(__FILE__);
+    cmd.AddValue("aps", "Number of APs", aps);
+    cmd.AddValue("stas", "STAs per AP", stas);
+    cmd.AddValue("rate", "UDP rate from an AP to each of its STAs", rate);
+    cmd.AddValue("duration", "Simulated seconds of traffic", duration);
+    cmd.AddValue("partition", "YansWifiChannels (shared, split)", partition);
+    cmd.Parse(argc, argv);
+
+    NS_ABORT_MSG_UNLESS(partition == "shared" || partition == "split",
+                        "Unknown partition " << partition);
+    NS_ABORT_MSG_UNLESS(aps >= 1 && stas >= 1, "Need at least one AP and one STA");
+
+    std::vector<uint8_t> numbers;
+    for (uint8_t number = 36; number <= 64; number += 4)
+    {
+        numbers.push_back(number);
+    }
+    for (uint8_t number = 100; number <= 144; number += 4)
+    {
+        numbers.push_back(number);
+    }
+    for (uint8_t number = 149; number <= 165; number += 4)
+    {
+        numbers.push_back(number);
+    }
+
+    YansWifiChannelHelper channelHelper = YansWifiChannelHelper::Default();
+    WifiChannelPartition channels(channelHelper);
+    for (uint32_t i = 0; i < aps; i++)
+    {
+        channels.Add(numbers[i % numbers.size()], 20, WIFI_PHY_BAND_5GHZ);
+    }
+    Ptr<YansWifiChannel> shared = channelHelper.Create();
+
+    WifiHelper wifi;
+    wifi.SetStandard(WIFI_STANDARD_80211a);
+    wifi.SetRemoteStationManager("ns3::ConstantRateWifiManager",
+                                 "DataMode",
+                                 StringValue("OfdmRate24Mbps"),
+                                 "ControlMode",
+                                 StringValue("OfdmRate6Mbps"));
+    WifiMacHelper mac;
+    YansWifiPhyHelper phy;
+    InternetStackHelper internet;
+    Ipv4AddressHelper ipv4;
+    ipv4.SetBase("10.0.0.0", "255.255.255.0");
+    MobilityHelper mobility;
+    Ptr<ListPositionAllocator> positions = CreateObject<ListPositionAllocator>();
+    mobility.SetPositionAllocator(positions);
+    uint16_t port = 9;
+    PacketSinkHelper sink("ns3::UdpSocketFactory", InetSocketAddress(Ipv4Address::GetAny(), port));
+
+    for (uint32_t i = 0; i < aps; i++)
+    {
+        uint8_t number = numbers[i % numbers.size()];
+        phy.SetChannel(partition == "split" ? channels.Get(number, 20, WIFI_PHY_BAND_5GHZ)
+                                            : shared);
+        phy.Set("ChannelSettings",
+                StringValue("{" + std::to_string(number) + ", 20, BAND_5GHZ, 0}"));
+        Ssid ssid("bss-" + std::to_string(i));
+
+        NodeContainer ap;
+        ap.Create(1);
+        NodeContainer sta;
+        sta.Create(stas);
+        mac.SetType("ns3::ApWifiMac", "Ssid", SsidValue(ssid));
+        NetDeviceContainer apDevice = wifi.Install(phy, mac, ap);
+        mac.SetType("ns3::StaWifiMac",
+                    "Ssid",
+                    SsidValue(ssid),
+                    "ActiveProbing",
+                    BooleanValue(false));
+        NetDeviceContainer staDevices = wifi.Install(phy, mac, sta);
+
+        positions->Add(Vector(10.0 * i, 0, 0));
+        for (uint32_t j = 0; j < stas; j++)
+        {
+            double angle = 2 * M_PI * j / stas;
+            positions->Add(Vector(10.0 * i + 5 * std::cos(angle), 5 * std::sin(angle), 0));
+        }
+        mobility.Install(ap);
+        mobility.Install(sta);
+
+        internet.Install(ap);
+        internet.Install(sta);
+        ipv4.Assign(apDevice);
+        Ipv4InterfaceContainer staInterfaces = ipv4.Assign(staDevices);
+        ipv4.NewNetwork();
+
+        ApplicationContainer sinks = sink.Install(sta);
+        for (uint32_t j = 0; j < stas; j++)
+        {
+            sinks.Get(j)->TraceConnectWithoutContext("Rx", MakeCallback(&Received));
+            OnOffHelper onoff("ns3::UdpSocketFactory",
+                              InetSocketAddress(staInterfaces.GetAddress(j), port));
+            onoff.SetConstantRate(DataRate(rate), 1000);
+            ApplicationContainer app = onoff.Install(ap);
+            app.Start(Seconds(1 + 0.001 * j));
+            app.Stop(Seconds(1 + duration));
+        }
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    Simulator::Stop(Seconds(1.5 + duration));
+    Simulator::Run();
+    std::chrono::duration<double> wall = std::chrono::steady_clock::now() - start;
+
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    std::cout << partition << "," << aps << "," << stas << ","
+              << (partition == "split" ? channels.GetNGroups() : 1) << ","
+              << Simulator::GetEventCount() << "," << g_received << "," << wall.count() << ","
+              << usage.ru_maxrss << std::endl;
+
+    Simulator::Destroy();
+    return 0;
+}
@@ -0,0 +1,219 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Multicast forwarding cost with many groups.
+ *
+ * The l4q1m topology (n0 -- p2p -- n2, and n1 n2 n3 n4 on a CSMA LAN) with
+ * --groups (S,G) routes on the router n2 instead of one, for groups
+ * 225.1.0.0 and up and source n0.  With --index=static the routes are
+ * Ipv4StaticRouting multicast routes, as l4q1m adds them; with
+ * --index=hashed they go into an Ipv4MulticastIndex (see
+ * ipv4-multicast-index.h).
+ *
+ * Two costs are measured:
+ * - lookup: --lookups calls of the router's RouteInput for random groups,
+ *   outside the simulation, i.e. the forwarding decision alone;
+ * - simulated: n0 sends --packets packets to random groups, which n2
+ *   forwards onto the LAN, i.e. the whole per-packet path.
+ *
+ * One line is printed:
+ *   index,groups,setup_ms,lookup_ns,forwarded,sim_us_per_packet
+ *
+ *   ./ns3 run "scratch/multicast-forwarding-bench --groups=10000 --index=static"
+ *   ./ns3 run "scratch/multicast-forwarding-bench --groups=10000 --index=hashed"
+ */
+
+#include "ns3/core-module.h"
+#include "ns3/csma-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/network-module.h"
+#include "ns3/point-to-point-module.h"
+
+#include "ipv4-multicast-index.h"
+
+#include <chrono>
+#include <iostream>
+#include <string>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE("MulticastForwardingBench");
+
+static uint64_t g_forwarded = 0; //!< Multicast packets forwarded by the router.
+static uint64_t g_lookups = 0;   //!< Forwarding decisions taken in the lookup loop.
+
+/**
+ * Count a packet sent onto the LAN by the router.
+ * \param packet The packet.
+ */
+static void
+Forwarded(Ptr<const Packet> packet)
+{
+    g_forwarded++;
+}
+
+/**
+ * Multicast forward callback of the lookup loop.
+ * \param idev The input device.
+ * \param route The route found.
+ * \param p The packet.
+ * \param header Its header.
+ */
+static void
+LookupForward(Ptr<const NetDevice> idev,
+              Ptr<Ipv4MulticastRoute> route,
+              Ptr<const Packet> p,
+              const Ipv4Header& header)
+{
+    g_lookups++;
+}
+
+/**
+ * Local delivery callback of the lookup loop; the router is no member.
+ * \param p The packet.
+ * \param header Its header.
+ * \param iif The input interface.
+ */
+static void
+LookupDeliver(Ptr<const Packet> p, const Ipv4Header& header, uint32_t iif)
+{
+}
+
+/**
+ * Send one packet to a random group and schedule the next one.
+ * \param socket The socket of n0.
+ * \param groups The number of groups.
+ * \param left Packets still to send.
+ * \param pick Group picker.
+ */
+static void
+SendPacket(Ptr<Socket> socket, uint32_t groups, uint32_t left, Ptr<UniformRandomVariable> pick)
+{
+    if (left == 0)
+    {
+        return;
+    }
+    Ipv4Address group(Ipv4Address("225.1.0.0").Get() + pick->GetInteger(0, groups - 1));
+    socket->SendTo(Create<Packet>(128), 0, InetSocketAddress(group, 9));
+    Simulator::Schedule(MicroSeconds(500), &SendPacket, socket, groups, left - 1, pick);
+}
+
+int
+main(int argc, char* argv[])
+{
+    uint32_t groups = 10000;
+    std::string index("hashed");
+    uint32_t lookups = 1000000;
+    uint32_t packets = 10000;
+
+    CommandLine cmd(__FILE__);
+    cmd.AddValue("groups", "Multicast groups routed by the router", groups);
+    cmd.AddValue("index", "Multicast route table (static, hashed)", index);
+    cmd.AddValue("lookups", "RouteInput calls timed outside the simulation", lookups);
+    cmd.AddValue("packets", "Packets sent through the simulated router", packets);
+    cmd.Parse(argc, argv);
+
+    NS_ABORT_MSG_UNLESS(index == "static" || index == "hashed", "Unknown index " << index);
+    NS_ABORT_MSG_UNLESS(groups >= 1, "Need at least one group");
+    Config::SetDefault("ns3::CsmaNetDevice::EncapsulationMode", StringValue("Dix"));
+
+    NodeContainer c;
+    c.Create(5);
+    NodeContainer c0(c.Get(0), c.Get(2));
+    NodeContainer c1(c.Get(1), c.Get(2), c.Get(3), c.Get(4));
+    PointToPointHelper pp;
+    pp.SetDeviceAttribute("DataRate", StringValue("5Mbps"));
+    pp.SetChannelAttribute("Delay", StringValue("2ms"));
+    CsmaHelper csma;
+    csma.SetChannelAttribute("DataRate", DataRateValue(DataRate(5000000)));
+    csma.SetChannelAttribute("Delay", TimeValue(MilliSeconds(2)));
+    NetDeviceContainer nd0 = pp.Install(c0);
+    NetDeviceContainer nd1 = csma.Install(c1);
+    InternetStackHelper internet;
+    internet.Install(c);
+    Ipv4AddressHelper ipv4Addr;
+    ipv4Addr.SetBase("10.1.1.0", "255.255.255.0");
+    ipv4Addr.Assign(nd0);
+    ipv4Addr.SetBase("10.1.2.0", "255.255.255.0");
+    ipv4Addr.Assign(nd1);
+
+    Ipv4Address source("10.1.1.1");
+    Ptr<Node> router = c.Get(2);
+    Ptr<NetDevice> inputIf = nd0.Get(1);
+    NetDeviceContainer outputDevices(nd1.Get(1));
+    uint32_t firstGroup = Ipv4Address("225.1.0.0").Get();
+    Ipv4StaticRoutingHelper multicast;
+    auto start = std::chrono::steady_clock::now();
+    Ptr<Ipv4MulticastIndex> hashed;
+    if (index == "hashed")
+    {
+        hashed = Ipv4MulticastIndex::Install(router);
+    }
+    for (uint32_t g = 0; g < groups; g++)
+    {
+        Ipv4Address group(firstGroup + g);
+        if (hashed)
+        {
+            hashed->AddRoute(source, group, inputIf, outputDevices);
+        }
+        else
+        {
+            multicast.AddMulticastRoute(router, source, group, inputIf, outputDevices);
+        }
+    }
+    std::chrono::duration<double> setup = std::chrono::steady_clock::now() - start;
+    multicast.SetDefaultMulticastRoute(c.Get(0), nd0.Get(0));
+
+    // The forwarding decision alone, through the router's list routing
+    Ptr<Ipv4RoutingProtocol> routing = router->GetObject<Ipv4>()->GetRoutingProtocol();
+    Ptr<UniformRandomVariable> pick = CreateObject<UniformRandomVariable>();
+    Ptr<Packet> packet = Create<Packet>(128);
+    Ipv4Header header;
+    header.SetSource(source);
+    header.SetProtocol(17);
+    header.SetTtl(64);
+    Ipv4RoutingProtocol::UnicastForwardCallback ucb;
+    Ipv4RoutingProtocol::MulticastForwardCallback mcb = MakeCallback(&LookupForward);
+    // Ipv4L3Protocol treats every multicast packet as local, so list
+    // routing delivers it before forwarding it
+    Ipv4RoutingProtocol::LocalDeliverCallback lcb = MakeCallback(&LookupDeliver);
+    Ipv4RoutingProtocol::ErrorCallback ecb;
+    start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < lookups; i++)
+    {
+        header.SetDestination(Ipv4Address(firstGroup + pick->GetInteger(0, groups - 1)));
+        routing->RouteInput(packet, header, inputIf, ucb, mcb, lcb, ecb);
+    }
+    std::chrono::duration<double> lookup = std::chrono::steady_clock::now() - start;
+    NS_ABORT_MSG_UNLESS(g_lookups == lookups,
+                        "Only " << g_lookups << " of " << lookups << " lookups matched");
+
+    // The whole path through the simulated router
+    Ptr<Socket> socket = Socket::CreateSocket(c.Get(0), UdpSocketFactory::GetTypeId());
+    socket->Bind();
+    nd1.Get(1)->TraceConnectWithoutContext("MacTx", MakeCallback(&Forwarded));
+    Simulator::Schedule(Seconds(1), &SendPacket, socket, groups, packets, pick);
+    start = std::chrono::steady_clock::now();
+    Simulator::Run();
+    std::chrono::duration<double> simulated = std::chrono::steady_clock::now() - start;
+
+    std::cout << index << "," << groups << "," << setup.count() * 1e3 << ","
+              << (lookups ? lookup.count() * 1e9 / lookups : 0.0) << "," << g_forwarded << ","
+              << (packets ? simulated.count() * 1e6 / packets : 0.0) << std::endl;
+
+    Simulator::Destroy();
+    return 0;
+}
@@ -0,0 +1,174 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Accuracy and speed of BatchedPathLossModel against the ns-3 models.
+ *
+ * --nodes nodes move as in l9q1.cc (random waypoint at 20 m/s in a
+ * 300 x 1500 m area).  Every millisecond of simulated time a random node
+ * transmits, and the loss to every other node is asked of the ns-3 model
+ * (FriisPropagationLossModel or LogDistancePropagationLossModel, see
+ * --formula) and of BatchedPathLossModel, in the order YansWifiChannel
+ * asks it.  Both answers are compared and both are timed.
+ *
+ * One line is printed:
+ *   formula,nodes,transmissions,max_abs_error_db,reference_ns,batched_ns,speedup
+ * where the times are per receiver, then the GetPosition() calls made by the
+ * ns-3 model and by the PositionSnapshot of the batched one.  Time an
+ * optimized build: with asserts enabled BatchedPathLossModel also checks
+ * one receiver position per batch against its mobility model.
+ *
+ *   ./ns3 run "scratch/path-loss-bench"
+ *   ./ns3 run "scratch/path-loss-bench --nodes=200 --formula=logdistance"
+ */
+
+#include "ns3/core-module.h"
+#include "ns3/mobility-module.h"
+#include "ns3/network-module.h"
+#include "ns3/propagation-module.h"
+
+#include "batched-path-loss-model.h"
+
+#include <chrono>
+#include <iostream>
+#include <string>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE("PathLossBench");
+
+static double g_error = 0;           //!< Largest difference in dB.
+static double g_referenceNs = 0;     //!< Time spent in the ns-3 model.
+static double g_batchedNs = 0;       //!< Time spent in the batched model.
+static uint64_t g_receptions = 0;    //!< Receivers evaluated.
+static uint64_t g_transmissions = 0; //!< Transmissions evaluated.
+
+/**
+ * Evaluate one transmission with both models.
+ * \param nodes The nodes.
+ * \param reference The ns-3 model.
+ * \param batched The batched model.
+ * \param pick Transmitter picker.
+ */
+static void
+Transmit(NodeContainer nodes,
+         Ptr<PropagationLossModel> reference,
+         Ptr<BatchedPathLossModel> batched,
+         Ptr<UniformRandomVariable> pick)
+{
+    uint32_t n = nodes.GetN();
+    Ptr<MobilityModel> sender = nodes.Get(pick->GetInteger(0, n - 1))->GetObject<MobilityModel>();
+    std::vector<Ptr<MobilityModel>> receivers;
+    for (uint32_t i = 0; i < n; i++)
+    {
+        Ptr<MobilityModel> receiver = nodes.Get(i)->GetObject<MobilityModel>();
+        if (receiver != sender)
+        {
+            receivers.push_back(receiver);
+        }
+    }
+    std::vector<double> expected(receivers.size());
+    std::vector<double> actual(receivers.size());
+
+    auto start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < receivers.size(); i++)
+    {
+        expected[i] = reference->CalcRxPower(16, sender, receivers[i]);
+    }
+    auto middle = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < receivers.size(); i++)
+    {
+        actual[i] = batched->CalcRxPower(16, sender, receivers[i]);
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    g_referenceNs += std::chrono::duration<double, std::nano>(middle - start).count();
+    g_batchedNs += std::chrono::duration<double, std::nano>(end - middle).count();
+    for (std::size_t i = 0; i < receivers.size(); i++)
+    {
+        g_error = std::max(g_error, std::abs(expected[i] - actual[i]));
+    }
+    g_receptions += receivers.size();
+    g_transmissions++;
+}
+
+int
+main(int argc, char* argv[])
+{
+    uint32_t nodes = 50;
+    std::string formula("friis");
+    double duration = 20;
+
+    CommandLine cmd(__FILE__);
+    cmd.AddValue("nodes", "Number of nodes", nodes);
+    cmd.AddValue("formula", "Path loss formula (friis, logdistance)", formula);
+    cmd.AddValue("duration", "Simulated seconds, one transmission per ms", duration);
+    cmd.Parse(argc, argv);
+
+    NS_ABORT_MSG_UNLESS(nodes >= 2, "Need at least two nodes");
+    NS_ABORT_MSG_UNLESS(formula == "friis" || formula == "logdistance",
+                        "Unknown formula " << formula);
+
+    NodeContainer c;
+    c.Create(nodes);
+    ObjectFactory pos;
+    pos.SetTypeId("ns3::RandomRectanglePositionAllocator");
+    pos.Set("X", StringValue("ns3::UniformRandomVariable[Min=0.0|Max=300.0]"));
+    pos.Set("Y", StringValue("ns3::UniformRandomVariable[Min=0.0|Max=1500.0]"));
+    Ptr<PositionAllocator> positions = pos.Create()->GetObject<PositionAllocator>();
+    MobilityHelper mobility;
+    mobility.SetMobilityModel("ns3::RandomWaypointMobilityModel",
+                              "Speed",
+                              StringValue("ns3::UniformRandomVariable[Min=0.0|Max=20.0]"),
+                              "Pause",
+                              StringValue("ns3::ConstantRandomVariable[Constant=0.0]"),
+                              "PositionAllocator",
+                              PointerValue(positions));
+    mobility.SetPositionAllocator(positions);
+    mobility.Install(c);
+
+    Ptr<PropagationLossModel> reference;
+    Ptr<BatchedPathLossModel> batched;
+    if (formula == "friis")
+    {
+        reference = CreateObject<FriisPropagationLossModel>();
+        batched = CreateObject<BatchedPathLossModel>();
+    }
+    else
+    {
+        reference = CreateObject<LogDistancePropagationLossModel>();
+        batched = CreateObjectWithAttributes<BatchedPathLossModel>(
+            "Formula",
+            EnumValue(BatchedPathLossModel::LOG_DISTANCE));
+    }
+    batched->Track(c);
+
+    Ptr<UniformRandomVariable> pick = CreateObject<UniformRandomVariable>();
+    for (double t = 0.001; t < duration; t += 0.001)
+    {
+        Simulator::Schedule(Seconds(t), &Transmit, c, reference, batched, pick);
+    }
+    Simulator::Stop(Seconds(duration));
+    Simulator::Run();
+
+    std::cout << formula << "," << nodes << "," << g_transmissions << "," << g_error << ","
+              << g_referenceNs / g_receptions << "," << g_batchedNs / g_receptions << ","
+              << g_referenceNs / g_batchedNs << std::endl;
+    std::cout << "# GetPosition calls: ns-3 " << 2 * g_receptions << ", snapshot "
+              << PositionSnapshot::GetDefault()->GetNEvaluations() << std::endl;
+
+    Simulator::Destroy();
+    return 0;
+}
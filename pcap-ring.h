@@ -0,0 +1,431 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Triggered pcap capture from per-device ring buffers.
+ *
+ * EnablePcapAll() writes every packet of every device to disk.  PcapRing
+ * instead keeps, per device, the last N packets and/or the packets of the
+ * last T seconds in memory (references to the packets, so nothing is
+ * serialized while recording) and appends them to the device's pcap file
+ * only when a trigger fires: a drop in a device's root queue disc or its
+ * transmit queue, an Ipv4 interface going down, or a call to Trigger().
+ * Congestion drops normally happen in the queue disc: the traffic control
+ * layer stops the device queue before it overflows.  Each flush empties the
+ * rings, so a file holds the disjoint stretches of traffic that preceded
+ * each trigger.  Triggers closer than the hold-off time to the previous
+ * flush are ignored, which keeps a congested queue from turning the
+ * capture back into a full one.
+ *
+ *   Ptr<PcapRing> ring = Create<PcapRing>("capture", 1000, Seconds(0), 96);
+ *   ring->Enable(devices);
+ *   ring->TriggerOnDrop(devices);
+ *   ring->TriggerOnInterfaceDown(nodes);
+ *
+ * At least one of the packet and time limits must be set.  Files are named
+ * <prefix>-<node>-<device>.pcap as with the pcap helpers.
+ * Point-to-point and CSMA devices are supported.
+ */
+
+#ifndef PCAP_RING_H
+#define PCAP_RING_H
+
+#include "ns3/abort.h"
+#include "ns3/callback.h"
+#include "ns3/csma-net-device.h"
+#include "ns3/ipv4-list-routing.h"
+#include "ns3/ipv4-routing-protocol.h"
+#include "ns3/ipv4.h"
+#include "ns3/net-device-container.h"
+#include "ns3/node-container.h"
+#include "ns3/pcap-file-wrapper.h"
+#include "ns3/point-to-point-net-device.h"
+#include "ns3/pointer.h"
+#include "ns3/queue-disc.h"
+#include "ns3/queue.h"
+#include "ns3/simple-ref-count.h"
+#include "ns3/simulator.h"
+#include "ns3/trace-helper.h"
+#include "ns3/traffic-control-layer.h"
+
+#include <deque>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * Per-device packet rings flushed to pcap files on triggers.
+ */
+class PcapRing : public SimpleRefCount<PcapRing>
+{
+  public:
+    /**
+     * \param prefix File name prefix.
+     * \param packets Packets kept per device, 0 for no limit.
+     * \param window Age of the oldest packet kept, zero for no limit.  Either
+     * this or packets must be set.
+     * \param snapLen Bytes of each packet written to the files.
+     */
+    PcapRing(const std::string& prefix, uint32_t packets, Time window, uint32_t snapLen);
+
+    /**
+     * Start recording devices.
+     * \param devices Point-to-point or CSMA devices.
+     */
+    void Enable(NetDeviceContainer devices);
+
+    /**
+     * Flush when the root queue disc or the transmit queue of a device drops
+     * a packet.  Call after addresses are assigned, which installs the root
+     * queue discs.
+     * \param devices The devices.
+     */
+    void TriggerOnDrop(NetDeviceContainer devices);
+
+    /**
+     * Flush when an Ipv4 interface of one of the nodes goes down.  Call after
+     * the internet stack is installed.
+     * \param nodes The nodes.
+     */
+    void TriggerOnInterfaceDown(NodeContainer nodes);
+
+    /**
+     * Flush all rings now, unless within the hold-off time.
+     * \param reason Passed to the flush callback.
+     */
+    void Trigger(std::string reason);
+
+    /**
+     * \param holdOff Minimum time between two flushes.  The default is 1 s.
+     */
+    void SetHoldOff(Time holdOff);
+
+    /**
+     * \param cb Called after every flush with the trigger reason and the
+     * number of packets written.
+     */
+    void SetFlushCallback(Callback<void, std::string, uint64_t> cb);
+
+    /** \return the number of packets recorded. */
+    uint64_t GetPacketsSeen() const;
+
+    /** \return the number of packets written to the files. */
+    uint64_t GetPacketsWritten() const;
+
+  private:
+    /** Ring of one device. */
+    struct Ring
+    {
+        Ptr<NetDevice> device;                                  //!< The device.
+        PcapHelper::DataLinkType dataLinkType;                  //!< Link type of the file.
+        std::deque<std::pair<Time, Ptr<const Packet>>> packets; //!< Recorded packets.
+        Ptr<PcapFileWrapper> file;                              //!< Opened on first flush.
+    };
+
+    /** Passive routing protocol that reports interfaces going down. */
+    class Hook : public Ipv4RoutingProtocol
+    {
+      public:
+        /**
+         * \param owner The ring to trigger.
+         */
+        Hook(Ptr<PcapRing> owner)
+            : m_owner(owner)
+        {
+        }
+
+        Ptr<Ipv4Route> RouteOutput(Ptr<Packet> p,
+                                   const Ipv4Header& header,
+                                   Ptr<NetDevice> oif,
+                                   Socket::SocketErrno& sockerr) override
+        {
+            sockerr = Socket::ERROR_NOROUTETOHOST;
+            return nullptr;
+        }
+
+        bool RouteInput(Ptr<const Packet> p,
+                        const Ipv4Header& header,
+                        Ptr<const NetDevice> idev,
+                        const UnicastForwardCallback& ucb,
+                        const MulticastForwardCallback& mcb,
+                        const LocalDeliverCallback& lcb,
+                        const ErrorCallback& ecb) override
+        {
+            return false;
+        }
+
+        void NotifyInterfaceUp(uint32_t interface) override
+        {
+        }
+
+        void NotifyInterfaceDown(uint32_t interface) override
+        {
+            std::ostringstream reason;
+            reason << "interface " << interface << " of node "
+                   << m_ipv4->GetObject<Node>()->GetId() << " down";
+            m_owner->Trigger(reason.str());
+        }
+
+        void NotifyAddAddress(uint32_t interface, Ipv4InterfaceAddress address) override
+        {
+        }
+
+        void NotifyRemoveAddress(uint32_t interface, Ipv4InterfaceAddress address) override
+        {
+        }
+
+        void SetIpv4(Ptr<Ipv4> ipv4) override
+        {
+            m_ipv4 = ipv4;
+        }
+
+        void PrintRoutingTable(Ptr<OutputStreamWrapper> stream,
+                               Time::Unit unit = Time::S) const override
+        {
+        }
+
+      private:
+        Ptr<PcapRing> m_owner; //!< The ring to trigger.
+        Ptr<Ipv4> m_ipv4;      //!< The Ipv4 of the node.
+    };
+
+    /**
+     * Sniffer trace sink.
+     * \param ring The owner.
+     * \param index The ring of the device.
+     * \param packet The packet.
+     */
+    static void Record(PcapRing* ring, std::size_t index, Ptr<const Packet> packet);
+
+    /**
+     * Queue drop trace sink.
+     * \param ring The owner.
+     * \param device The device whose queue dropped.
+     * \param packet The dropped packet.
+     */
+    static void Dropped(PcapRing* ring, Ptr<NetDevice> device, Ptr<const Packet> packet);
+
+    /**
+     * Queue disc drop trace sink.
+     * \param ring The owner.
+     * \param device The device whose root queue disc dropped.
+     * \param item The dropped item.
+     */
+    static void DroppedInQueueDisc(PcapRing* ring,
+                                   Ptr<NetDevice> device,
+                                   Ptr<const QueueDiscItem> item);
+
+    /**
+     * Remove packets beyond the ring limits.
+     * \param ring The ring.
+     */
+    void Trim(Ring& ring) const;
+
+    std::string m_prefix;                            //!< File name prefix.
+    uint32_t m_maxPackets;                           //!< Packets per ring, 0 for no limit.
+    Time m_window;                                   //!< Ring time span, zero for no limit.
+    uint32_t m_snapLen;                              //!< Captured bytes per packet.
+    Time m_holdOff;                                  //!< Minimum time between flushes.
+    Time m_lastFlush;                                //!< Time of the last flush.
+    bool m_flushed;                                  //!< Whether anything was flushed yet.
+    uint64_t m_seen;                                 //!< Packets recorded.
+    uint64_t m_written;                              //!< Packets written.
+    std::vector<Ring> m_rings;                       //!< One per device.
+    Callback<void, std::string, uint64_t> m_flushCb; //!< Flush report.
+};
+
+PcapRing::PcapRing(const std::string& prefix, uint32_t packets, Time window, uint32_t snapLen)
+    : m_prefix(prefix),
+      m_maxPackets(packets),
+      m_window(window),
+      m_snapLen(snapLen),
+      m_holdOff(Seconds(1)),
+      m_flushed(false),
+      m_seen(0),
+      m_written(0)
+{
+    NS_ABORT_MSG_IF(packets == 0 && window.IsZero(),
+                    "PcapRing: set a packet or a time limit, an unbounded ring is a full capture");
+}
+
+void
+PcapRing::Enable(NetDeviceContainer devices)
+{
+    for (uint32_t i = 0; i < devices.GetN(); i++)
+    {
+        Ptr<NetDevice> device = devices.Get(i);
+        PcapHelper::DataLinkType dataLinkType;
+        if (DynamicCast<PointToPointNetDevice>(device))
+        {
+            dataLinkType = PcapHelper::DLT_PPP;
+        }
+        else
+        {
+            NS_ABORT_MSG_UNLESS(DynamicCast<CsmaNetDevice>(device),
+                                "PcapRing supports point-to-point and CSMA devices only");
+            dataLinkType = PcapHelper::DLT_EN10MB;
+        }
+        m_rings.push_back({device, dataLinkType, {}, nullptr});
+        device->TraceConnectWithoutContext(
+            "PromiscSniffer",
+            MakeBoundCallback(&PcapRing::Record, this, m_rings.size() - 1));
+    }
+}
+
+void
+PcapRing::TriggerOnDrop(NetDeviceContainer devices)
+{
+    for (uint32_t i = 0; i < devices.GetN(); i++)
+    {
+        PointerValue queue;
+        devices.Get(i)->GetAttribute("TxQueue", queue);
+        queue.Get<Queue<Packet>>()->TraceConnectWithoutContext(
+            "Drop",
+            MakeBoundCallback(&PcapRing::Dropped, this, devices.Get(i)));
+        Ptr<TrafficControlLayer> tc = devices.Get(i)->GetNode()->GetObject<TrafficControlLayer>();
+        Ptr<QueueDisc> queueDisc = tc ? tc->GetRootQueueDiscOnDevice(devices.Get(i)) : nullptr;
+        if (queueDisc)
+        {
+            queueDisc->TraceConnectWithoutContext(
+                "Drop",
+                MakeBoundCallback(&PcapRing::DroppedInQueueDisc, this, devices.Get(i)));
+        }
+    }
+}
+
+void
+PcapRing::TriggerOnInterfaceDown(NodeContainer nodes)
+{
+    for (uint32_t i = 0; i < nodes.GetN(); i++)
+    {
+        Ptr<Ipv4ListRouting> list =
+            DynamicCast<Ipv4ListRouting>(nodes.Get(i)->GetObject<Ipv4>()->GetRoutingProtocol());
+        NS_ABORT_MSG_UNLESS(list, "Node " << nodes.Get(i)->GetId() << " has no Ipv4ListRouting");
+        list->AddRoutingProtocol(CreateObject<Hook>(Ptr<PcapRing>(this)), -30);
+    }
+}
+
+void
+PcapRing::SetHoldOff(Time holdOff)
+{
+    m_holdOff = holdOff;
+}
+
+void
+PcapRing::SetFlushCallback(Callback<void, std::string, uint64_t> cb)
+{
+    m_flushCb = cb;
+}
+
+uint64_t
+PcapRing::GetPacketsSeen() const
+{
+    return m_seen;
+}
+
+uint64_t
+PcapRing::GetPacketsWritten() const
+{
+    return m_written;
+}
+
+void
+PcapRing::Trim(Ring& ring) const
+{
+    while (m_maxPackets && ring.packets.size() > m_maxPackets)
+    {
+        ring.packets.pop_front();
+    }
+    while (!m_window.IsZero() && !ring.packets.empty() &&
+           ring.packets.front().first < Simulator::Now() - m_window)
+    {
+        ring.packets.pop_front();
+    }
+}
+
+void
+PcapRing::Record(PcapRing* ring, std::size_t index, Ptr<const Packet> packet)
+{
+    Ring& r = ring->m_rings[index];
+    r.packets.emplace_back(Simulator::Now(), packet);
+    ring->m_seen++;
+    ring->Trim(r);
+}
+
+void
+PcapRing::Dropped(PcapRing* ring, Ptr<NetDevice> device, Ptr<const Packet> packet)
+{
+    std::ostringstream reason;
+    reason << "queue drop on node " << device->GetNode()->GetId() << " device "
+           << device->GetIfIndex();
+    ring->Trigger(reason.str());
+}
+
+void
+PcapRing::DroppedInQueueDisc(PcapRing* ring,
+                             Ptr<NetDevice> device,
+                             Ptr<const QueueDiscItem> item)
+{
+    std::ostringstream reason;
+    reason << "queue disc drop on node " << device->GetNode()->GetId() << " device "
+           << device->GetIfIndex();
+    ring->Trigger(reason.str());
+}
+
+void
+PcapRing::Trigger(std::string reason)
+{
+    if (m_flushed && Simulator::Now() < m_lastFlush + m_holdOff)
+    {
+        return;
+    }
+    m_flushed = true;
+    m_lastFlush = Simulator::Now();
+
+    uint64_t written = m_written;
+    PcapHelper pcap;
+    for (auto& ring : m_rings)
+    {
+        Trim(ring);
+        if (ring.packets.empty())
+        {
+            continue;
+        }
+        if (!ring.file)
+        {
+            ring.file = pcap.CreateFile(pcap.GetFilenameFromDevice(m_prefix, ring.device),
+                                        std::ios::out,
+                                        ring.dataLinkType,
+                                        m_snapLen);
+        }
+        for (const auto& [time, packet] : ring.packets)
+        {
+            ring.file->Write(time, packet);
+        }
+        m_written += ring.packets.size();
+        ring.packets.clear();
+    }
+    if (!m_flushCb.IsNull())
+    {
+        m_flushCb(reason, m_written - written);
+    }
+}
+
+} // namespace ns3
+
+#endif /* PCAP_RING_H */
@@ -0,0 +1,497 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Positions of all tracked nodes at the current time, computed once.
+ *
+ * Every GetPosition() of a ConstantVelocityMobilityModel or
+ * RandomWaypointMobilityModel brings its helper up to date and recomputes
+ * the position, and one transmission asks for the transmitter's and each
+ * receiver's position in both the loss and the delay model.
+ * PositionSnapshot evaluates the positions of all tracked mobility models
+ * for the current time once, into x, y and z arrays that every query of
+ * the same timestamp shares; the next timestamp evaluates them again.
+ *
+ * Models that move in straight lines between course changes (constant
+ * position, constant velocity, random waypoint, random walk, random
+ * direction) are not asked at all: their position and velocity are read at
+ * each CourseChange and extrapolated for all of them in one pass (built for
+ * AVX2 and plain x86-64, picked at load time).  Other models are asked with
+ * GetPosition() once per timestamp.
+ *
+ * GetDefault() is the snapshot shared by BatchedPathLossModel and
+ * SnapshotDelayModel unless they are given another.  SnapshotDelayModel is
+ * ConstantSpeedPropagationDelayModel reading the snapshot.
+ *
+ *   YansWifiChannelHelper wifiChannel;
+ *   wifiChannel.SetPropagationDelay("ns3::SnapshotDelayModel");
+ *   wifiChannel.AddPropagationLoss("ns3::BatchedPathLossModel");
+ */
+
+#ifndef POSITION_SNAPSHOT_H
+#define POSITION_SNAPSHOT_H
+
+#include "ns3/abort.h"
+#include "ns3/double.h"
+#include "ns3/mobility-model.h"
+#include "ns3/node-container.h"
+#include "ns3/propagation-delay-model.h"
+#include "ns3/simple-ref-count.h"
+#include "ns3/simulator.h"
+
+#include <cmath>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define POSITION_SNAPSHOT_CLONES __attribute__((target_clones("avx2", "default")))
+#else
+#define POSITION_SNAPSHOT_CLONES
+#endif
+
+namespace ns3
+{
+
+/**
+ * Memoized positions of a set of mobility models at the current time.
+ */
+class PositionSnapshot : public SimpleRefCount<PositionSnapshot>
+{
+  public:
+    /** \return the snapshot shared by default, until Simulator::Destroy(). */
+    static Ptr<PositionSnapshot> GetDefault();
+
+    PositionSnapshot();
+    ~PositionSnapshot();
+
+    /**
+     * \param model A mobility model.
+     * \return its slot, tracking it if it is new.
+     */
+    uint32_t Track(Ptr<MobilityModel> model);
+
+    /**
+     * Track the mobility models of nodes.
+     * \param nodes The nodes.
+     */
+    void Track(NodeContainer nodes);
+
+    /** \return the number of tracked models. */
+    uint32_t GetN() const;
+
+    /**
+     * \param model A mobility model.
+     * \return its slot, or GetN() if it is not tracked.
+     */
+    uint32_t GetSlot(const MobilityModel* model) const;
+
+    /** Evaluate all positions for the current time, unless already done. */
+    void Update();
+
+    /**
+     * Changes whenever a position may have changed: a new timestamp, a
+     * course change or a new model.
+     * \return the version of the positions.
+     */
+    uint64_t GetVersion() const;
+
+    /** \return x of each slot, as of the last Update(). */
+    const double* GetX() const;
+
+    /** \return y of each slot, as of the last Update(). */
+    const double* GetY() const;
+
+    /** \return z of each slot, as of the last Update(). */
+    const double* GetZ() const;
+
+    /**
+     * \param slot A slot.
+     * \return its position, as of the last Update().
+     */
+    Vector GetPosition(uint32_t slot) const;
+
+    /** \return the number of GetPosition() calls made on the tracked models. */
+    uint64_t GetNEvaluations() const;
+
+  private:
+    /**
+     * \param model A mobility model.
+     * \return whether it moves in straight lines between course changes.
+     */
+    static bool IsPiecewiseLinear(Ptr<MobilityModel> model);
+
+    /**
+     * Read the position and velocity of a slot.
+     * \param slot The slot.
+     */
+    void Refresh(uint32_t slot);
+
+    /**
+     * CourseChange sink.
+     * \param model The mobility model.
+     */
+    void CourseChanged(Ptr<const MobilityModel> model);
+
+    /**
+     * Positions of n points moving in straight lines.
+     * \param n The number of points.
+     * \param now The current time in seconds.
+     * \param x Position x at the time read, then now.
+     * \param y Position y at the time read, then now.
+     * \param z Position z at the time read, then now.
+     * \param vx Velocities x.
+     * \param vy Velocities y.
+     * \param vz Velocities z.
+     * \param t Times read, in seconds.
+     * \param px Positions x now, written.
+     * \param py Positions y now, written.
+     * \param pz Positions z now, written.
+     */
+    POSITION_SNAPSHOT_CLONES static void Extrapolate(std::size_t n,
+                                                     double now,
+                                                     const double* x,
+                                                     const double* y,
+                                                     const double* z,
+                                                     const double* vx,
+                                                     const double* vy,
+                                                     const double* vz,
+                                                     const double* t,
+                                                     double* px,
+                                                     double* py,
+                                                     double* pz);
+
+    static Ptr<PositionSnapshot> g_default; //!< The shared snapshot.
+
+    std::vector<Ptr<MobilityModel>> m_models;                   //!< Model of each slot.
+    std::unordered_map<const MobilityModel*, uint32_t> m_slots; //!< Slot of each model.
+    std::vector<uint32_t> m_polled;                             //!< Slots asked every time.
+
+    std::vector<double> m_x;  //!< Position x when read.
+    std::vector<double> m_y;  //!< Position y when read.
+    std::vector<double> m_z;  //!< Position z when read.
+    std::vector<double> m_vx; //!< Velocity x, 0 for polled slots.
+    std::vector<double> m_vy; //!< Velocity y, 0 for polled slots.
+    std::vector<double> m_vz; //!< Velocity z, 0 for polled slots.
+    std::vector<double> m_t;  //!< Time read, in seconds.
+    std::vector<double> m_px; //!< Position x now.
+    std::vector<double> m_py; //!< Position y now.
+    std::vector<double> m_pz; //!< Position z now.
+
+    Time m_time;            //!< Time of m_px, m_py and m_pz.
+    bool m_valid;           //!< Whether they are up to date.
+    uint64_t m_version;     //!< Version of the positions.
+    uint64_t m_evaluations; //!< GetPosition() calls.
+};
+
+/**
+ * ConstantSpeedPropagationDelayModel over a PositionSnapshot.
+ */
+class SnapshotDelayModel : public PropagationDelayModel
+{
+  public:
+    /**
+     * \brief Get the type ID.
+     * \return the object TypeId
+     */
+    static TypeId GetTypeId();
+
+    SnapshotDelayModel();
+
+    /**
+     * \param snapshot The snapshot to read, instead of the default one.
+     */
+    void SetSnapshot(Ptr<PositionSnapshot> snapshot);
+
+    Time GetDelay(Ptr<MobilityModel> a, Ptr<MobilityModel> b) const override;
+
+  private:
+    int64_t DoAssignStreams(int64_t stream) override;
+    void DoDispose() override;
+
+    double m_speed;                    //!< Propagation speed in m/s.
+    Ptr<PositionSnapshot> m_snapshot; //!< The positions.
+};
+
+Ptr<PositionSnapshot> PositionSnapshot::g_default;
+
+Ptr<PositionSnapshot>
+PositionSnapshot::GetDefault()
+{
+    if (!g_default)
+    {
+        g_default = Create<PositionSnapshot>();
+        Simulator::ScheduleDestroy([]() { g_default = nullptr; });
+    }
+    return g_default;
+}
+
+PositionSnapshot::PositionSnapshot()
+    : m_valid(false),
+      m_version(0),
+      m_evaluations(0)
+{
+}
+
+PositionSnapshot::~PositionSnapshot()
+{
+    for (const auto& model : m_models)
+    {
+        model->TraceDisconnectWithoutContext("CourseChange",
+                                             MakeCallback(&PositionSnapshot::CourseChanged, this));
+    }
+}
+
+bool
+PositionSnapshot::IsPiecewiseLinear(Ptr<MobilityModel> model)
+{
+    static const std::set<std::string> linear{"ns3::ConstantPositionMobilityModel",
+                                              "ns3::ConstantVelocityMobilityModel",
+                                              "ns3::RandomWaypointMobilityModel",
+                                              "ns3::RandomWalk2dMobilityModel",
+                                              "ns3::RandomDirection2dMobilityModel"};
+    return linear.count(model->GetInstanceTypeId().GetName());
+}
+
+uint32_t
+PositionSnapshot::Track(Ptr<MobilityModel> model)
+{
+    auto it = m_slots.find(PeekPointer(model));
+    if (it != m_slots.end())
+    {
+        return it->second;
+    }
+    uint32_t slot = m_models.size();
+    m_slots[PeekPointer(model)] = slot;
+    m_models.push_back(model);
+    for (auto v : {&m_x, &m_y, &m_z, &m_vx, &m_vy, &m_vz, &m_t, &m_px, &m_py, &m_pz})
+    {
+        v->push_back(0);
+    }
+    if (IsPiecewiseLinear(model))
+    {
+        Refresh(slot);
+        model->TraceConnectWithoutContext("CourseChange",
+                                          MakeCallback(&PositionSnapshot::CourseChanged, this));
+    }
+    else
+    {
+        m_polled.push_back(slot);
+    }
+    m_valid = false;
+    m_version++;
+    return slot;
+}
+
+void
+PositionSnapshot::Track(NodeContainer nodes)
+{
+    for (uint32_t i = 0; i < nodes.GetN(); i++)
+    {
+        Ptr<MobilityModel> model = nodes.Get(i)->GetObject<MobilityModel>();
+        NS_ABORT_MSG_UNLESS(model, "Node " << nodes.Get(i)->GetId() << " has no mobility model");
+        Track(model);
+    }
+}
+
+uint32_t
+PositionSnapshot::GetN() const
+{
+    return m_models.size();
+}
+
+uint32_t
+PositionSnapshot::GetSlot(const MobilityModel* model) const
+{
+    auto it = m_slots.find(model);
+    return it == m_slots.end() ? m_models.size() : it->second;
+}
+
+void
+PositionSnapshot::Refresh(uint32_t slot)
+{
+    Vector position = m_models[slot]->GetPosition();
+    Vector velocity = m_models[slot]->GetVelocity();
+    m_evaluations++;
+    m_x[slot] = position.x;
+    m_y[slot] = position.y;
+    m_z[slot] = position.z;
+    m_vx[slot] = velocity.x;
+    m_vy[slot] = velocity.y;
+    m_vz[slot] = velocity.z;
+    m_t[slot] = Simulator::Now().GetSeconds();
+    m_valid = false;
+    m_version++;
+}
+
+void
+PositionSnapshot::CourseChanged(Ptr<const MobilityModel> model)
+{
+    auto it = m_slots.find(PeekPointer(model));
+    if (it != m_slots.end())
+    {
+        Refresh(it->second);
+    }
+}
+
+void
+PositionSnapshot::Extrapolate(std::size_t n,
+                              double now,
+                              const double* x,
+                              const double* y,
+                              const double* z,
+                              const double* vx,
+                              const double* vy,
+                              const double* vz,
+                              const double* t,
+                              double* px,
+                              double* py,
+                              double* pz)
+{
+    for (std::size_t i = 0; i < n; i++)
+    {
+        double dt = now - t[i];
+        px[i] = x[i] + vx[i] * dt;
+        py[i] = y[i] + vy[i] * dt;
+        pz[i] = z[i] + vz[i] * dt;
+    }
+}
+
+void
+PositionSnapshot::Update()
+{
+    if (m_valid && m_time == Simulator::Now())
+    {
+        return;
+    }
+    Extrapolate(m_models.size(),
+                Simulator::Now().GetSeconds(),
+                m_x.data(),
+                m_y.data(),
+                m_z.data(),
+                m_vx.data(),
+                m_vy.data(),
+                m_vz.data(),
+                m_t.data(),
+                m_px.data(),
+                m_py.data(),
+                m_pz.data());
+    for (uint32_t slot : m_polled)
+    {
+        Vector position = m_models[slot]->GetPosition();
+        m_evaluations++;
+        m_px[slot] = position.x;
+        m_py[slot] = position.y;
+        m_pz[slot] = position.z;
+    }
+    m_time = Simulator::Now();
+    m_valid = true;
+    m_version++;
+}
+
+uint64_t
+PositionSnapshot::GetVersion() const
+{
+    return m_version;
+}
+
+const double*
+PositionSnapshot::GetX() const
+{
+    return m_px.data();
+}
+
+const double*
+PositionSnapshot::GetY() const
+{
+    return m_py.data();
+}
+
+const double*
+PositionSnapshot::GetZ() const
+{
+    return m_pz.data();
+}
+
+Vector
+PositionSnapshot::GetPosition(uint32_t slot) const
+{
+    return Vector(m_px[slot], m_py[slot], m_pz[slot]);
+}
+
+uint64_t
+PositionSnapshot::GetNEvaluations() const
+{
+    return m_evaluations;
+}
+
+NS_OBJECT_ENSURE_REGISTERED(SnapshotDelayModel);
+
+TypeId
+SnapshotDelayModel::GetTypeId()
+{
+    static TypeId tid = TypeId("ns3::SnapshotDelayModel")
+                            .SetParent<PropagationDelayModel>()
+                            .SetGroupName("Propagation")
+                            .AddConstructor<SnapshotDelayModel>()
+                            .AddAttribute("Speed",
+                                          "The propagation speed (m/s) in the propagation medium",
+                                          DoubleValue(299792458),
+                                          MakeDoubleAccessor(&SnapshotDelayModel::m_speed),
+                                          MakeDoubleChecker<double>());
+    return tid;
+}
+
+SnapshotDelayModel::SnapshotDelayModel()
+    : m_speed(299792458),
+      m_snapshot(PositionSnapshot::GetDefault())
+{
+}
+
+void
+SnapshotDelayModel::SetSnapshot(Ptr<PositionSnapshot> snapshot)
+{
+    m_snapshot = snapshot;
+}
+
+Time
+SnapshotDelayModel::GetDelay(Ptr<MobilityModel> a, Ptr<MobilityModel> b) const
+{
+    uint32_t from = m_snapshot->Track(a);
+    uint32_t to = m_snapshot->Track(b);
+    m_snapshot->Update();
+    double dx = m_snapshot->GetX()[to] - m_snapshot->GetX()[from];
+    double dy = m_snapshot->GetY()[to] - m_snapshot->GetY()[from];
+    double dz = m_snapshot->GetZ()[to] - m_snapshot->GetZ()[from];
+    return Seconds(std::sqrt(dx * dx + dy * dy + dz * dz) / m_speed);
+}
+
+int64_t
+SnapshotDelayModel::DoAssignStreams(int64_t stream)
+{
+    return 0;
+}
+
+void
+SnapshotDelayModel::DoDispose()
+{
+    m_snapshot = nullptr;
+    PropagationDelayModel::DoDispose();
+}
+
+} // namespace ns3
+
+#endif /* POSITION_SNAPSHOT_H */
@@ -0,0 +1,464 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Opt-in per-event-type wall-clock profiler for the scratch programs.
+ *
+ * Select it before the first Simulator call with
+ *
+ *   GlobalValue::Bind("SimulatorImplementationType",
+ *                     StringValue("ns3::ProfilingSimulatorImpl"));
+ *
+ * Every scheduled event is wrapped so that the wall-clock time spent in its
+ * Invoke() and the number of executions are attributed to the C++ type of
+ * the event, which for events created by MakeEvent names the target member
+ * function's class and signature.
+ *
+ * What that costs per event: at Schedule() the wrapper is taken from a free
+ * list of recycled ProfiledEvents (a heap allocation only while the number
+ * of pending events grows) and its statistics from a small direct-mapped
+ * cache indexed by the address of the event's type_info, which falls back
+ * to a std::type_index hash map on a miss; at execution, one more virtual
+ * call and two steady_clock reads.  The report only covers the time inside
+ * Invoke(), not this overhead; measure it from the outside, e.g. with l9q1,
+ * which prints the wall-clock time of Simulator::Run() and the number of
+ * events:
+ *
+ *   ./ns3 run "scratch/l9q1 --protocol=2"
+ *   ./ns3 run "scratch/l9q1 --protocol=2 --profile"
+ *
+ * The difference of the two run times divided by the event count is the
+ * cost per event; repeat each run a few times, the spread between runs of
+ * the same command is the noise floor.
+ *
+ * After Simulator::Run() call ProfilingSimulatorImpl::PrintReport() for a
+ * table sorted by total time and ProfilingSimulatorImpl::WriteFoldedStacks()
+ * for a file that flamegraph.pl / speedscope read directly.
+ *
+ * Code that runs inside other events, such as trace sinks, can be carved
+ * out of them with a Section; its time is then reported under the
+ * section's name instead of the event that called it:
+ *
+ *   ProfilingSimulatorImpl::Section section("[tracing]");
+ */
+
+#ifndef PROFILING_SIMULATOR_IMPL_H
+#define PROFILING_SIMULATOR_IMPL_H
+
+#include "ns3/default-simulator-impl.h"
+#include "ns3/event-impl.h"
+#include "ns3/ptr.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cxxabi.h>
+#include <fstream>
+#include <iomanip>
+#include <array>
+#include <cstdint>
+#include <map>
+#include <ostream>
+#include <string>
+#include <typeindex>
+#include <typeinfo>
+#include <unordered_map>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * Simulator implementation that attributes wall-clock time to event types.
+ */
+class ProfilingSimulatorImpl : public DefaultSimulatorImpl
+{
+  public:
+    /** Time and count accumulated for one event type. */
+    struct Stats
+    {
+        uint64_t count{0};                //!< Number of executed events.
+        std::chrono::nanoseconds wall{0}; //!< Wall-clock time spent in Invoke().
+    };
+
+    /** One aggregated line of the report. */
+    struct Entry
+    {
+        std::string owner; //!< Class that owns the callback target, or "(function)".
+        std::string name;  //!< Demangled event type.
+        Stats stats;       //!< Accumulated statistics.
+    };
+
+    /**
+     * Scope whose wall-clock time is reported under its own name and not
+     * under the enclosing event or section.
+     */
+    class Section
+    {
+      public:
+        /**
+         * \param name The name to report, a string literal such as "[tracing]".
+         */
+        Section(const char* name);
+        ~Section();
+
+      private:
+        Stats* m_stats;                                //!< Statistics of the section.
+        std::chrono::steady_clock::time_point m_start; //!< Start of the scope.
+        std::chrono::nanoseconds m_carved;             //!< GetCarved() at the start.
+    };
+
+    /**
+     * \brief Get the type ID.
+     * \return the object TypeId
+     */
+    static TypeId GetTypeId();
+
+    EventId Schedule(const Time& delay, EventImpl* event) override;
+    void ScheduleWithContext(uint32_t context, const Time& delay, EventImpl* event) override;
+    EventId ScheduleNow(EventImpl* event) override;
+
+    /**
+     * \return the collected statistics aggregated per event type, sorted by
+     * decreasing wall-clock time.
+     */
+    static std::vector<Entry> GetEntries();
+
+    /**
+     * Print a table of the collected statistics.
+     * \param os The output stream.
+     * \param maxLines The maximum number of event types to print.
+     */
+    static void PrintReport(std::ostream& os, uint32_t maxLines = 30);
+
+    /**
+     * Write the collected statistics as folded stacks
+     * ("Simulator::Run;<owner>;<event> <microseconds>").
+     * \param filename The output file name.
+     */
+    static void WriteFoldedStacks(const std::string& filename);
+
+  private:
+    /** Event that times the event it wraps. */
+    class ProfiledEvent final : public EventImpl
+    {
+      public:
+        /**
+         * \param inner The wrapped event; ownership is taken.
+         * \param stats Where to accumulate the measurements.
+         */
+        ProfiledEvent(EventImpl* inner, Stats* stats)
+            : m_inner(inner, false),
+              m_stats(stats)
+        {
+        }
+
+        /**
+         * Take the memory of a previously deleted ProfiledEvent if there is one.
+         * \param size The size of a ProfiledEvent.
+         * \return the memory for the new event.
+         */
+        static void* operator new(std::size_t size)
+        {
+            std::vector<void*>& pool = GetPool();
+            if (pool.empty())
+            {
+                return ::operator new(size);
+            }
+            void* memory = pool.back();
+            pool.pop_back();
+            return memory;
+        }
+
+        /**
+         * Keep the memory of a deleted ProfiledEvent for the next one.
+         * \param memory The memory of the deleted event.
+         */
+        static void operator delete(void* memory)
+        {
+            GetPool().push_back(memory);
+        }
+
+      private:
+        void Notify() override
+        {
+            auto start = std::chrono::steady_clock::now();
+            std::chrono::nanoseconds carved = GetCarved();
+            m_inner->Invoke();
+            std::chrono::nanoseconds wall = std::chrono::steady_clock::now() - start;
+            m_stats->wall += wall - (GetCarved() - carved);
+            m_stats->count++;
+            GetCarved() = carved + wall;
+        }
+
+        /**
+         * \return the memory of deleted ProfiledEvents.  It is kept for the
+         * whole process, at most the peak number of pending events.
+         */
+        static std::vector<void*>& GetPool()
+        {
+            static std::vector<void*> pool;
+            return pool;
+        }
+
+        Ptr<EventImpl> m_inner; //!< The wrapped event.
+        Stats* m_stats;         //!< Statistics of the wrapped event type.
+    };
+
+    /** Entry of the cache in front of GetRegistry(). */
+    struct CacheLine
+    {
+        const std::type_info* type{nullptr}; //!< The event type, or nullptr if unused.
+        Stats* stats{nullptr};               //!< Its statistics.
+    };
+
+    /**
+     * Wrap an event into a ProfiledEvent.
+     * \param event The event to wrap.
+     * \return the wrapping event.
+     */
+    static EventImpl* Wrap(EventImpl* event);
+
+    /**
+     * \return the per-type statistics.
+     */
+    static std::unordered_map<std::type_index, Stats>& GetRegistry();
+
+    /**
+     * \return the last looked up statistics, indexed by type_info address.
+     */
+    static std::array<CacheLine, 256>& GetCache();
+
+    /**
+     * \return the per-section statistics, keyed by the section name.
+     */
+    static std::unordered_map<const char*, Stats>& GetSections();
+
+    /**
+     * \return the wall-clock time spent in finished events and sections,
+     * which enclosing ones subtract from their own.
+     */
+    static std::chrono::nanoseconds& GetCarved();
+
+    /**
+     * \param mangled A mangled type name.
+     * \return the demangled name.
+     */
+    static std::string Demangle(const char* mangled);
+
+    /**
+     * \param name A demangled event type name.
+     * \return the class owning the member function the event calls,
+     * "(function)" for events bound to free functions, or the name of a
+     * Section.
+     */
+    static std::string Owner(const std::string& name);
+};
+
+NS_OBJECT_ENSURE_REGISTERED(ProfilingSimulatorImpl);
+
+TypeId
+ProfilingSimulatorImpl::GetTypeId()
+{
+    static TypeId tid = TypeId("ns3::ProfilingSimulatorImpl")
+                            .SetParent<DefaultSimulatorImpl>()
+                            .SetGroupName("Core")
+                            .AddConstructor<ProfilingSimulatorImpl>();
+    return tid;
+}
+
+std::unordered_map<std::type_index, ProfilingSimulatorImpl::Stats>&
+ProfilingSimulatorImpl::GetRegistry()
+{
+    static std::unordered_map<std::type_index, Stats> registry;
+    return registry;
+}
+
+std::array<ProfilingSimulatorImpl::CacheLine, 256>&
+ProfilingSimulatorImpl::GetCache()
+{
+    static std::array<CacheLine, 256> cache;
+    return cache;
+}
+
+std::unordered_map<const char*, ProfilingSimulatorImpl::Stats>&
+ProfilingSimulatorImpl::GetSections()
+{
+    static std::unordered_map<const char*, Stats> sections;
+    return sections;
+}
+
+std::chrono::nanoseconds&
+ProfilingSimulatorImpl::GetCarved()
+{
+    static std::chrono::nanoseconds carved{0};
+    return carved;
+}
+
+ProfilingSimulatorImpl::Section::Section(const char* name)
+    : m_stats(&GetSections()[name]),
+      m_start(std::chrono::steady_clock::now()),
+      m_carved(GetCarved())
+{
+}
+
+ProfilingSimulatorImpl::Section::~Section()
+{
+    std::chrono::nanoseconds wall = std::chrono::steady_clock::now() - m_start;
+    m_stats->wall += wall - (GetCarved() - m_carved);
+    m_stats->count++;
+    GetCarved() = m_carved + wall;
+}
+
+EventImpl*
+ProfilingSimulatorImpl::Wrap(EventImpl* event)
+{
+    const std::type_info& type = typeid(*event);
+    // type_info objects are at least pointer aligned, skip the low bits.
+    CacheLine& line = GetCache()[(reinterpret_cast<uintptr_t>(&type) >> 3) % 256];
+    if (line.type != &type)
+    {
+        // unordered_map never moves its nodes, so the pointer stays valid.
+        line.stats = &GetRegistry()[std::type_index(type)];
+        line.type = &type;
+    }
+    return new ProfiledEvent(event, line.stats);
+}
+
+EventId
+ProfilingSimulatorImpl::Schedule(const Time& delay, EventImpl* event)
+{
+    return DefaultSimulatorImpl::Schedule(delay, Wrap(event));
+}
+
+void
+ProfilingSimulatorImpl::ScheduleWithContext(uint32_t context, const Time& delay, EventImpl* event)
+{
+    DefaultSimulatorImpl::ScheduleWithContext(context, delay, Wrap(event));
+}
+
+EventId
+ProfilingSimulatorImpl::ScheduleNow(EventImpl* event)
+{
+    return DefaultSimulatorImpl::ScheduleNow(Wrap(event));
+}
+
+std::string
+ProfilingSimulatorImpl::Demangle(const char* mangled)
+{
+    int status = 0;
+    char* demangled = abi::__cxa_demangle(mangled, nullptr, nullptr, &status);
+    std::string name = (status == 0 && demangled) ? demangled : mangled;
+    std::free(demangled);
+    return name;
+}
+
+std::string
+ProfilingSimulatorImpl::Owner(const std::string& name)
+{
+    if (name.front() == '[')
+    {
+        return name; // a Section
+    }
+    // MakeEvent spells a member function pointer as "void (ns3::Class::*)(...)".
+    std::size_t end = name.find("::*)");
+    if (end == std::string::npos)
+    {
+        return "(function)";
+    }
+    std::size_t begin = name.rfind('(', end);
+    return name.substr(begin + 1, end - begin - 1);
+}
+
+std::vector<ProfilingSimulatorImpl::Entry>
+ProfilingSimulatorImpl::GetEntries()
+{
+    std::map<std::string, Stats> merged;
+    for (const auto& [type, stats] : GetRegistry())
+    {
+        if (stats.count > 0)
+        {
+            merged[Demangle(type.name())] = stats;
+        }
+    }
+    // The same section name may be spelled by several string literals.
+    for (const auto& [name, stats] : GetSections())
+    {
+        Stats& m = merged[name];
+        m.count += stats.count;
+        m.wall += stats.wall;
+    }
+
+    std::vector<Entry> entries;
+    for (const auto& [name, stats] : merged)
+    {
+        entries.push_back({Owner(name), name, stats});
+    }
+    std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+        return a.stats.wall > b.stats.wall;
+    });
+    return entries;
+}
+
+void
+ProfilingSimulatorImpl::PrintReport(std::ostream& os, uint32_t maxLines)
+{
+    std::vector<Entry> entries = GetEntries();
+    double totalMs = 0;
+    uint64_t totalEvents = 0;
+    for (const auto& e : entries)
+    {
+        totalMs += e.stats.wall.count() / 1e6;
+        totalEvents += e.stats.count;
+    }
+
+    os << "Event profile: " << totalEvents << " events, " << std::fixed << std::setprecision(1)
+       << totalMs << " ms in event handlers" << std::endl;
+    os << std::setw(10) << "ms" << std::setw(7) << "%" << std::setw(12) << "events"
+       << std::setw(10) << "ns/event"
+       << "  target" << std::endl;
+    uint32_t lines = 0;
+    for (const auto& e : entries)
+    {
+        if (lines++ == maxLines)
+        {
+            break;
+        }
+        double ms = e.stats.wall.count() / 1e6;
+        os << std::setw(10) << std::setprecision(1) << ms << std::setw(7)
+           << (totalMs > 0 ? 100.0 * ms / totalMs : 0.0) << std::setw(12) << e.stats.count
+           << std::setw(10) << std::setprecision(0)
+           << double(e.stats.wall.count()) / e.stats.count << "  " << e.owner << std::endl;
+    }
+}
+
+void
+ProfilingSimulatorImpl::WriteFoldedStacks(const std::string& filename)
+{
+    std::ofstream out(filename);
+    for (const auto& e : GetEntries())
+    {
+        std::string name = e.name;
+        std::replace(name.begin(), name.end(), ';', ',');
+        out << "Simulator::Run;" << e.owner << ";" << name << " "
+            << std::chrono::duration_cast<std::chrono::microseconds>(e.stats.wall).count()
+            << std::endl;
+    }
+    out.close();
+}
+
+} // namespace ns3
+
+#endif /* PROFILING_SIMULATOR_IMPL_H */
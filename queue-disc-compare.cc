@@ -0,0 +1,278 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Queue disciplines on the answerfinal.cc N10-N8 bottleneck.
+ *
+ *   sender --100Mbps-- N10 ==2Mbps, 5ms== N8 --100Mbps-- receiver
+ *
+ * --flows TCP OnOff sources on the sender together offer --loads times the
+ * bottleneck rate.  N10's bottleneck device has a 50-packet DropTail queue.
+ * Above it, "none" keeps the root queue disc that address assignment
+ * installs (TrafficControlHelper::Default, an FqCoDelQueueDisc, so it runs
+ * the same disc as "FqCoDel"), as answerfinal.cc does with
+ * --queueDisc=none; "DropTail" removes it, leaving the device queue alone;
+ * the others install FqCoDel, CoDel, PIE or RED instead (see
+ * queue-disc-type.h).
+ *
+ * Every (discipline, load) pair is a separate simulation run in a forked
+ * process, --jobs at a time, and the results are printed as one table:
+ *   disc,load,goodput_mbps,queue_p50_ms,queue_p95_ms,queue_p99_ms,drop_rate
+ * Queueing delay is the one-way delay of the data packets (FlowMonitor
+ * histogram, 0.5 ms bins) minus the smallest delay seen in that run.
+ *
+ *   ./ns3 run "scratch/queue-disc-compare --loads=0.5,0.9,1.2 --jobs=8"
+ */
+
+#include "ns3/applications-module.h"
+#include "ns3/core-module.h"
+#include "ns3/flow-monitor-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/network-module.h"
+#include "ns3/point-to-point-module.h"
+#include "ns3/traffic-control-module.h"
+
+#include "queue-disc-type.h"
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE("QueueDiscCompare");
+
+/**
+ * \param delays Packets per delay histogram bin start.
+ * \param total Sum of the packets.
+ * \param p The percentile, between 0 and 1.
+ * \return the percentile minus the smallest delay, in ms.
+ */
+static double
+Percentile(const std::map<double, uint64_t>& delays, uint64_t total, double p)
+{
+    uint64_t rank = p * total;
+    uint64_t seen = 0;
+    for (const auto& [start, count] : delays)
+    {
+        seen += count;
+        if (seen > rank)
+        {
+            return (start - delays.begin()->first) * 1e3;
+        }
+    }
+    return 0;
+}
+
+/**
+ * Run one simulation.
+ * \param disc The discipline.
+ * \param load Offered load relative to the bottleneck rate.
+ * \param flows Number of TCP flows.
+ * \param duration Seconds of traffic.
+ * \return the result line.
+ */
+static std::string
+RunOne(const std::string& disc, double load, uint32_t flows, double duration)
+{
+    const DataRate bottleneck("2Mbps");
+    const uint32_t packetSize = 1000;
+
+    NodeContainer nodes;
+    nodes.Create(4); // sender, N10, N8, receiver
+    InternetStackHelper stack;
+    stack.Install(nodes);
+
+    PointToPointHelper access;
+    access.SetDeviceAttribute("DataRate", StringValue("100Mbps"));
+    access.SetChannelAttribute("Delay", StringValue("1ms"));
+    PointToPointHelper pointToPoint;
+    pointToPoint.SetDeviceAttribute("DataRate", DataRateValue(bottleneck));
+    pointToPoint.SetChannelAttribute("Delay", StringValue("5ms"));
+    pointToPoint.SetQueue("ns3::DropTailQueue", "MaxSize", StringValue("50p"));
+
+    NetDeviceContainer senderLink = access.Install(nodes.Get(0), nodes.Get(1));
+    NetDeviceContainer bottleneckLink = pointToPoint.Install(nodes.Get(1), nodes.Get(2));
+    NetDeviceContainer receiverLink = access.Install(nodes.Get(2), nodes.Get(3));
+
+    // Address assignment installs the default root queue disc if none is set
+    TrafficControlHelper tch;
+    std::string type = QueueDiscType(disc);
+    if (!type.empty())
+    {
+        tch.SetRootQueueDisc(type);
+        tch.Install(bottleneckLink.Get(0));
+    }
+
+    Ipv4AddressHelper address;
+    address.SetBase("10.1.1.0", "255.255.255.0");
+    address.Assign(senderLink);
+    address.SetBase("10.1.3.0", "255.255.255.0");
+    address.Assign(bottleneckLink);
+    address.SetBase("10.1.4.0", "255.255.255.0");
+    Ipv4InterfaceContainer receiver = address.Assign(receiverLink);
+    if (disc == "DropTail")
+    {
+        tch.Uninstall(bottleneckLink.Get(0));
+    }
+    Ipv4GlobalRoutingHelper::PopulateRoutingTables();
+
+    uint16_t port = 9;
+    PacketSinkHelper sink("ns3::TcpSocketFactory", InetSocketAddress(Ipv4Address::GetAny(), port));
+    ApplicationContainer sinkApp = sink.Install(nodes.Get(3));
+    sinkApp.Start(Seconds(0));
+
+    OnOffHelper onoff("ns3::TcpSocketFactory", InetSocketAddress(receiver.GetAddress(1), port));
+    onoff.SetConstantRate(DataRate(bottleneck.GetBitRate() * load / flows), packetSize);
+    Ptr<UniformRandomVariable> jitter = CreateObject<UniformRandomVariable>();
+    for (uint32_t i = 0; i < flows; i++)
+    {
+        ApplicationContainer app = onoff.Install(nodes.Get(0));
+        app.Start(Seconds(1 + jitter->GetValue(0, 0.1)));
+        app.Stop(Seconds(1 + duration));
+    }
+
+    FlowMonitorHelper flowmon;
+    flowmon.SetMonitorAttribute("DelayBinWidth", DoubleValue(0.0005));
+    Ptr<FlowMonitor> monitor = flowmon.InstallAll();
+
+    Simulator::Stop(Seconds(2 + duration));
+    Simulator::Run();
+
+    monitor->CheckForLostPackets();
+    Ptr<Ipv4FlowClassifier> classifier = DynamicCast<Ipv4FlowClassifier>(flowmon.GetClassifier());
+    uint64_t rxBytes = 0;
+    uint64_t txPackets = 0;
+    uint64_t lostPackets = 0;
+    std::map<double, uint64_t> delays; // bin start -> packets
+    for (const auto& [id, stats] : monitor->GetFlowStats())
+    {
+        // Data direction only, the ACK flows go the other way
+        if (classifier->FindFlow(id).destinationAddress != receiver.GetAddress(1))
+        {
+            continue;
+        }
+        rxBytes += stats.rxBytes;
+        txPackets += stats.txPackets;
+        lostPackets += stats.txPackets - stats.rxPackets;
+        for (uint32_t b = 0; b < stats.delayHistogram.GetNBins(); b++)
+        {
+            if (stats.delayHistogram.GetBinCount(b))
+            {
+                delays[stats.delayHistogram.GetBinStart(b)] += stats.delayHistogram.GetBinCount(b);
+            }
+        }
+    }
+
+    uint64_t received = 0;
+    for (const auto& bin : delays)
+    {
+        received += bin.second;
+    }
+
+    std::ostringstream line;
+    line << disc << "," << load << "," << rxBytes * 8 / duration / 1e6 << ","
+         << Percentile(delays, received, 0.5) << "," << Percentile(delays, received, 0.95) << ","
+         << Percentile(delays, received, 0.99) << ","
+         << (txPackets ? double(lostPackets) / txPackets : 0);
+
+    Simulator::Destroy();
+    return line.str();
+}
+
+int
+main(int argc, char* argv[])
+{
+    std::string discs("none,DropTail,FqCoDel,CoDel,PIE,RED");
+    std::string loads("0.5,0.8,0.95,1.1,1.5");
+    uint32_t flows = 8;
+    double duration = 30;
+    uint32_t jobs = std::thread::hardware_concurrency();
+
+    CommandLine cmd(__FILE__);
+    cmd.AddValue("discs",
+                 "Comma-separated disciplines (none, DropTail, FqCoDel, CoDel, PIE, RED)",
+                 discs);
+    cmd.AddValue("loads", "Comma-separated offered loads, relative to 2Mbps", loads);
+    cmd.AddValue("flows", "TCP flows sharing the offered load", flows);
+    cmd.AddValue("duration", "Seconds of traffic per run", duration);
+    cmd.AddValue("jobs", "Runs in parallel", jobs);
+    cmd.Parse(argc, argv);
+
+    std::vector<std::pair<std::string, double>> runs;
+    std::istringstream discList(discs);
+    std::string disc;
+    while (std::getline(discList, disc, ','))
+    {
+        QueueDiscType(disc);
+        std::istringstream loadList(loads);
+        std::string load;
+        while (std::getline(loadList, load, ','))
+        {
+            runs.emplace_back(disc, std::stod(load));
+        }
+    }
+
+    // One process per run: ns-3 keeps global simulation state, so runs
+    // cannot share a process concurrently.
+    std::vector<std::string> results(runs.size());
+    std::map<pid_t, std::pair<std::size_t, int>> running; // pid -> (run, pipe)
+    std::size_t next = 0;
+    while (next < runs.size() || !running.empty())
+    {
+        if (next < runs.size() && running.size() < std::max(1U, jobs))
+        {
+            int fds[2];
+            NS_ABORT_MSG_IF(pipe(fds) != 0, "pipe() failed");
+            pid_t pid = fork();
+            NS_ABORT_MSG_IF(pid < 0, "fork() failed");
+            if (pid == 0)
+            {
+                close(fds[0]);
+                std::string line = RunOne(runs[next].first, runs[next].second, flows, duration);
+                NS_ABORT_MSG_IF(write(fds[1], line.data(), line.size()) < 0, "write() failed");
+                _exit(0);
+            }
+            close(fds[1]);
+            running[pid] = {next++, fds[0]};
+            continue;
+        }
+        int status;
+        pid_t pid = wait(&status);
+        auto [run, fd] = running[pid];
+        running.erase(pid);
+        char buffer[256];
+        ssize_t n = read(fd, buffer, sizeof(buffer));
+        close(fd);
+        results[run] = (n > 0 && WIFEXITED(status) && WEXITSTATUS(status) == 0)
+                           ? std::string(buffer, n)
+                           : runs[run].first + "," + std::to_string(runs[run].second) + ",failed";
+    }
+
+    std::cout << "disc,load,goodput_mbps,queue_p50_ms,queue_p95_ms,queue_p99_ms,drop_rate"
+              << std::endl;
+    for (const auto& line : results)
+    {
+        std::cout << line << std::endl;
+    }
+    return 0;
+}
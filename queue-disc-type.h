@@ -0,0 +1,67 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Queue discipline names shared by answerfinal.cc and queue-disc-compare.cc.
+ *
+ * Ipv4AddressHelper::Assign() installs TrafficControlHelper::Default() (an
+ * FqCoDelQueueDisc) as the root queue disc of a device that has none.
+ *   none      keeps that default, so it runs the same disc as FqCoDel;
+ *   DropTail  removes it after addressing, leaving the device queue alone;
+ *   FqCoDel, CoDel, PIE, RED install that disc before addressing.
+ *
+ *   std::string type = QueueDiscType(disc); // aborts on an unknown name
+ *   if (!type.empty())
+ *   {
+ *       tch.SetRootQueueDisc(type);
+ *   }
+ */
+
+#ifndef QUEUE_DISC_TYPE_H
+#define QUEUE_DISC_TYPE_H
+
+#include "ns3/abort.h"
+
+#include <map>
+#include <string>
+
+namespace ns3
+{
+
+/**
+ * \param disc A discipline name as given on the command line.
+ * \return the queue disc TypeId name, empty for none and DropTail.
+ */
+inline std::string
+QueueDiscType(const std::string& disc)
+{
+    static const std::map<std::string, std::string> types = {
+        {"none", ""},
+        {"DropTail", ""},
+        {"FqCoDel", "ns3::FqCoDelQueueDisc"},
+        {"CoDel", "ns3::CoDelQueueDisc"},
+        {"PIE", "ns3::PieQueueDisc"},
+        {"RED", "ns3::RedQueueDisc"},
+    };
+    auto it = types.find(disc);
+    NS_ABORT_MSG_IF(it == types.end(),
+                    "Unknown queue disc " << disc
+                                          << " (none, DropTail, FqCoDel, CoDel, PIE, RED)");
+    return it->second;
+}
+
+} // namespace ns3
+
+#endif /* QUEUE_DISC_TYPE_H */
@@ -0,0 +1,425 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * RIP convergence under a link failure, for each split-horizon strategy.
+ *
+ * Every node runs RIP on a topology file (default: the wired-tcp-udp.cc
+ * network) or on a generated rows x cols grid.  A CBR UDP flow runs from
+ * --src to --dst.  At --warmup the link that --src uses towards --dst is
+ * taken down, and --downtime later it is brought back up.  Every --poll
+ * seconds the routing tables of the nodes that sent or received a RIP
+ * packet, or had an interface change, since the previous sample are read
+ * again; a phase has converged at the last table change observed in it.
+ * RIP has no route-change trace, and a route that times out is only seen
+ * once the node sends the triggered update for it (1 to 5 s later).
+ *
+ * The wired-tcp-udp.cc network is a tree, so the failure partitions it and
+ * convergence means withdrawing the lost routes, which is where counting to
+ * infinity shows without split horizon.  Grids have alternative paths, but
+ * RIP's 15-hop limit leaves far corners of large grids unreachable.
+ *
+ * One line per strategy:
+ *   strategy,routers,links,initial_s,down_s,up_s,control_packets,control_bytes,sent,lost
+ * with control traffic (UDP port 520), sent and lost counted from the
+ * failure on.
+ *
+ *   ./ns3 run "scratch/rip-convergence --src=9 --dst=2"
+ *   ./ns3 run "scratch/rip-convergence --grid=40x40 --strategies=PoisonReverse"
+ */
+
+#include "ns3/applications-module.h"
+#include "ns3/core-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/network-module.h"
+
+#include "routing-snapshot.h"
+#include "topology-loader.h"
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE("RipConvergence");
+
+static std::vector<std::vector<RoutingSnapshot::Entry>> g_tables; //!< Last sampled tables.
+static Time g_lastChange;                                         //!< Last table change.
+static Time g_downAt;                                             //!< Time of the failure.
+static Time g_initial;                                            //!< Initial convergence.
+static Time g_down;                                               //!< Convergence after failure.
+static uint64_t g_controlPackets = 0;  //!< RIP packets sent since the failure.
+static uint64_t g_controlBytes = 0;    //!< RIP bytes sent since the failure.
+static uint64_t g_sent = 0;            //!< Data packets sent since the failure.
+static uint64_t g_received = 0;        //!< Data packets received since the failure.
+static NetDeviceContainer g_failed;    //!< Devices of the failed link.
+static std::vector<bool> g_dirty;      //!< Per node, whether it is in g_toPoll.
+static std::vector<uint32_t> g_toPoll; //!< Nodes to sample at the next poll.
+
+/**
+ * Have a node's routing table sampled again at the next poll.
+ * \param node The node.
+ */
+static void
+MarkDirty(Ptr<Node> node)
+{
+    if (!g_dirty[node->GetId()])
+    {
+        g_dirty[node->GetId()] = true;
+        g_toPoll.push_back(node->GetId());
+    }
+}
+
+/**
+ * Sample the routing tables that may have changed since the last poll.
+ * \param interval Time between samples.
+ */
+static void
+Poll(Time interval)
+{
+    for (uint32_t id : g_toPoll)
+    {
+        g_dirty[id] = false;
+        std::vector<RoutingSnapshot::Entry> table = RoutingSnapshot::Read(NodeList::GetNode(id));
+        if (table != g_tables[id])
+        {
+            g_tables[id] = std::move(table);
+            g_lastChange = Simulator::Now();
+        }
+    }
+    g_toPoll.clear();
+    Simulator::Schedule(interval, &Poll, interval);
+}
+
+/**
+ * \param packet A packet with its IPv4 header.
+ * \return whether it is a RIP packet.
+ */
+static bool
+IsRip(Ptr<const Packet> packet)
+{
+    Ptr<Packet> copy = packet->Copy();
+    Ipv4Header ip;
+    copy->RemoveHeader(ip);
+    UdpHeader udp;
+    return ip.GetProtocol() == UdpL4Protocol::PROT_NUMBER && copy->PeekHeader(udp) &&
+           udp.GetDestinationPort() == 520;
+}
+
+/**
+ * Count RIP packets leaving a node.
+ * \param packet The packet, with its IPv4 header.
+ * \param ipv4 The stack.
+ * \param interface The interface.
+ */
+static void
+Ipv4Tx(Ptr<const Packet> packet, Ptr<Ipv4> ipv4, uint32_t interface)
+{
+    if (!IsRip(packet))
+    {
+        return;
+    }
+    MarkDirty(ipv4->GetObject<Node>());
+    if (!g_downAt.IsZero() && Simulator::Now() >= g_downAt)
+    {
+        g_controlPackets++;
+        g_controlBytes += packet->GetSize();
+    }
+}
+
+/**
+ * Note RIP packets reaching a node, which may change its table.
+ * \param packet The packet, with its IPv4 header.
+ * \param ipv4 The stack.
+ * \param interface The interface.
+ */
+static void
+Ipv4Rx(Ptr<const Packet> packet, Ptr<Ipv4> ipv4, uint32_t interface)
+{
+    if (IsRip(packet))
+    {
+        MarkDirty(ipv4->GetObject<Node>());
+    }
+}
+
+/**
+ * Count data packets sent after the failure.
+ * \param packet The packet.
+ */
+static void
+DataTx(Ptr<const Packet> packet)
+{
+    g_sent += !g_downAt.IsZero() && Simulator::Now() >= g_downAt;
+}
+
+/**
+ * Count data packets received after the failure.
+ * \param packet The packet.
+ * \param from The sender.
+ */
+static void
+DataRx(Ptr<const Packet> packet, const Address& from)
+{
+    g_received += !g_downAt.IsZero() && Simulator::Now() >= g_downAt;
+}
+
+/**
+ * Change the state of every device of a link.
+ * \param link The devices.
+ * \param up The new state.
+ */
+static void
+SetLink(NetDeviceContainer link, bool up)
+{
+    for (uint32_t i = 0; i < link.GetN(); i++)
+    {
+        MarkDirty(link.Get(i)->GetNode());
+        Ptr<Ipv4> ipv4 = link.Get(i)->GetNode()->GetObject<Ipv4>();
+        int32_t ifIndex = ipv4->GetInterfaceForDevice(link.Get(i));
+        if (ifIndex < 0)
+        {
+            continue;
+        }
+        if (up)
+        {
+            ipv4->SetUp(ifIndex);
+        }
+        else
+        {
+            ipv4->SetDown(ifIndex);
+        }
+    }
+}
+
+/**
+ * Take down the link the source currently uses towards the destination.
+ * \param loader The topology.
+ * \param src The source node.
+ * \param dst The destination address.
+ */
+static void
+FailLink(const TopologyLoader* loader, Ptr<Node> src, Ipv4Address dst)
+{
+    Ipv4Header header;
+    header.SetDestination(dst);
+    Socket::SocketErrno sockerr;
+    Ptr<Ipv4Route> route =
+        src->GetObject<Ipv4>()->GetRoutingProtocol()->RouteOutput(nullptr, header, nullptr, sockerr);
+    NS_ABORT_MSG_UNLESS(route, "No route from node " << src->GetId() << " to " << dst
+                                                     << " before the failure");
+    for (const auto& link : loader->GetLinks())
+    {
+        for (uint32_t i = 0; i < link.devices.GetN(); i++)
+        {
+            if (link.devices.Get(i) == route->GetOutputDevice())
+            {
+                g_failed = link.devices;
+            }
+        }
+    }
+    // The last change seen before each event closes the previous phase
+    g_initial = g_lastChange;
+    g_downAt = Simulator::Now();
+    SetLink(g_failed, false);
+}
+
+/**
+ * Bring the failed link back up.
+ */
+static void
+RepairLink()
+{
+    g_down = g_lastChange > g_downAt ? g_lastChange - g_downAt : Seconds(0);
+    SetLink(g_failed, true);
+}
+
+/**
+ * \param rows Rows of routers.
+ * \param cols Columns of routers.
+ * \return a topology file for the grid.
+ */
+static std::string
+Grid(uint32_t rows, uint32_t cols)
+{
+    std::ostringstream out;
+    out << "nodes " << rows * cols << "\n"
+        << "pool 10.0.0.0 255.255.255.252\n";
+    for (uint32_t r = 0; r < rows; r++)
+    {
+        for (uint32_t c = 0; c < cols; c++)
+        {
+            uint32_t n = r * cols + c;
+            if (c + 1 < cols)
+            {
+                out << "p2p " << n << " " << n + 1 << " rate=10Mbps delay=2ms\n";
+            }
+            if (r + 1 < rows)
+            {
+                out << "p2p " << n << " " << n + cols << " rate=10Mbps delay=2ms\n";
+            }
+        }
+    }
+    return out.str();
+}
+
+/**
+ * Run one simulation.
+ * \param strategy The split-horizon strategy.
+ * \param topology The topology file, used when grid is empty.
+ * \param grid RxC to generate a grid instead.
+ * \param src Source node, negative for the first one.
+ * \param dst Destination node, negative for the last one.
+ * \param warmup Time of the failure.
+ * \param downtime How long the link stays down.
+ * \param settle Observation time after the repair.
+ * \param poll Time between routing table samples.
+ */
+static void
+Run(std::string strategy,
+    std::string topology,
+    std::string grid,
+    int32_t src,
+    int32_t dst,
+    Time warmup,
+    Time downtime,
+    Time settle,
+    Time poll)
+{
+    if (strategy == "NoSplitHorizon")
+    {
+        Config::SetDefault("ns3::Rip::SplitHorizon", EnumValue(Rip::NO_SPLIT_HORIZON));
+    }
+    else if (strategy == "SplitHorizon")
+    {
+        Config::SetDefault("ns3::Rip::SplitHorizon", EnumValue(Rip::SPLIT_HORIZON));
+    }
+    else
+    {
+        NS_ABORT_MSG_UNLESS(strategy == "PoisonReverse", "Unknown strategy " << strategy);
+        Config::SetDefault("ns3::Rip::SplitHorizon", EnumValue(Rip::POISON_REVERSE));
+    }
+
+    RipHelper rip;
+    Ipv4ListRoutingHelper list;
+    list.Add(rip, 0);
+    TopologyLoader loader;
+    loader.GetInternetStack().SetRoutingHelper(list);
+    if (grid.empty())
+    {
+        loader.Load(topology);
+    }
+    else
+    {
+        std::size_t x = grid.find('x');
+        NS_ABORT_MSG_IF(x == std::string::npos, "--grid expects RxC, got " << grid);
+        std::istringstream text(Grid(std::stoul(grid.substr(0, x)), std::stoul(grid.substr(x + 1))));
+        loader.Load(text, "grid " + grid);
+    }
+
+    NodeContainer nodes = loader.GetNodes();
+    Ptr<Node> source = nodes.Get(src < 0 ? 0 : src);
+    Ptr<Node> sink = nodes.Get(dst < 0 ? nodes.GetN() - 1 : dst);
+    Ipv4Address sinkAddress = sink->GetObject<Ipv4>()->GetAddress(1, 0).GetLocal();
+
+    Time stop = warmup + downtime + settle;
+    uint16_t port = 9;
+    OnOffHelper onoff("ns3::UdpSocketFactory", InetSocketAddress(sinkAddress, port));
+    onoff.SetConstantRate(DataRate("51200bps"), 64); // 100 packets/s
+    ApplicationContainer apps = onoff.Install(source);
+    apps.Start(Seconds(1));
+    apps.Stop(stop - Seconds(1));
+    apps.Get(0)->TraceConnectWithoutContext("Tx", MakeCallback(&DataTx));
+    PacketSinkHelper sinkHelper("ns3::UdpSocketFactory",
+                                InetSocketAddress(Ipv4Address::GetAny(), port));
+    apps = sinkHelper.Install(sink);
+    apps.Get(0)->TraceConnectWithoutContext("Rx", MakeCallback(&DataRx));
+    Config::ConnectWithoutContext("/NodeList/*/$ns3::Ipv4L3Protocol/Tx", MakeCallback(&Ipv4Tx));
+    Config::ConnectWithoutContext("/NodeList/*/$ns3::Ipv4L3Protocol/Rx", MakeCallback(&Ipv4Rx));
+
+    // RIP installs the routes of its own interfaces at start-up
+    g_tables.assign(nodes.GetN(), {});
+    g_dirty.assign(nodes.GetN(), false);
+    g_toPoll.clear();
+    for (uint32_t i = 0; i < nodes.GetN(); i++)
+    {
+        MarkDirty(nodes.Get(i));
+    }
+    g_lastChange = Seconds(0);
+    g_downAt = g_initial = g_down = Seconds(0);
+    g_controlPackets = g_controlBytes = g_sent = g_received = 0;
+
+    Simulator::Schedule(poll, &Poll, poll);
+    Simulator::Schedule(warmup, &FailLink, &loader, source, sinkAddress);
+    Simulator::Schedule(warmup + downtime, &RepairLink);
+    Simulator::Stop(stop);
+    Simulator::Run();
+    Time up = g_lastChange > warmup + downtime ? g_lastChange - warmup - downtime : Seconds(0);
+
+    std::cout << strategy << "," << nodes.GetN() << "," << loader.GetLinks().size() << ","
+              << g_initial.GetSeconds() << "," << g_down.GetSeconds() << "," << up.GetSeconds()
+              << ","
+              << g_controlPackets << "," << g_controlBytes << "," << g_sent << ","
+              << g_sent - std::min(g_sent, g_received) << std::endl;
+
+    Simulator::Destroy();
+    Ipv4AddressGenerator::Reset();
+}
+
+int
+main(int argc, char* argv[])
+{
+    std::string topology("scratch/wired-tcp-udp.topo");
+    std::string grid;
+    std::string strategies("NoSplitHorizon,SplitHorizon,PoisonReverse");
+    int32_t src = -1;
+    int32_t dst = -1;
+    double warmup = 60;
+    double downtime = 120;
+    double settle = 120;
+    double poll = 0.1;
+
+    CommandLine cmd(__FILE__);
+    cmd.AddValue("topology", "Topology file", topology);
+    cmd.AddValue("grid", "Generate a RxC router grid instead of reading --topology", grid);
+    cmd.AddValue("strategies", "Comma-separated split-horizon strategies", strategies);
+    cmd.AddValue("src", "Traffic source node, -1 for the first node", src);
+    cmd.AddValue("dst", "Traffic destination node, -1 for the last node", dst);
+    cmd.AddValue("warmup", "Seconds before the link failure", warmup);
+    cmd.AddValue("downtime", "Seconds the link stays down", downtime);
+    cmd.AddValue("settle", "Seconds observed after the repair", settle);
+    cmd.AddValue("poll", "Seconds between samples of the tables that may have changed", poll);
+    cmd.Parse(argc, argv);
+
+    std::cout << "strategy,routers,links,initial_s,down_s,up_s,control_packets,control_bytes,"
+                 "sent,lost"
+              << std::endl;
+    std::istringstream list(strategies);
+    std::string strategy;
+    while (std::getline(list, strategy, ','))
+    {
+        Run(strategy,
+            topology,
+            grid,
+            src,
+            dst,
+            Seconds(warmup),
+            Seconds(downtime),
+            Seconds(settle),
+            Seconds(poll));
+    }
+    return 0;
+}
@@ -0,0 +1,216 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Reads the files written by RoutingSnapshot (routing-snapshot.h).  It does
+ * not use ns-3, so it can also be built on its own:
+ *
+ *   g++ -O2 -o route-snapshot-tool scratch/route-snapshot-tool.cc
+ *
+ *   route-snapshot-tool routes.rsnap             one line per frame
+ *   route-snapshot-tool routes.rsnap 4 2.5       table of node 4 at 2.5 s
+ *   route-snapshot-tool routes.rsnap 4           table of node 4 at the end
+ */
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <set>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace
+{
+
+/** A routing entry, as in RoutingSnapshot::Entry. */
+struct Entry
+{
+    uint32_t destination; //!< Destination network or host.
+    uint32_t mask;        //!< Network mask.
+    uint32_t gateway;     //!< Gateway.
+    uint32_t interface;   //!< Outgoing interface index.
+    uint32_t metric;      //!< Metric.
+    uint8_t protocol;     //!< 0 static, 1 global, 2 other.
+
+    /**
+     * \param other Another entry.
+     * \return true if this entry sorts before the other one.
+     */
+    bool operator<(const Entry& other) const
+    {
+        return std::tie(destination, mask, protocol, gateway, interface, metric) <
+               std::tie(other.destination,
+                        other.mask,
+                        other.protocol,
+                        other.gateway,
+                        other.interface,
+                        other.metric);
+    }
+};
+
+/**
+ * \param in The file.
+ * \param value The value read.
+ * \return true on success.
+ */
+template <class T>
+bool
+Get(std::istream& in, T& value)
+{
+    return bool(in.read(reinterpret_cast<char*>(&value), sizeof(value)));
+}
+
+/**
+ * \param in The file.
+ * \param entries The entries read, preceded by their count.
+ * \return true on success.
+ */
+bool
+GetEntries(std::istream& in, std::vector<Entry>& entries)
+{
+    uint32_t n;
+    if (!Get(in, n))
+    {
+        return false;
+    }
+    entries.resize(n);
+    for (auto& entry : entries)
+    {
+        if (!(Get(in, entry.destination) && Get(in, entry.mask) && Get(in, entry.gateway) &&
+              Get(in, entry.interface) && Get(in, entry.metric) && Get(in, entry.protocol)))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * \param address An address in host byte order.
+ * \return the dotted-quad notation.
+ */
+std::string
+Dotted(uint32_t address)
+{
+    char text[16];
+    std::snprintf(text,
+                  sizeof(text),
+                  "%u.%u.%u.%u",
+                  address >> 24,
+                  (address >> 16) & 0xff,
+                  (address >> 8) & 0xff,
+                  address & 0xff);
+    return text;
+}
+
+} // namespace
+
+int
+main(int argc, char* argv[])
+{
+    if (argc < 2 || argc > 4)
+    {
+        std::cerr << "usage: " << argv[0] << " FILE [NODE [TIME_S]]" << std::endl;
+        return 1;
+    }
+    std::ifstream in(argv[1], std::ios::binary);
+    char magic[4];
+    uint32_t version;
+    if (!in.read(magic, 4) || std::memcmp(magic, "RSNP", 4) != 0 || !Get(in, version) ||
+        version != 1)
+    {
+        std::cerr << argv[1] << ": not a version 1 routing snapshot file" << std::endl;
+        return 1;
+    }
+
+    bool summary = argc == 2;
+    uint32_t node = summary ? 0 : std::strtoul(argv[2], nullptr, 10);
+    int64_t until = argc == 4 ? int64_t(std::strtod(argv[3], nullptr) * 1e9)
+                              : std::numeric_limits<int64_t>::max();
+
+    if (summary)
+    {
+        std::cout << "time_s,nodes_changed,removed,added" << std::endl;
+    }
+    std::multiset<Entry> table; // a table can hold the same route twice
+    int64_t time;
+    int64_t tableTime = -1;
+    std::vector<Entry> removed;
+    std::vector<Entry> added;
+    while (Get(in, time) && time <= until)
+    {
+        uint32_t nodes;
+        if (!Get(in, nodes))
+        {
+            break;
+        }
+        uint64_t nRemoved = 0;
+        uint64_t nAdded = 0;
+        for (uint32_t i = 0; i < nodes; i++)
+        {
+            uint32_t id;
+            if (!(Get(in, id) && GetEntries(in, removed) && GetEntries(in, added)))
+            {
+                std::cerr << argv[1] << ": truncated frame at " << time * 1e-9 << " s"
+                          << std::endl;
+                return 1;
+            }
+            nRemoved += removed.size();
+            nAdded += added.size();
+            if (!summary && id == node)
+            {
+                for (const auto& entry : removed)
+                {
+                    auto it = table.find(entry);
+                    if (it != table.end())
+                    {
+                        table.erase(it);
+                    }
+                }
+                table.insert(added.begin(), added.end());
+                tableTime = time;
+            }
+        }
+        if (summary)
+        {
+            std::cout << time * 1e-9 << "," << nodes << "," << nRemoved << "," << nAdded
+                      << std::endl;
+        }
+    }
+    if (summary)
+    {
+        return 0;
+    }
+
+    static const char* protocols[] = {"static", "global", "other"};
+    std::cout << "Node " << node << ", last changed at " << tableTime * 1e-9 << " s" << std::endl
+              << "Destination     Gateway         Genmask         Proto  Metric Iface" << std::endl;
+    for (const auto& entry : table)
+    {
+        std::printf("%-16s%-16s%-16s%-7s%-7u%d\n",
+                    Dotted(entry.destination).c_str(),
+                    Dotted(entry.gateway).c_str(),
+                    Dotted(entry.mask).c_str(),
+                    protocols[entry.protocol < 3 ? entry.protocol : 2],
+                    entry.metric,
+                    entry.interface == UINT32_MAX ? -1 : int(entry.interface));
+    }
+    return 0;
+}
@@ -0,0 +1,510 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Periodic binary snapshots of every node's IPv4 routing table.
+ *
+ * Ipv4RoutingHelper::PrintRoutingTableAllAt() writes the full text table of
+ * every node each time it is called, which is far too much output to watch
+ * convergence at a fine time step.  RoutingSnapshot keeps the previous table
+ * of each node and only writes what changed: the first frame is the
+ * baseline (a delta from empty tables), later frames hold the entries that
+ * were removed and added since the previous one.  A changed entry shows up
+ * as one removal and one addition.  Frames without changes are not written.
+ *
+ *   Ptr<RoutingSnapshot> snapshot = Create<RoutingSnapshot>("routes.rsnap");
+ *   snapshot->Start(MilliSeconds(100), Seconds(20));
+ *
+ * route-snapshot-tool rebuilds the table of any node at any time from the
+ * file.  Entries of Ipv4StaticRouting and Ipv4GlobalRouting are read
+ * directly; other protocols (e.g. RIP) are read from their printed table.
+ *
+ * Both protocols only give their routes by index, and GetRoute(i) walks
+ * their lists, so reading a table of R routes costs O(R^2).  A snapshot
+ * therefore re-reads them only after they may have changed.  Start() adds
+ * a passive protocol to each node's Ipv4ListRouting that sees interface
+ * and address changes, which are what makes static routing change its
+ * connected routes and global routing (or IncrementalGlobalRouting)
+ * recompute.  Routes changed any other way, e.g. by calling
+ * Ipv4GlobalRoutingHelper::RecomputeRoutingTables() from a scheduled
+ * event, need NotifyRoutesChanged().  Nodes without Ipv4ListRouting, and
+ * every node when Capture() is called without Start(), are always read in
+ * full.
+ *
+ * File format, integers in host byte order:
+ *
+ *   header: char[4] "RSNP", uint32 version (1)
+ *   frame:  int64 time (ns), uint32 nodes, then per node:
+ *           uint32 node id, uint32 removed, Entry[removed],
+ *                           uint32 added, Entry[added]
+ *   Entry:  uint32 destination, uint32 mask, uint32 gateway,
+ *           uint32 interface, uint32 metric, uint8 protocol
+ *           (0 static, 1 global, 2 other)
+ */
+
+#ifndef ROUTING_SNAPSHOT_H
+#define ROUTING_SNAPSHOT_H
+
+#include "ns3/abort.h"
+#include "ns3/ipv4-global-routing.h"
+#include "ns3/ipv4-list-routing.h"
+#include "ns3/ipv4-static-routing.h"
+#include "ns3/ipv4.h"
+#include "ns3/node-list.h"
+#include "ns3/node.h"
+#include "ns3/output-stream-wrapper.h"
+#include "ns3/simple-ref-count.h"
+#include "ns3/simulator.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * Writes delta-encoded routing table snapshots of all nodes.
+ */
+class RoutingSnapshot : public SimpleRefCount<RoutingSnapshot>
+{
+  public:
+    /** One routing table entry as stored in the file. */
+    struct Entry
+    {
+        uint32_t destination; //!< Destination network or host.
+        uint32_t mask;        //!< Network mask.
+        uint32_t gateway;     //!< Gateway, 0.0.0.0 if directly connected.
+        uint32_t interface;   //!< Outgoing interface index.
+        uint32_t metric;      //!< Metric, 0 if the protocol has none.
+        uint8_t protocol;     //!< 0 static, 1 global, 2 other.
+
+        /**
+         * \param other Another entry.
+         * \return true if this entry sorts before the other one.
+         */
+        bool operator<(const Entry& other) const
+        {
+            return std::tie(destination, mask, protocol, gateway, interface, metric) <
+                   std::tie(other.destination,
+                            other.mask,
+                            other.protocol,
+                            other.gateway,
+                            other.interface,
+                            other.metric);
+        }
+
+        /**
+         * \param other Another entry.
+         * \return true if both entries are the same.
+         */
+        bool operator==(const Entry& other) const
+        {
+            return !(*this < other) && !(other < *this);
+        }
+    };
+
+    /**
+     * Open the snapshot file and write its header.
+     * \param filename The file.
+     */
+    RoutingSnapshot(const std::string& filename);
+
+    /**
+     * Take a snapshot now and then every interval until stop.
+     * \param interval Time between snapshots.
+     * \param stop Time of the last snapshot.
+     */
+    void Start(Time interval, Time stop);
+
+    /**
+     * Take a snapshot of all nodes now.
+     */
+    void Capture();
+
+    /**
+     * Re-read the static and global routes of every node at the next
+     * snapshot, after they were changed without an interface event.
+     */
+    void NotifyRoutesChanged();
+
+    /** \return the number of bytes written so far. */
+    uint64_t GetBytes();
+
+    /**
+     * \param node A node.
+     * \return the current routing entries of the node, sorted.
+     */
+    static std::vector<Entry> Read(Ptr<Node> node);
+
+  private:
+    /** Passive routing protocol that reports interface events. */
+    class Hook : public Ipv4RoutingProtocol
+    {
+      public:
+        /**
+         * \param owner The snapshot to notify.
+         */
+        Hook(Ptr<RoutingSnapshot> owner)
+            : m_owner(owner)
+        {
+        }
+
+        Ptr<Ipv4Route> RouteOutput(Ptr<Packet> p,
+                                   const Ipv4Header& header,
+                                   Ptr<NetDevice> oif,
+                                   Socket::SocketErrno& sockerr) override
+        {
+            sockerr = Socket::ERROR_NOROUTETOHOST;
+            return nullptr;
+        }
+
+        bool RouteInput(Ptr<const Packet> p,
+                        const Ipv4Header& header,
+                        Ptr<const NetDevice> idev,
+                        const UnicastForwardCallback& ucb,
+                        const MulticastForwardCallback& mcb,
+                        const LocalDeliverCallback& lcb,
+                        const ErrorCallback& ecb) override
+        {
+            return false;
+        }
+
+        void NotifyInterfaceUp(uint32_t interface) override
+        {
+            m_owner->NotifyRoutesChanged();
+        }
+
+        void NotifyInterfaceDown(uint32_t interface) override
+        {
+            m_owner->NotifyRoutesChanged();
+        }
+
+        void NotifyAddAddress(uint32_t interface, Ipv4InterfaceAddress address) override
+        {
+            m_owner->NotifyRoutesChanged();
+        }
+
+        void NotifyRemoveAddress(uint32_t interface, Ipv4InterfaceAddress address) override
+        {
+            m_owner->NotifyRoutesChanged();
+        }
+
+        void SetIpv4(Ptr<Ipv4> ipv4) override
+        {
+        }
+
+        void PrintRoutingTable(Ptr<OutputStreamWrapper> stream,
+                               Time::Unit unit = Time::S) const override
+        {
+        }
+
+      private:
+        Ptr<RoutingSnapshot> m_owner; //!< The snapshot.
+    };
+
+    /**
+     * \param node A node.
+     * \param known The static and global entries of the node, sorted;
+     *        replaced if reread.
+     * \param reread Whether to read the static and global entries again.
+     * \return the current routing entries of the node, sorted.
+     */
+    static std::vector<Entry> Read(Ptr<Node> node, std::vector<Entry>& known, bool reread);
+
+    /**
+     * Periodic snapshot.
+     * \param interval Time between snapshots.
+     * \param stop Time of the last snapshot.
+     */
+    void Tick(Time interval, Time stop);
+
+    /**
+     * Append the entries of a protocol that has no entry accessors, from its
+     * printed table.
+     * \param protocol The routing protocol.
+     * \param entries The entries to append to.
+     */
+    static void ReadPrinted(Ptr<Ipv4RoutingProtocol> protocol, std::vector<Entry>& entries);
+
+    /**
+     * \param entries Entries to write, preceded by their count.
+     */
+    void Write(const std::vector<Entry>& entries);
+
+    /**
+     * \param value A value to write.
+     */
+    template <class T>
+    void Put(T value)
+    {
+        m_out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+
+    std::ofstream m_out;                      //!< Snapshot file.
+    std::vector<std::vector<Entry>> m_tables; //!< Last written table, by node id.
+    std::vector<std::vector<Entry>> m_known;  //!< Static and global entries, by node id.
+    std::vector<bool> m_watched;              //!< Whether a node reports its changes.
+    Time m_changed;                           //!< Time of the last change notification.
+    Time m_lastCapture = TimeStep(-1);        //!< Time of the previous snapshot.
+};
+
+RoutingSnapshot::RoutingSnapshot(const std::string& filename)
+    : m_out(filename, std::ios::binary)
+{
+    NS_ABORT_MSG_UNLESS(m_out, "Cannot open " << filename);
+    m_out.write("RSNP", 4);
+    Put<uint32_t>(1);
+}
+
+void
+RoutingSnapshot::Start(Time interval, Time stop)
+{
+    m_watched.assign(NodeList::GetNNodes(), false);
+    for (uint32_t id = 0; id < NodeList::GetNNodes(); id++)
+    {
+        Ptr<Ipv4> ipv4 = NodeList::GetNode(id)->GetObject<Ipv4>();
+        Ptr<Ipv4ListRouting> list =
+            ipv4 ? DynamicCast<Ipv4ListRouting>(ipv4->GetRoutingProtocol()) : nullptr;
+        if (list)
+        {
+            list->AddRoutingProtocol(CreateObject<Hook>(Ptr<RoutingSnapshot>(this)), -30);
+            m_watched[id] = true;
+        }
+    }
+    Simulator::ScheduleNow(&RoutingSnapshot::Tick, Ptr<RoutingSnapshot>(this), interval, stop);
+}
+
+void
+RoutingSnapshot::Tick(Time interval, Time stop)
+{
+    Capture();
+    if (Simulator::Now() + interval <= stop)
+    {
+        Simulator::Schedule(interval,
+                            &RoutingSnapshot::Tick,
+                            Ptr<RoutingSnapshot>(this),
+                            interval,
+                            stop);
+    }
+    else
+    {
+        m_out.flush();
+    }
+}
+
+uint64_t
+RoutingSnapshot::GetBytes()
+{
+    return m_out.tellp();
+}
+
+void
+RoutingSnapshot::ReadPrinted(Ptr<Ipv4RoutingProtocol> protocol, std::vector<Entry>& entries)
+{
+    // Destination Gateway Genmask Flags Metric Ref Use Iface
+    std::ostringstream text;
+    protocol->PrintRoutingTable(Create<OutputStreamWrapper>(&text));
+    std::istringstream lines(text.str());
+    std::string line;
+    while (std::getline(lines, line))
+    {
+        std::istringstream words(line);
+        std::string destination;
+        std::string gateway;
+        std::string mask;
+        std::string flags;
+        std::string metric;
+        std::string ref;
+        std::string use;
+        std::string iface;
+        if (!(words >> destination >> gateway >> mask >> flags >> metric >> ref >> use >> iface) ||
+            destination.find_first_not_of("0123456789.") != std::string::npos ||
+            std::count(destination.begin(), destination.end(), '.') != 3)
+        {
+            continue;
+        }
+        bool numeric = iface.find_first_not_of("0123456789") == std::string::npos;
+        entries.push_back({Ipv4Address(destination.c_str()).Get(),
+                           Ipv4Mask(mask.c_str()).Get(),
+                           Ipv4Address(gateway.c_str()).Get(),
+                           numeric ? uint32_t(std::stoul(iface)) : UINT32_MAX,
+                           metric == "-" ? 0 : uint32_t(std::stoul(metric)),
+                           2});
+    }
+}
+
+void
+RoutingSnapshot::NotifyRoutesChanged()
+{
+    m_changed = Simulator::Now();
+}
+
+std::vector<RoutingSnapshot::Entry>
+RoutingSnapshot::Read(Ptr<Node> node)
+{
+    std::vector<Entry> known;
+    return Read(node, known, true);
+}
+
+std::vector<RoutingSnapshot::Entry>
+RoutingSnapshot::Read(Ptr<Node> node, std::vector<Entry>& known, bool reread)
+{
+    std::vector<Entry> entries;
+    Ptr<Ipv4> ipv4 = node->GetObject<Ipv4>();
+    if (!ipv4)
+    {
+        known.clear();
+        return entries;
+    }
+
+    std::vector<Ptr<Ipv4RoutingProtocol>> protocols;
+    Ptr<Ipv4ListRouting> list = DynamicCast<Ipv4ListRouting>(ipv4->GetRoutingProtocol());
+    if (list)
+    {
+        for (uint32_t i = 0; i < list->GetNRoutingProtocols(); i++)
+        {
+            int16_t priority;
+            protocols.push_back(list->GetRoutingProtocol(i, priority));
+        }
+    }
+    else
+    {
+        protocols.push_back(ipv4->GetRoutingProtocol());
+    }
+
+    if (reread)
+    {
+        known.clear();
+    }
+    for (const auto& protocol : protocols)
+    {
+        if (Ptr<Ipv4StaticRouting> routing = DynamicCast<Ipv4StaticRouting>(protocol))
+        {
+            for (uint32_t i = 0; reread && i < routing->GetNRoutes(); i++)
+            {
+                Ipv4RoutingTableEntry route = routing->GetRoute(i);
+                known.push_back({route.GetDest().Get(),
+                                 route.GetDestNetworkMask().Get(),
+                                 route.GetGateway().Get(),
+                                 route.GetInterface(),
+                                 routing->GetMetric(i),
+                                 0});
+            }
+        }
+        else if (Ptr<Ipv4GlobalRouting> routing = DynamicCast<Ipv4GlobalRouting>(protocol))
+        {
+            for (uint32_t i = 0; reread && i < routing->GetNRoutes(); i++)
+            {
+                Ipv4RoutingTableEntry* route = routing->GetRoute(i);
+                known.push_back({route->GetDest().Get(),
+                                 route->GetDestNetworkMask().Get(),
+                                 route->GetGateway().Get(),
+                                 route->GetInterface(),
+                                 0,
+                                 1});
+            }
+        }
+        else if (protocol)
+        {
+            ReadPrinted(protocol, entries);
+        }
+    }
+    if (reread)
+    {
+        std::sort(known.begin(), known.end());
+    }
+    std::sort(entries.begin(), entries.end());
+    std::vector<Entry> all;
+    all.reserve(known.size() + entries.size());
+    std::merge(known.begin(), known.end(), entries.begin(), entries.end(), std::back_inserter(all));
+    return all;
+}
+
+void
+RoutingSnapshot::Write(const std::vector<Entry>& entries)
+{
+    Put<uint32_t>(entries.size());
+    for (const auto& entry : entries)
+    {
+        Put(entry.destination);
+        Put(entry.mask);
+        Put(entry.gateway);
+        Put(entry.interface);
+        Put(entry.metric);
+        Put(entry.protocol);
+    }
+}
+
+void
+RoutingSnapshot::Capture()
+{
+    m_tables.resize(NodeList::GetNNodes());
+    m_known.resize(NodeList::GetNNodes());
+    m_watched.resize(NodeList::GetNNodes(), false);
+    bool changed = m_changed >= m_lastCapture;
+    m_lastCapture = Simulator::Now();
+
+    struct Change
+    {
+        uint32_t node;
+        std::vector<Entry> removed;
+        std::vector<Entry> added;
+    };
+
+    std::vector<Change> changes;
+    for (uint32_t id = 0; id < NodeList::GetNNodes(); id++)
+    {
+        std::vector<Entry> table =
+            Read(NodeList::GetNode(id), m_known[id], changed || !m_watched[id]);
+        Change change{id, {}, {}};
+        std::set_difference(m_tables[id].begin(),
+                            m_tables[id].end(),
+                            table.begin(),
+                            table.end(),
+                            std::back_inserter(change.removed));
+        std::set_difference(table.begin(),
+                            table.end(),
+                            m_tables[id].begin(),
+                            m_tables[id].end(),
+                            std::back_inserter(change.added));
+        if (!change.removed.empty() || !change.added.empty())
+        {
+            changes.push_back(std::move(change));
+            m_tables[id] = std::move(table);
+        }
+    }
+    if (changes.empty())
+    {
+        return;
+    }
+
+    Put<int64_t>(Simulator::Now().GetNanoSeconds());
+    Put<uint32_t>(changes.size());
+    for (const auto& change : changes)
+    {
+        Put(change.node);
+        Write(change.removed);
+        Write(change.added);
+    }
+}
+
+} // namespace ns3
+
+#endif /* ROUTING_SNAPSHOT_H */
@@ -0,0 +1,467 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Constant-rate or bulk traffic source that can send several packets per
+ * event.
+ *
+ * Each packet is created like OnOffApplication's, with a zero-area payload
+ * and its own uid.  The name is historical: sending Packet::Copy() of one
+ * payload packet was tried and saves nothing worth keeping.  Copy() still
+ * allocates a Packet per send, ns-3 already recycles the buffer data of a
+ * fresh packet through its own free list, and every copy carries the uid
+ * of the original, which breaks NetAnim and uid-based trace analysis.
+ *
+ * With DataRate zero the source behaves like BulkSendApplication and fills
+ * the socket whenever it has room; otherwise it sends at a constant rate
+ * like an OnOffApplication that is always on: packet n (from 1) is sent at
+ * start + n * interval.
+ *
+ * BurstSize K > 1 sends K packets per simulator event instead of one, so a
+ * high-rate source costs K times fewer events.  A burst is sent at the
+ * nominal time of its last packet, so no packet leaves before an
+ * OnOffApplication would have sent it, and the packets of a burst still
+ * pending at stop whose nominal time has passed are sent by
+ * StopApplication(), so the packet count is OnOff's.  The timing is not:
+ * releasing each packet at its own time takes one event per packet (ns-3
+ * devices have no timed enqueue), so the packets of a burst reach the
+ * device back to back and on the wire the source is K times burstier.  It
+ * does not replace OnOffApplication where the spacing matters.  Each packet
+ * carries a SendTimeTag with its nominal send time, and delay and jitter
+ * are measured against the tag (see traffic-source-bench.cc), so they
+ * include the time a packet waited for its burst.
+ *
+ *   SharedPayloadSourceHelper source("ns3::TcpSocketFactory", InetSocketAddress(addr, port));
+ *   source.SetAttribute("MaxBytes", UintegerValue(0));
+ *   ApplicationContainer apps = source.Install(node);
+ */
+
+#ifndef SHARED_PAYLOAD_SOURCE_H
+#define SHARED_PAYLOAD_SOURCE_H
+
+#include "ns3/abort.h"
+#include "ns3/address.h"
+#include "ns3/application-container.h"
+#include "ns3/application.h"
+#include "ns3/data-rate.h"
+#include "ns3/event-id.h"
+#include "ns3/inet-socket-address.h"
+#include "ns3/node-container.h"
+#include "ns3/object-factory.h"
+#include "ns3/packet.h"
+#include "ns3/simulator.h"
+#include "ns3/socket.h"
+#include "ns3/string.h"
+#include "ns3/tag.h"
+#include "ns3/trace-source-accessor.h"
+#include "ns3/traced-callback.h"
+#include "ns3/udp-socket-factory.h"
+#include "ns3/uinteger.h"
+
+namespace ns3
+{
+
+/**
+ * Nominal send time of a packet sent in a burst.
+ */
+class SendTimeTag : public Tag
+{
+  public:
+    /**
+     * \brief Get the type ID.
+     * \return the object TypeId
+     */
+    static TypeId GetTypeId();
+    TypeId GetInstanceTypeId() const override;
+    uint32_t GetSerializedSize() const override;
+    void Serialize(TagBuffer i) const override;
+    void Deserialize(TagBuffer i) override;
+    void Print(std::ostream& os) const override;
+
+    /** \param time The nominal send time. */
+    void SetTime(Time time);
+
+    /** \return the nominal send time. */
+    Time GetTime() const;
+
+  private:
+    Time m_time; //!< Nominal send time.
+};
+
+/**
+ * Constant-rate or bulk source, optionally sending bursts.
+ */
+class SharedPayloadSource : public Application
+{
+  public:
+    /**
+     * \brief Get the type ID.
+     * \return the object TypeId
+     */
+    static TypeId GetTypeId();
+
+    SharedPayloadSource();
+
+    /** \return the number of bytes sent so far. */
+    uint64_t GetTotalBytes() const;
+
+  private:
+    void StartApplication() override;
+    void StopApplication() override;
+
+    /** Send one burst and schedule the next one (constant rate). */
+    void SendNext();
+
+    /**
+     * Send while the socket has room (bulk).
+     * \param socket The socket.
+     * \param available Free space in the send buffer.
+     */
+    void Fill(Ptr<Socket> socket, uint32_t available);
+
+    /**
+     * Connection established.
+     * \param socket The socket.
+     */
+    void Connected(Ptr<Socket> socket);
+
+    /**
+     * Connection failed.
+     * \param socket The socket.
+     */
+    void ConnectionFailed(Ptr<Socket> socket);
+
+    /**
+     * \return whether MaxBytes allows another packet.
+     */
+    bool CanSend() const;
+
+    /**
+     * Send a packet of the payload size.
+     * \param nominal Nominal send time to tag it with, if in a burst.
+     * \return whether the socket accepted it.
+     */
+    bool SendPayload(Time nominal = Time());
+
+    Address m_peer;                              //!< Remote address.
+    TypeId m_tid;                                //!< Socket factory type.
+    uint32_t m_packetSize;                       //!< Payload size.
+    DataRate m_rate;                             //!< Sending rate, zero for bulk.
+    uint64_t m_maxBytes;                         //!< Byte limit, zero for none.
+    uint32_t m_burstSize;                        //!< Packets per constant-rate event.
+    uint64_t m_totBytes;                         //!< Bytes sent.
+    bool m_connected;                            //!< Whether the socket is connected.
+    Ptr<Socket> m_socket;                        //!< The socket.
+    EventId m_sendEvent;                         //!< Next constant-rate send.
+    TracedCallback<Ptr<const Packet>> m_txTrace; //!< Packet sent.
+};
+
+/**
+ * Installs SharedPayloadSource applications, like BulkSendHelper.
+ */
+class SharedPayloadSourceHelper
+{
+  public:
+    /**
+     * \param protocol The socket factory type, e.g. "ns3::UdpSocketFactory".
+     * \param address The remote address.
+     */
+    SharedPayloadSourceHelper(std::string protocol, Address address)
+    {
+        m_factory.SetTypeId(SharedPayloadSource::GetTypeId());
+        m_factory.Set("Protocol", StringValue(protocol));
+        m_factory.Set("Remote", AddressValue(address));
+    }
+
+    /**
+     * \param name The attribute name.
+     * \param value The attribute value.
+     */
+    void SetAttribute(std::string name, const AttributeValue& value)
+    {
+        m_factory.Set(name, value);
+    }
+
+    /**
+     * \param nodes The nodes.
+     * \return one application per node.
+     */
+    ApplicationContainer Install(NodeContainer nodes) const
+    {
+        ApplicationContainer apps;
+        for (auto i = nodes.Begin(); i != nodes.End(); ++i)
+        {
+            Ptr<Application> app = m_factory.Create<Application>();
+            (*i)->AddApplication(app);
+            apps.Add(app);
+        }
+        return apps;
+    }
+
+  private:
+    ObjectFactory m_factory; //!< Application factory.
+};
+
+NS_OBJECT_ENSURE_REGISTERED(SendTimeTag);
+
+TypeId
+SendTimeTag::GetTypeId()
+{
+    static TypeId tid = TypeId("ns3::SendTimeTag")
+                            .SetParent<Tag>()
+                            .SetGroupName("Applications")
+                            .AddConstructor<SendTimeTag>();
+    return tid;
+}
+
+TypeId
+SendTimeTag::GetInstanceTypeId() const
+{
+    return GetTypeId();
+}
+
+uint32_t
+SendTimeTag::GetSerializedSize() const
+{
+    return 8;
+}
+
+void
+SendTimeTag::Serialize(TagBuffer i) const
+{
+    i.WriteU64(m_time.GetTimeStep());
+}
+
+void
+SendTimeTag::Deserialize(TagBuffer i)
+{
+    m_time = TimeStep(i.ReadU64());
+}
+
+void
+SendTimeTag::Print(std::ostream& os) const
+{
+    os << "nominal=" << m_time.As(Time::S);
+}
+
+void
+SendTimeTag::SetTime(Time time)
+{
+    m_time = time;
+}
+
+Time
+SendTimeTag::GetTime() const
+{
+    return m_time;
+}
+
+NS_OBJECT_ENSURE_REGISTERED(SharedPayloadSource);
+
+TypeId
+SharedPayloadSource::GetTypeId()
+{
+    static TypeId tid =
+        TypeId("ns3::SharedPayloadSource")
+            .SetParent<Application>()
+            .SetGroupName("Applications")
+            .AddConstructor<SharedPayloadSource>()
+            .AddAttribute("Remote",
+                          "The address of the destination",
+                          AddressValue(),
+                          MakeAddressAccessor(&SharedPayloadSource::m_peer),
+                          MakeAddressChecker())
+            .AddAttribute("Protocol",
+                          "The type of protocol to use.",
+                          TypeIdValue(UdpSocketFactory::GetTypeId()),
+                          MakeTypeIdAccessor(&SharedPayloadSource::m_tid),
+                          MakeTypeIdChecker())
+            .AddAttribute("PacketSize",
+                          "The size of the payload of each packet",
+                          UintegerValue(512),
+                          MakeUintegerAccessor(&SharedPayloadSource::m_packetSize),
+                          MakeUintegerChecker<uint32_t>(1))
+            .AddAttribute("DataRate",
+                          "Constant sending rate, 0bps to fill the socket like BulkSend",
+                          DataRateValue(DataRate("500kb/s")),
+                          MakeDataRateAccessor(&SharedPayloadSource::m_rate),
+                          MakeDataRateChecker())
+            .AddAttribute("MaxBytes",
+                          "The total number of bytes to send, 0 for no limit",
+                          UintegerValue(0),
+                          MakeUintegerAccessor(&SharedPayloadSource::m_maxBytes),
+                          MakeUintegerChecker<uint64_t>())
+            .AddAttribute("BurstSize",
+                          "Packets sent per event at a constant rate, tagged with their "
+                          "nominal send times when more than one",
+                          UintegerValue(1),
+                          MakeUintegerAccessor(&SharedPayloadSource::m_burstSize),
+                          MakeUintegerChecker<uint32_t>(1))
+            .AddTraceSource("Tx",
+                            "A new packet is sent",
+                            MakeTraceSourceAccessor(&SharedPayloadSource::m_txTrace),
+                            "ns3::Packet::TracedCallback");
+    return tid;
+}
+
+SharedPayloadSource::SharedPayloadSource()
+    : m_packetSize(512),
+      m_maxBytes(0),
+      m_burstSize(1),
+      m_totBytes(0),
+      m_connected(false)
+{
+}
+
+uint64_t
+SharedPayloadSource::GetTotalBytes() const
+{
+    return m_totBytes;
+}
+
+void
+SharedPayloadSource::StartApplication()
+{
+    NS_ABORT_MSG_IF(m_rate.GetBitRate() == 0 && m_maxBytes == 0 &&
+                        m_tid == UdpSocketFactory::GetTypeId(),
+                    "SharedPayloadSource: an unlimited bulk UDP source never yields");
+    if (!m_socket)
+    {
+        m_socket = Socket::CreateSocket(GetNode(), m_tid);
+        // Before Connect(), UDP sockets report success from within it
+        m_socket->SetConnectCallback(MakeCallback(&SharedPayloadSource::Connected, this),
+                                     MakeCallback(&SharedPayloadSource::ConnectionFailed, this));
+        if (InetSocketAddress::IsMatchingType(m_peer))
+        {
+            m_socket->Bind();
+        }
+        else
+        {
+            m_socket->Bind6();
+        }
+        m_socket->SetAllowBroadcast(true);
+        m_socket->Connect(m_peer);
+        m_socket->ShutdownRecv();
+        if (m_rate.GetBitRate() == 0)
+        {
+            m_socket->SetSendCallback(MakeCallback(&SharedPayloadSource::Fill, this));
+        }
+    }
+}
+
+void
+SharedPayloadSource::StopApplication()
+{
+    if (m_sendEvent.IsRunning() && m_burstSize > 1)
+    {
+        // The packets of the pending burst that OnOff would have sent by now
+        Time interval = m_rate.CalculateBytesTxTime(m_packetSize);
+        Time burstEnd = TimeStep(m_sendEvent.GetTs());
+        for (uint32_t i = 0; i < m_burstSize && CanSend(); i++)
+        {
+            Time nominal = burstEnd - interval * (m_burstSize - 1 - i);
+            if (nominal >= Simulator::Now())
+            {
+                break;
+            }
+            SendPayload(nominal);
+        }
+    }
+    Simulator::Cancel(m_sendEvent);
+    if (m_socket)
+    {
+        m_socket->Close();
+        m_connected = false;
+    }
+}
+
+bool
+SharedPayloadSource::CanSend() const
+{
+    return m_maxBytes == 0 || m_totBytes + m_packetSize <= m_maxBytes;
+}
+
+bool
+SharedPayloadSource::SendPayload(Time nominal)
+{
+    Ptr<Packet> packet = Create<Packet>(m_packetSize);
+    if (m_burstSize > 1)
+    {
+        SendTimeTag tag;
+        tag.SetTime(nominal);
+        packet->AddPacketTag(tag);
+    }
+    if (m_socket->Send(packet) < 0)
+    {
+        return false;
+    }
+    m_totBytes += m_packetSize;
+    m_txTrace(packet);
+    return true;
+}
+
+void
+SharedPayloadSource::SendNext()
+{
+    Time interval = m_rate.CalculateBytesTxTime(m_packetSize);
+    for (uint32_t i = 0; i < m_burstSize; i++)
+    {
+        if (!CanSend())
+        {
+            return;
+        }
+        SendPayload(Simulator::Now() - interval * (m_burstSize - 1 - i));
+    }
+    m_sendEvent = Simulator::Schedule(interval * m_burstSize, &SharedPayloadSource::SendNext, this);
+}
+
+void
+SharedPayloadSource::Fill(Ptr<Socket> socket, uint32_t available)
+{
+    while (m_connected && CanSend() && socket->GetTxAvailable() >= m_packetSize)
+    {
+        if (!SendPayload())
+        {
+            break;
+        }
+    }
+}
+
+void
+SharedPayloadSource::Connected(Ptr<Socket> socket)
+{
+    m_connected = true;
+    if (m_rate.GetBitRate() == 0)
+    {
+        Fill(socket, socket->GetTxAvailable());
+    }
+    else
+    {
+        // OnOffApplication sends its first packet one interval after start
+        Time interval = m_rate.CalculateBytesTxTime(m_packetSize);
+        m_sendEvent =
+            Simulator::Schedule(interval * m_burstSize, &SharedPayloadSource::SendNext, this);
+    }
+}
+
+void
+SharedPayloadSource::ConnectionFailed(Ptr<Socket> socket)
+{
+    NS_FATAL_ERROR("SharedPayloadSource: cannot connect to the remote address");
+}
+
+} // namespace ns3
+
+#endif /* SHARED_PAYLOAD_SOURCE_H */
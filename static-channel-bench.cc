@@ -0,0 +1,202 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Cost of a Wi-Fi channel whose nodes never move, with and without
+ * StaticChannelMatrix.
+ *
+ * --nodes ad hoc 802.11a nodes sit on a square grid, --spacing m apart,
+ * with the channel of YansWifiChannelHelper::Default() (LogDistance loss,
+ * constant speed delay).  Every node broadcasts --rate of 200 byte UDP
+ * datagrams for --duration seconds.  The grid is wider than one radio
+ * range, so most receivers of a frame are out of reach.
+ *
+ * --channel picks the setup:
+ *   models     all PHYs on one channel asking the real models;
+ *   matrix     the same channel answering from a StaticChannelMatrix;
+ *   neighbors  the matrix plus InstallNeighborChannels(), so a frame is
+ *              only scheduled at the PHYs it reaches.
+ * All three should start the same receptions and deliver the same
+ * datagrams; what changes is the events and the wall time they take.
+ *
+ * One line is printed:
+ *   channel,nodes,pairs,events,rx_begin,rx_packets,setup_s,wall_s,max_rss_kb
+ * where pairs counts the transmitter/receiver pairs a frame is scheduled
+ * on, setup_s covers building the matrix and the channels, and wall_s
+ * Simulator::Run().
+ *
+ *   ./ns3 run "scratch/static-channel-bench --nodes=400 --channel=models"
+ *   ./ns3 run "scratch/static-channel-bench --nodes=400 --channel=matrix"
+ *   ./ns3 run "scratch/static-channel-bench --nodes=400 --channel=neighbors"
+ */
+
+#include "ns3/applications-module.h"
+#include "ns3/core-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/mobility-module.h"
+#include "ns3/network-module.h"
+#include "ns3/wifi-module.h"
+
+#include "static-channel-matrix.h"
+
+#include <sys/resource.h>
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <string>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE("StaticChannelBench");
+
+static uint64_t g_rxBegin = 0;  //!< Receptions started by the PHYs.
+static uint64_t g_received = 0; //!< Datagrams received by the sinks.
+
+/**
+ * Count a reception started by a PHY.
+ * \param packet The frame.
+ * \param power The received power per band.
+ */
+static void
+RxBegin(Ptr<const Packet> packet, RxPowerWattPerChannelBand power)
+{
+    g_rxBegin++;
+}
+
+/**
+ * Count a datagram received by a sink.
+ * \param packet The datagram.
+ * \param from Its source.
+ */
+static void
+Received(Ptr<const Packet> packet, const Address& from)
+{
+    g_received++;
+}
+
+int
+main(int argc, char* argv[])
+{
+    uint32_t nodes = 400;
+    double spacing = 50;
+    std::string rate("2kbps");
+    double duration = 10;
+    std::string channelKind("neighbors");
+
+    CommandLine cmd(__FILE__);
+    cmd.AddValue("nodes", "Number of nodes, on a square grid", nodes);
+    cmd.AddValue("spacing", "Distance between grid neighbors (m)", spacing);
+    cmd.AddValue("rate", "UDP broadcast rate of each node", rate);
+    cmd.AddValue("duration", "Simulated seconds of traffic", duration);
+    cmd.AddValue("channel", "Channel setup (models, matrix, neighbors)", channelKind);
+    cmd.Parse(argc, argv);
+
+    NS_ABORT_MSG_UNLESS(channelKind == "models" || channelKind == "matrix" ||
+                            channelKind == "neighbors",
+                        "Unknown channel " << channelKind);
+    NS_ABORT_MSG_UNLESS(nodes >= 2, "Need at least two nodes");
+
+    NodeContainer wifiNodes;
+    wifiNodes.Create(nodes);
+
+    MobilityHelper mobility;
+    mobility.SetPositionAllocator("ns3::GridPositionAllocator",
+                                  "DeltaX",
+                                  DoubleValue(spacing),
+                                  "DeltaY",
+                                  DoubleValue(spacing),
+                                  "GridWidth",
+                                  UintegerValue(std::ceil(std::sqrt(nodes))),
+                                  "LayoutType",
+                                  StringValue("RowFirst"));
+    mobility.SetMobilityModel("ns3::ConstantPositionMobilityModel");
+    mobility.Install(wifiNodes);
+
+    Ptr<LogDistancePropagationLossModel> loss = CreateObject<LogDistancePropagationLossModel>();
+    Ptr<ConstantSpeedPropagationDelayModel> delay =
+        CreateObject<ConstantSpeedPropagationDelayModel>();
+    Ptr<YansWifiChannel> channel = CreateObject<YansWifiChannel>();
+    channel->SetPropagationLossModel(loss);
+    channel->SetPropagationDelayModel(delay);
+
+    WifiHelper wifi;
+    wifi.SetStandard(WIFI_STANDARD_80211a);
+    wifi.SetRemoteStationManager("ns3::ConstantRateWifiManager",
+                                 "DataMode",
+                                 StringValue("OfdmRate6Mbps"),
+                                 "ControlMode",
+                                 StringValue("OfdmRate6Mbps"));
+    WifiMacHelper mac;
+    mac.SetType("ns3::AdhocWifiMac");
+    YansWifiPhyHelper phy;
+    phy.SetChannel(channel);
+    NetDeviceContainer devices = wifi.Install(phy, mac, wifiNodes);
+    Config::ConnectWithoutContext(
+        "/NodeList/*/DeviceList/*/$ns3::WifiNetDevice/Phy/PhyRxBegin",
+        MakeCallback(&RxBegin));
+
+    InternetStackHelper internet;
+    internet.Install(wifiNodes);
+    Ipv4AddressHelper ipv4;
+    ipv4.SetBase("10.0.0.0", "255.255.0.0");
+    ipv4.Assign(devices);
+
+    uint16_t port = 9;
+    PacketSinkHelper sink("ns3::UdpSocketFactory", InetSocketAddress(Ipv4Address::GetAny(), port));
+    ApplicationContainer sinks = sink.Install(wifiNodes);
+    for (uint32_t i = 0; i < nodes; i++)
+    {
+        sinks.Get(i)->TraceConnectWithoutContext("Rx", MakeCallback(&Received));
+    }
+    OnOffHelper onoff("ns3::UdpSocketFactory",
+                      InetSocketAddress(Ipv4Address::GetBroadcast(), port));
+    onoff.SetConstantRate(DataRate(rate), 200);
+    for (uint32_t i = 0; i < nodes; i++)
+    {
+        ApplicationContainer app = onoff.Install(wifiNodes.Get(i));
+        app.Start(Seconds(1 + 0.0001 * i));
+        app.Stop(Seconds(1 + duration));
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    uint32_t pairs = nodes * (nodes - 1);
+    if (channelKind != "models")
+    {
+        Ptr<StaticChannelMatrix> matrix = Create<StaticChannelMatrix>(wifiNodes, loss, delay);
+        channel->SetPropagationLossModel(matrix->CreateLossModel());
+        channel->SetPropagationDelayModel(matrix->CreateDelayModel());
+        if (channelKind == "neighbors")
+        {
+            matrix->InstallNeighborChannels(devices);
+            pairs = matrix->GetNNeighbors();
+        }
+    }
+    std::chrono::duration<double> setup = std::chrono::steady_clock::now() - start;
+
+    start = std::chrono::steady_clock::now();
+    Simulator::Stop(Seconds(1.5 + duration));
+    Simulator::Run();
+    std::chrono::duration<double> wall = std::chrono::steady_clock::now() - start;
+
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    std::cout << channelKind << "," << nodes << "," << pairs << "," << Simulator::GetEventCount()
+              << "," << g_rxBegin << "," << g_received << "," << setup.count() << ","
+              << wall.count() << "," << usage.ru_maxrss << std::endl;
+
+    Simulator::Destroy();
+    return 0;
+}
@@ -0,0 +1,551 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Precomputed loss and delay between nodes that do not move.
+ *
+ * When every node of a channel sits on a ConstantPositionMobilityModel, the
+ * loss and delay between two of them never change, yet the channel asks
+ * its loss and delay models again for every receiver of every frame, and
+ * each answer reads both positions through virtual calls and takes a
+ * logarithm.  StaticChannelMatrix asks the real models once per pair and
+ * stores an N x N table of loss and delay.  StaticMatrixLossModel and
+ * StaticMatrixDelayModel answer from it with one table read; pairs it does
+ * not know are passed on to the real models.
+ *
+ * That alone only saves the model evaluations: YansWifiChannel::Send()
+ * still copies the PPDU and schedules a reception for every PHY on the
+ * channel, and receivers below their sensitivity drop the frame when it
+ * arrives.  Send() is not virtual, but a PHY transmits on whichever
+ * YansWifiChannel it was given, and a channel delivers to every PHY added
+ * to it.  InstallNeighborChannels() therefore gives each PHY a transmit
+ * channel of its own, holding only the PHYs its strongest frame reaches
+ * above their sensitivity (TxPowerEnd + TxGain - loss + RxGain), so a
+ * frame costs a scan over the real neighbors.  Receivers left out are
+ * exactly those the shared channel would have dropped on arrival.
+ * Afterwards each device's GetChannel() is its own transmit channel, so
+ * install them once the routes are populated (global routing finds the
+ * devices of a network through their channel).
+ *
+ * If a node is moved after all (CourseChange), its row and column are
+ * computed again, and with neighbor channels it hears and reaches every
+ * PHY from then on (a PHY cannot leave a YansWifiChannel; the models
+ * still give the right loss).  The real models must be deterministic,
+ * i.e. without fading.
+ *
+ *   Ptr<YansWifiChannel> channel = wifiChannel.Create();
+ *   ...set up positions...
+ *   if (StaticChannelMatrix::IsStatic(wifiNodes))
+ *   {
+ *       Ptr<StaticChannelMatrix> matrix = Create<StaticChannelMatrix>(wifiNodes, loss, delay);
+ *       channel->SetPropagationLossModel(matrix->CreateLossModel());
+ *       channel->SetPropagationDelayModel(matrix->CreateDelayModel());
+ *       matrix->InstallNeighborChannels(wifiDevices); // optional
+ *   }
+ *
+ * static-channel-bench.cc compares the three setups.
+ */
+
+#ifndef STATIC_CHANNEL_MATRIX_H
+#define STATIC_CHANNEL_MATRIX_H
+
+#include "ns3/abort.h"
+#include "ns3/constant-position-mobility-model.h"
+#include "ns3/mobility-model.h"
+#include "ns3/net-device-container.h"
+#include "ns3/node-container.h"
+#include "ns3/nstime.h"
+#include "ns3/propagation-delay-model.h"
+#include "ns3/propagation-loss-model.h"
+#include "ns3/simple-ref-count.h"
+#include "ns3/wifi-net-device.h"
+#include "ns3/yans-wifi-channel.h"
+#include "ns3/yans-wifi-phy.h"
+
+#include <unordered_map>
+#include <vector>
+
+namespace ns3
+{
+
+class StaticMatrixLossModel;
+class StaticMatrixDelayModel;
+
+/**
+ * N x N loss and delay between fixed nodes.
+ */
+class StaticChannelMatrix : public SimpleRefCount<StaticChannelMatrix>
+{
+  public:
+    /**
+     * \param nodes Nodes with a mobility model.
+     * \return whether all of them have a ConstantPositionMobilityModel.
+     */
+    static bool IsStatic(NodeContainer nodes);
+
+    /**
+     * Compute the matrix.
+     * \param nodes The nodes on the channel, with a mobility model.
+     * \param loss The loss model of the channel.
+     * \param delay The delay model of the channel.
+     */
+    StaticChannelMatrix(NodeContainer nodes,
+                        Ptr<PropagationLossModel> loss,
+                        Ptr<PropagationDelayModel> delay);
+
+    ~StaticChannelMatrix();
+
+    /** \return a loss model answering from this matrix. */
+    Ptr<StaticMatrixLossModel> CreateLossModel();
+
+    /** \return a delay model answering from this matrix. */
+    Ptr<StaticMatrixDelayModel> CreateDelayModel();
+
+    /**
+     * Give every device a transmit channel reaching only its neighbors.
+     * \param devices Wi-Fi devices with a YansWifiPhy, on nodes of the matrix.
+     */
+    void InstallNeighborChannels(NetDeviceContainer devices);
+
+    /** \return the number of transmitter/receiver pairs in the neighbor channels. */
+    uint32_t GetNNeighbors() const;
+
+    /** \return the number of nodes. */
+    uint32_t GetN() const;
+
+    /**
+     * \param model A mobility model.
+     * \return its index, or GetN() if it is not in the matrix.
+     */
+    uint32_t GetIndex(const MobilityModel* model) const;
+
+    /**
+     * \param from Index of the transmitter.
+     * \param to Index of the receiver.
+     * \return the loss in dB.
+     */
+    double GetLoss(uint32_t from, uint32_t to) const;
+
+    /**
+     * \param from Index of the transmitter.
+     * \param to Index of the receiver.
+     * \return the delay.
+     */
+    Time GetDelay(uint32_t from, uint32_t to) const;
+
+    /** \return the loss model the matrix was computed from. */
+    Ptr<PropagationLossModel> GetLossModel() const;
+
+    /** \return the delay model the matrix was computed from. */
+    Ptr<PropagationDelayModel> GetDelayModel() const;
+
+  private:
+    /**
+     * Compute the row and column of one node.
+     * \param i Its index.
+     */
+    void Compute(uint32_t i);
+
+    /**
+     * CourseChange sink.
+     * \param model The moved node's mobility model.
+     */
+    void CourseChanged(Ptr<const MobilityModel> model);
+
+    /**
+     * Let a PHY of the neighbor channels hear another one.
+     * \param from Device position of the transmitter.
+     * \param to Device position of the receiver.
+     */
+    void Connect(uint32_t from, uint32_t to);
+
+    std::vector<Ptr<MobilityModel>> m_models;                   //!< Model of each index.
+    std::unordered_map<const MobilityModel*, uint32_t> m_index; //!< Index of each model.
+    Ptr<PropagationLossModel> m_loss;                           //!< Real loss model.
+    Ptr<PropagationDelayModel> m_delay;                         //!< Real delay model.
+    std::vector<double> m_lossDb;                               //!< Loss by transmitter, receiver.
+    std::vector<int64_t> m_delays;                              //!< Delay in steps, same order.
+    std::vector<Ptr<YansWifiPhy>> m_phys;                       //!< PHYs with neighbor channels.
+    std::vector<uint32_t> m_phyIndex;                           //!< Matrix index of each PHY.
+    std::vector<bool> m_hears;                                  //!< By transmitter, receiver PHY.
+    uint32_t m_nNeighbors = 0;                                  //!< Pairs in the channels.
+};
+
+/**
+ * Loss model reading a StaticChannelMatrix.
+ */
+class StaticMatrixLossModel : public PropagationLossModel
+{
+  public:
+    /**
+     * \brief Get the type ID.
+     * \return the object TypeId
+     */
+    static TypeId GetTypeId();
+
+    /**
+     * \param matrix The matrix.
+     */
+    void SetMatrix(Ptr<StaticChannelMatrix> matrix);
+
+  private:
+    double DoCalcRxPower(double txPowerDbm,
+                         Ptr<MobilityModel> a,
+                         Ptr<MobilityModel> b) const override;
+    int64_t DoAssignStreams(int64_t stream) override;
+    void DoDispose() override;
+
+    Ptr<StaticChannelMatrix> m_matrix;                   //!< The matrix.
+    mutable const MobilityModel* m_lastSender = nullptr; //!< Transmitter of the last query.
+    mutable uint32_t m_lastIndex = 0;                    //!< Its index.
+};
+
+/**
+ * Delay model reading a StaticChannelMatrix.
+ */
+class StaticMatrixDelayModel : public PropagationDelayModel
+{
+  public:
+    /**
+     * \brief Get the type ID.
+     * \return the object TypeId
+     */
+    static TypeId GetTypeId();
+
+    /**
+     * \param matrix The matrix.
+     */
+    void SetMatrix(Ptr<StaticChannelMatrix> matrix);
+
+    Time GetDelay(Ptr<MobilityModel> a, Ptr<MobilityModel> b) const override;
+
+  private:
+    int64_t DoAssignStreams(int64_t stream) override;
+    void DoDispose() override;
+
+    Ptr<StaticChannelMatrix> m_matrix;                   //!< The matrix.
+    mutable const MobilityModel* m_lastSender = nullptr; //!< Transmitter of the last query.
+    mutable uint32_t m_lastIndex = 0;                    //!< Its index.
+};
+
+bool
+StaticChannelMatrix::IsStatic(NodeContainer nodes)
+{
+    for (uint32_t i = 0; i < nodes.GetN(); i++)
+    {
+        if (!DynamicCast<ConstantPositionMobilityModel>(
+                nodes.Get(i)->GetObject<MobilityModel>()))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+StaticChannelMatrix::StaticChannelMatrix(NodeContainer nodes,
+                                         Ptr<PropagationLossModel> loss,
+                                         Ptr<PropagationDelayModel> delay)
+    : m_loss(loss),
+      m_delay(delay)
+{
+    uint32_t n = nodes.GetN();
+    for (uint32_t i = 0; i < n; i++)
+    {
+        Ptr<MobilityModel> model = nodes.Get(i)->GetObject<MobilityModel>();
+        NS_ABORT_MSG_UNLESS(model, "Node " << nodes.Get(i)->GetId() << " has no mobility model");
+        m_index[PeekPointer(model)] = i;
+        m_models.push_back(model);
+    }
+    m_lossDb.resize(n * n);
+    m_delays.resize(n * n);
+    for (uint32_t i = 0; i < n; i++)
+    {
+        for (uint32_t j = 0; j < n; j++)
+        {
+            m_lossDb[i * n + j] = -m_loss->CalcRxPower(0, m_models[i], m_models[j]);
+            m_delays[i * n + j] = m_delay->GetDelay(m_models[i], m_models[j]).GetTimeStep();
+        }
+    }
+    for (const auto& model : m_models)
+    {
+        model->TraceConnectWithoutContext(
+            "CourseChange",
+            MakeCallback(&StaticChannelMatrix::CourseChanged, this));
+    }
+}
+
+StaticChannelMatrix::~StaticChannelMatrix()
+{
+    for (const auto& model : m_models)
+    {
+        model->TraceDisconnectWithoutContext(
+            "CourseChange",
+            MakeCallback(&StaticChannelMatrix::CourseChanged, this));
+    }
+}
+
+void
+StaticChannelMatrix::Compute(uint32_t i)
+{
+    uint32_t n = m_models.size();
+    for (uint32_t j = 0; j < n; j++)
+    {
+        m_lossDb[i * n + j] = -m_loss->CalcRxPower(0, m_models[i], m_models[j]);
+        m_lossDb[j * n + i] = -m_loss->CalcRxPower(0, m_models[j], m_models[i]);
+        m_delays[i * n + j] = m_delay->GetDelay(m_models[i], m_models[j]).GetTimeStep();
+        m_delays[j * n + i] = m_delay->GetDelay(m_models[j], m_models[i]).GetTimeStep();
+    }
+}
+
+void
+StaticChannelMatrix::CourseChanged(Ptr<const MobilityModel> model)
+{
+    auto it = m_index.find(PeekPointer(model));
+    if (it == m_index.end())
+    {
+        return;
+    }
+    Compute(it->second);
+    for (uint32_t i = 0; i < m_phys.size(); i++)
+    {
+        if (m_phyIndex[i] != it->second)
+        {
+            continue;
+        }
+        for (uint32_t j = 0; j < m_phys.size(); j++)
+        {
+            if (j != i)
+            {
+                Connect(i, j);
+                Connect(j, i);
+            }
+        }
+    }
+}
+
+void
+StaticChannelMatrix::InstallNeighborChannels(NetDeviceContainer devices)
+{
+    NS_ABORT_MSG_UNLESS(m_phys.empty(), "StaticChannelMatrix: neighbor channels already installed");
+    for (uint32_t i = 0; i < devices.GetN(); i++)
+    {
+        Ptr<WifiNetDevice> device = DynamicCast<WifiNetDevice>(devices.Get(i));
+        Ptr<YansWifiPhy> phy = device ? DynamicCast<YansWifiPhy>(device->GetPhy()) : nullptr;
+        NS_ABORT_MSG_UNLESS(phy, "StaticChannelMatrix: device " << i << " has no YansWifiPhy");
+        uint32_t index = GetIndex(PeekPointer(device->GetNode()->GetObject<MobilityModel>()));
+        NS_ABORT_MSG_IF(index == GetN(),
+                        "StaticChannelMatrix: node " << device->GetNode()->GetId()
+                                                     << " is not in the matrix");
+        m_phys.push_back(phy);
+        m_phyIndex.push_back(index);
+    }
+
+    uint32_t n = m_phys.size();
+    m_hears.assign(n * n, false);
+    for (uint32_t i = 0; i < n; i++)
+    {
+        // One channel per transmitter, so its models' last-sender cache always hits
+        Ptr<YansWifiChannel> channel = CreateObject<YansWifiChannel>();
+        channel->SetPropagationLossModel(CreateLossModel());
+        channel->SetPropagationDelayModel(CreateDelayModel());
+        m_phys[i]->SetChannel(channel);
+    }
+    for (uint32_t i = 0; i < n; i++)
+    {
+        double strongest = m_phys[i]->GetTxPowerEnd() + m_phys[i]->GetTxGain();
+        for (uint32_t j = 0; j < n; j++)
+        {
+            double rxDbm =
+                strongest - GetLoss(m_phyIndex[i], m_phyIndex[j]) + m_phys[j]->GetRxGain();
+            if (j != i && rxDbm >= m_phys[j]->GetRxSensitivity())
+            {
+                Connect(i, j);
+            }
+        }
+    }
+}
+
+void
+StaticChannelMatrix::Connect(uint32_t from, uint32_t to)
+{
+    uint32_t n = m_phys.size();
+    if (!m_hears[from * n + to])
+    {
+        m_hears[from * n + to] = true;
+        DynamicCast<YansWifiChannel>(m_phys[from]->GetChannel())->Add(m_phys[to]);
+        m_nNeighbors++;
+    }
+}
+
+uint32_t
+StaticChannelMatrix::GetNNeighbors() const
+{
+    return m_nNeighbors;
+}
+
+Ptr<StaticMatrixLossModel>
+StaticChannelMatrix::CreateLossModel()
+{
+    Ptr<StaticMatrixLossModel> model = CreateObject<StaticMatrixLossModel>();
+    model->SetMatrix(this);
+    return model;
+}
+
+Ptr<StaticMatrixDelayModel>
+StaticChannelMatrix::CreateDelayModel()
+{
+    Ptr<StaticMatrixDelayModel> model = CreateObject<StaticMatrixDelayModel>();
+    model->SetMatrix(this);
+    return model;
+}
+
+uint32_t
+StaticChannelMatrix::GetN() const
+{
+    return m_models.size();
+}
+
+uint32_t
+StaticChannelMatrix::GetIndex(const MobilityModel* model) const
+{
+    auto it = m_index.find(model);
+    return it == m_index.end() ? m_models.size() : it->second;
+}
+
+double
+StaticChannelMatrix::GetLoss(uint32_t from, uint32_t to) const
+{
+    return m_lossDb[from * m_models.size() + to];
+}
+
+Time
+StaticChannelMatrix::GetDelay(uint32_t from, uint32_t to) const
+{
+    return TimeStep(m_delays[from * m_models.size() + to]);
+}
+
+Ptr<PropagationLossModel>
+StaticChannelMatrix::GetLossModel() const
+{
+    return m_loss;
+}
+
+Ptr<PropagationDelayModel>
+StaticChannelMatrix::GetDelayModel() const
+{
+    return m_delay;
+}
+
+NS_OBJECT_ENSURE_REGISTERED(StaticMatrixLossModel);
+
+TypeId
+StaticMatrixLossModel::GetTypeId()
+{
+    static TypeId tid = TypeId("ns3::StaticMatrixLossModel")
+                            .SetParent<PropagationLossModel>()
+                            .SetGroupName("Propagation")
+                            .AddConstructor<StaticMatrixLossModel>();
+    return tid;
+}
+
+void
+StaticMatrixLossModel::SetMatrix(Ptr<StaticChannelMatrix> matrix)
+{
+    m_matrix = matrix;
+    m_lastSender = nullptr;
+}
+
+double
+StaticMatrixLossModel::DoCalcRxPower(double txPowerDbm,
+                                     Ptr<MobilityModel> a,
+                                     Ptr<MobilityModel> b) const
+{
+    if (PeekPointer(a) != m_lastSender)
+    {
+        m_lastSender = PeekPointer(a);
+        m_lastIndex = m_matrix->GetIndex(m_lastSender);
+    }
+    uint32_t to = m_matrix->GetIndex(PeekPointer(b));
+    if (m_lastIndex == m_matrix->GetN() || to == m_matrix->GetN())
+    {
+        return m_matrix->GetLossModel()->CalcRxPower(txPowerDbm, a, b);
+    }
+    return txPowerDbm - m_matrix->GetLoss(m_lastIndex, to);
+}
+
+int64_t
+StaticMatrixLossModel::DoAssignStreams(int64_t stream)
+{
+    return 0;
+}
+
+void
+StaticMatrixLossModel::DoDispose()
+{
+    m_matrix = nullptr;
+    PropagationLossModel::DoDispose();
+}
+
+NS_OBJECT_ENSURE_REGISTERED(StaticMatrixDelayModel);
+
+TypeId
+StaticMatrixDelayModel::GetTypeId()
+{
+    static TypeId tid = TypeId("ns3::StaticMatrixDelayModel")
+                            .SetParent<PropagationDelayModel>()
+                            .SetGroupName("Propagation")
+                            .AddConstructor<StaticMatrixDelayModel>();
+    return tid;
+}
+
+void
+StaticMatrixDelayModel::SetMatrix(Ptr<StaticChannelMatrix> matrix)
+{
+    m_matrix = matrix;
+    m_lastSender = nullptr;
+}
+
+Time
+StaticMatrixDelayModel::GetDelay(Ptr<MobilityModel> a, Ptr<MobilityModel> b) const
+{
+    if (PeekPointer(a) != m_lastSender)
+    {
+        m_lastSender = PeekPointer(a);
+        m_lastIndex = m_matrix->GetIndex(m_lastSender);
+    }
+    uint32_t to = m_matrix->GetIndex(PeekPointer(b));
+    if (m_lastIndex == m_matrix->GetN() || to == m_matrix->GetN())
+    {
+        return m_matrix->GetDelayModel()->GetDelay(a, b);
+    }
+    return m_matrix->GetDelay(m_lastIndex, to);
+}
+
+int64_t
+StaticMatrixDelayModel::DoAssignStreams(int64_t stream)
+{
+    return 0;
+}
+
+void
+StaticMatrixDelayModel::DoDispose()
+{
+    m_matrix = nullptr;
+    PropagationDelayModel::DoDispose();
+}
+
+} // namespace ns3
+
+#endif /* STATIC_CHANNEL_MATRIX_H */
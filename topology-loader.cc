@@ -0,0 +1,189 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Build a network from a topology file (see topology-loader.h) and report
+ * how long it took.
+ *
+ * --generate=RxC first writes a rows x cols grid of point-to-point routers
+ * to --topology, which is the quickest way to get a 100k-node file.
+ *
+ * With --failures the network is also simulated until --stop: --flows UDP
+ * CBR flows between random node pairs carry traffic while the links of the
+ * failure schedule (see failure-schedule.h) go down and up, and the
+ * routing losses of each event, with the time of the last one, are printed.
+ *
+ *   ./ns3 run "scratch/topology-loader --topology=scratch/wired-tcp-udp.topo --printRoutes"
+ *   ./ns3 run "scratch/topology-loader --topology=grid.topo --generate=316x316 --routing=none"
+ *   ./ns3 run "scratch/topology-loader --topology=grid.topo --generate=50x50
+ *              --failures=grid.failures --flows=200 --routing=incremental"
+ */
+
+#include "ns3/applications-module.h"
+#include "ns3/core-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/network-module.h"
+
+#include "failure-schedule.h"
+#include "incremental-global-routing.h"
+#include "topology-loader.h"
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE("TopologyLoaderExample");
+
+/**
+ * Write a grid topology file.
+ * \param filename The file.
+ * \param rows Rows of routers.
+ * \param cols Columns of routers.
+ */
+static void
+WriteGrid(const std::string& filename, uint32_t rows, uint32_t cols)
+{
+    std::ofstream out(filename);
+    NS_ABORT_MSG_UNLESS(out, "Cannot write " << filename);
+    out << "# " << rows << "x" << cols << " grid of routers\n"
+        << "nodes " << rows * cols << "\n"
+        << "pool 10.0.0.0 255.255.255.252\n";
+    for (uint32_t r = 0; r < rows; r++)
+    {
+        for (uint32_t c = 0; c < cols; c++)
+        {
+            uint32_t n = r * cols + c;
+            if (c + 1 < cols)
+            {
+                out << "p2p " << n << " " << n + 1 << " rate=1Gbps delay=1ms\n";
+            }
+            if (r + 1 < rows)
+            {
+                out << "p2p " << n << " " << n + cols << " rate=1Gbps delay=1ms\n";
+            }
+            out << "pos " << n << " " << c * 100 << " " << r * 100 << "\n";
+        }
+    }
+}
+
+int
+main(int argc, char* argv[])
+{
+    std::string topology("scratch/wired-tcp-udp.topo");
+    std::string generate;
+    std::string routing("global");
+    bool printRoutes = false;
+    std::string failures;
+    uint32_t flows = 100;
+    double stop = 30;
+
+    CommandLine cmd(__FILE__);
+    cmd.AddValue("topology", "Topology file", topology);
+    cmd.AddValue("generate", "Write a RxC router grid to the topology file first", generate);
+    cmd.AddValue("routing", "Routing to populate after loading (global, incremental, none)", routing);
+    cmd.AddValue("printRoutes", "Print all routing tables after population", printRoutes);
+    cmd.AddValue("failures", "Link failure schedule to simulate", failures);
+    cmd.AddValue("flows", "UDP flows between random node pairs with --failures", flows);
+    cmd.AddValue("stop", "Simulated seconds with --failures", stop);
+    cmd.Parse(argc, argv);
+
+    if (!generate.empty())
+    {
+        std::size_t x = generate.find('x');
+        NS_ABORT_MSG_IF(x == std::string::npos, "--generate expects RxC, got " << generate);
+        WriteGrid(topology, std::stoul(generate.substr(0, x)), std::stoul(generate.substr(x + 1)));
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    TopologyLoader loader;
+    loader.Load(topology);
+    std::chrono::duration<double> build = std::chrono::steady_clock::now() - start;
+
+    NS_ABORT_MSG_UNLESS(routing == "global" || routing == "incremental" || routing == "none",
+                        "Unknown routing " << routing);
+    start = std::chrono::steady_clock::now();
+    Ptr<IncrementalGlobalRouting> spf;
+    if (routing == "global")
+    {
+        Ipv4GlobalRoutingHelper::PopulateRoutingTables();
+    }
+    else if (routing == "incremental")
+    {
+        spf = Create<IncrementalGlobalRouting>();
+        spf->Install();
+        spf->Populate();
+    }
+    std::chrono::duration<double> populate = std::chrono::steady_clock::now() - start;
+
+    std::cout << topology << ": " << loader.GetNodes().GetN() << " nodes, "
+              << loader.GetLinks().size() << " links, built in " << build.count() << " s";
+    if (routing != "none")
+    {
+        std::cout << ", routes populated in " << populate.count() << " s";
+    }
+    std::cout << std::endl;
+
+    if (printRoutes)
+    {
+        Ptr<OutputStreamWrapper> stream = Create<OutputStreamWrapper>(&std::cout);
+        Ipv4RoutingHelper::PrintRoutingTableAllAt(Seconds(0), stream);
+        Simulator::Stop(Seconds(0));
+        Simulator::Run();
+    }
+
+    if (!failures.empty())
+    {
+        NodeContainer nodes = loader.GetNodes();
+        Ptr<UniformRandomVariable> pick = CreateObject<UniformRandomVariable>();
+        uint16_t port = 9;
+        PacketSinkHelper sink("ns3::UdpSocketFactory",
+                              InetSocketAddress(Ipv4Address::GetAny(), port));
+        sink.Install(nodes);
+        for (uint32_t i = 0; i < flows && nodes.GetN() > 1; i++)
+        {
+            uint32_t src = pick->GetInteger(0, nodes.GetN() - 1);
+            uint32_t dst = pick->GetInteger(0, nodes.GetN() - 2);
+            dst += (dst >= src);
+            Ipv4Address address = nodes.Get(dst)->GetObject<Ipv4>()->GetAddress(1, 0).GetLocal();
+            OnOffHelper onoff("ns3::UdpSocketFactory", InetSocketAddress(address, port));
+            onoff.SetConstantRate(DataRate("40kbps"), 500); // 10 packets/s
+            ApplicationContainer app = onoff.Install(nodes.Get(src));
+            app.Start(Seconds(1 + pick->GetValue(0, 1)));
+            app.Stop(Seconds(stop));
+        }
+
+        Ptr<FailureSchedule> schedule = Create<FailureSchedule>();
+        schedule->Load(failures);
+        if (routing == "global")
+        {
+            schedule->SetRecomputeCallback(
+                MakeCallback(&Ipv4GlobalRoutingHelper::RecomputeRoutingTables));
+        }
+        else if (routing == "incremental")
+        {
+            schedule->SetRecomputeCallback(MakeCallback(&IncrementalGlobalRouting::Flush, spf));
+        }
+        schedule->Start();
+        Simulator::Stop(Seconds(stop));
+        Simulator::Run();
+        schedule->PrintReport(std::cout);
+    }
+
+    Simulator::Destroy();
+    return 0;
+}
@@ -0,0 +1,494 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Declarative topology files for the scratch programs.
+ *
+ * One directive per line, '#' starts a comment, node ids are 0-based and
+ * id lists accept ranges ("4-8,10"):
+ *
+ *   nodes <count>
+ *   pool <network> <mask>                      links below get consecutive
+ *                                              subnets of this size
+ *   p2p <a> <b> [rate=] [delay=] [queue=]
+ *   csma <ids> [rate=] [delay=] [queue=]
+ *   wifi ap=<ids> sta=<ids> [ssid=] [standard=80211b|80211g|80211n|80211ac]
+ *   pos <id> <x> <y> [z]
+ *
+ * Every p2p, csma or wifi line is one subnet taken from the current pool,
+ * unless it carries address=no.
+ * The file is parsed completely before anything is created, then all nodes
+ * are created at once, devices are installed through one helper per
+ * distinct (rate, delay, queue), the internet stack is installed once and
+ * addresses are assigned link by link.  Nodes with a position or a Wi-Fi
+ * device get a ConstantPositionMobilityModel.
+ *
+ *   TopologyLoader topology;
+ *   topology.Load("wired-tcp-udp.topo");
+ *   Ipv4GlobalRoutingHelper::PopulateRoutingTables();
+ */
+
+#ifndef TOPOLOGY_LOADER_H
+#define TOPOLOGY_LOADER_H
+
+#include "ns3/abort.h"
+#include "ns3/constant-position-mobility-model.h"
+#include "ns3/csma-helper.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-address-helper.h"
+#include "ns3/mobility-helper.h"
+#include "ns3/node-container.h"
+#include "ns3/point-to-point-helper.h"
+#include "ns3/ssid.h"
+#include "ns3/string.h"
+#include "ns3/yans-wifi-helper.h"
+
+#include <cctype>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * Builds nodes, devices and addresses from a topology file.
+ */
+class TopologyLoader
+{
+  public:
+    /** One p2p link, CSMA segment or Wi-Fi BSS. */
+    struct Link
+    {
+        std::string type;                  //!< "p2p", "csma" or "wifi".
+        std::vector<uint32_t> nodes;       //!< Attached node ids, APs first for Wi-Fi.
+        NetDeviceContainer devices;        //!< Devices, in the order of nodes.
+        Ipv4InterfaceContainer interfaces; //!< Interfaces, in the order of nodes.
+        bool addressed;                    //!< False for address=no.
+    };
+
+    /**
+     * Parse a topology file and build it.
+     * \param filename The file.
+     */
+    void Load(const std::string& filename);
+
+    /**
+     * Parse a topology description and build it.
+     * \param in The description.
+     * \param name The name used in error messages.
+     */
+    void Load(std::istream& in, const std::string& name);
+
+    /**
+     * \return the stack helper used by Load(), e.g. to set a routing helper
+     * before loading.
+     */
+    InternetStackHelper& GetInternetStack();
+
+    /** \return the nodes, indexed by their id in the file. */
+    NodeContainer GetNodes() const;
+
+    /** \return the links, in file order. */
+    const std::vector<Link>& GetLinks() const;
+
+    /** \return the helper the Wi-Fi devices were installed with, for tracing. */
+    YansWifiPhyHelper& GetWifiPhy();
+
+  private:
+    /** A parsed directive. */
+    struct Directive
+    {
+        uint32_t line;                            //!< Line number.
+        std::vector<std::string> args;            //!< Positional arguments.
+        std::map<std::string, std::string> opts;  //!< key=value options.
+    };
+
+    /**
+     * Parse an unsigned number, aborting with the file and line if it is not one.
+     * \param d The directive, for error messages.
+     * \param word The number.
+     * \return its value.
+     */
+    uint32_t ToUint(const Directive& d, const std::string& word) const;
+
+    /**
+     * Parse a real number, aborting with the file and line if it is not one.
+     * \param d The directive, for error messages.
+     * \param word The number.
+     * \return its value.
+     */
+    double ToDouble(const Directive& d, const std::string& word) const;
+
+    /**
+     * Parse a single node id.
+     * \param d The directive, for error messages.
+     * \param word The id.
+     * \return the id.
+     */
+    uint32_t ParseId(const Directive& d, const std::string& word) const;
+
+    /**
+     * Parse a list of node ids.
+     * \param d The directive, for error messages.
+     * \param list The list ("1,3-5").
+     * \return the ids.
+     */
+    std::vector<uint32_t> ParseIds(const Directive& d, const std::string& list) const;
+
+    /**
+     * \param d A directive.
+     * \param key An option name.
+     * \param def The default.
+     * \return the option value or the default.
+     */
+    static std::string Opt(const Directive& d, const std::string& key, const std::string& def);
+
+    /**
+     * \param d A directive.
+     * \return the point-to-point helper for the directive's attributes.
+     */
+    PointToPointHelper& P2p(const Directive& d);
+
+    /**
+     * \param d A directive.
+     * \return the CSMA helper for the directive's attributes.
+     */
+    CsmaHelper& Csma(const Directive& d);
+
+    /**
+     * Assign a subnet of the current pool to a link.
+     * \param link The link.
+     * \param pool The current pool.
+     */
+    void Address(Link& link, Ipv4AddressHelper& pool);
+
+    std::string m_name;                                //!< Input name for errors.
+    NodeContainer m_nodes;                             //!< All nodes.
+    std::vector<Link> m_links;                         //!< All links.
+    std::map<std::string, PointToPointHelper> m_p2p;   //!< Helper per attribute set.
+    std::map<std::string, CsmaHelper> m_csma;          //!< Helper per attribute set.
+    YansWifiPhyHelper m_wifiPhy;                       //!< Shared by all BSSs.
+    InternetStackHelper m_internet;                    //!< Installed on all nodes.
+};
+
+std::string
+TopologyLoader::Opt(const Directive& d, const std::string& key, const std::string& def)
+{
+    auto it = d.opts.find(key);
+    return it == d.opts.end() ? def : it->second;
+}
+
+uint32_t
+TopologyLoader::ToUint(const Directive& d, const std::string& word) const
+{
+    std::istringstream in(word);
+    uint32_t value;
+    // operator>> would wrap a leading '-' around instead of failing.
+    NS_ABORT_MSG_UNLESS(!word.empty() && std::isdigit(static_cast<unsigned char>(word[0])) &&
+                            (in >> value) && in.eof(),
+                        m_name << ":" << d.line << ": expected an unsigned number, got '"
+                               << word << "'");
+    return value;
+}
+
+double
+TopologyLoader::ToDouble(const Directive& d, const std::string& word) const
+{
+    std::istringstream in(word);
+    double value;
+    NS_ABORT_MSG_UNLESS((in >> value) && in.eof(),
+                        m_name << ":" << d.line << ": expected a number, got '" << word << "'");
+    return value;
+}
+
+uint32_t
+TopologyLoader::ParseId(const Directive& d, const std::string& word) const
+{
+    uint32_t id = ToUint(d, word);
+    NS_ABORT_MSG_UNLESS(id < m_nodes.GetN(), m_name << ":" << d.line << ": bad node id " << word);
+    return id;
+}
+
+std::vector<uint32_t>
+TopologyLoader::ParseIds(const Directive& d, const std::string& list) const
+{
+    std::vector<uint32_t> ids;
+    std::istringstream in(list);
+    std::string item;
+    while (std::getline(in, item, ','))
+    {
+        std::size_t dash = item.find('-');
+        uint32_t first = ToUint(d, item.substr(0, dash));
+        uint32_t last = (dash == std::string::npos) ? first : ToUint(d, item.substr(dash + 1));
+        NS_ABORT_MSG_UNLESS(first <= last && last < m_nodes.GetN(),
+                            m_name << ":" << d.line << ": bad node id(s) " << item);
+        for (uint32_t id = first; id <= last; id++)
+        {
+            ids.push_back(id);
+        }
+    }
+    return ids;
+}
+
+PointToPointHelper&
+TopologyLoader::P2p(const Directive& d)
+{
+    std::string rate = Opt(d, "rate", "5Mbps");
+    std::string delay = Opt(d, "delay", "2ms");
+    std::string queue = Opt(d, "queue", "100p");
+    auto [it, inserted] = m_p2p.try_emplace(rate + "|" + delay + "|" + queue);
+    if (inserted)
+    {
+        it->second.SetDeviceAttribute("DataRate", StringValue(rate));
+        it->second.SetChannelAttribute("Delay", StringValue(delay));
+        it->second.SetQueue("ns3::DropTailQueue", "MaxSize", StringValue(queue));
+    }
+    return it->second;
+}
+
+CsmaHelper&
+TopologyLoader::Csma(const Directive& d)
+{
+    std::string rate = Opt(d, "rate", "100Mbps");
+    std::string delay = Opt(d, "delay", "6560ns");
+    std::string queue = Opt(d, "queue", "100p");
+    auto [it, inserted] = m_csma.try_emplace(rate + "|" + delay + "|" + queue);
+    if (inserted)
+    {
+        it->second.SetChannelAttribute("DataRate", StringValue(rate));
+        it->second.SetChannelAttribute("Delay", StringValue(delay));
+        it->second.SetQueue("ns3::DropTailQueue", "MaxSize", StringValue(queue));
+    }
+    return it->second;
+}
+
+void
+TopologyLoader::Address(Link& link, Ipv4AddressHelper& pool)
+{
+    link.interfaces = pool.Assign(link.devices);
+    pool.NewNetwork();
+}
+
+void
+TopologyLoader::Load(const std::string& filename)
+{
+    std::ifstream in(filename);
+    NS_ABORT_MSG_UNLESS(in, "Cannot open topology file " << filename);
+    Load(in, filename);
+}
+
+void
+TopologyLoader::Load(std::istream& in, const std::string& name)
+{
+    m_name = name;
+
+    // Parse everything first so that nodes and the stack are set up in bulk.
+    std::vector<Directive> directives;
+    std::string text;
+    for (uint32_t line = 1; std::getline(in, text); line++)
+    {
+        std::istringstream words(text.substr(0, text.find('#')));
+        Directive d{line, {}, {}};
+        std::string word;
+        while (words >> word)
+        {
+            std::size_t eq = word.find('=');
+            if (eq == std::string::npos)
+            {
+                d.args.push_back(word);
+            }
+            else
+            {
+                d.opts[word.substr(0, eq)] = word.substr(eq + 1);
+            }
+        }
+        if (!d.args.empty())
+        {
+            directives.push_back(d);
+        }
+    }
+    NS_ABORT_MSG_UNLESS(!directives.empty() && directives[0].args[0] == "nodes" &&
+                            directives[0].args.size() == 2,
+                        m_name << ": the first directive must be 'nodes <count>'");
+
+    m_nodes.Create(ToUint(directives[0], directives[0].args[1]));
+
+    // Devices
+    std::vector<bool> mobile(m_nodes.GetN(), false);
+    std::vector<std::pair<uint32_t, Vector>> positions;
+    std::vector<std::pair<std::size_t, Directive>> pools; // (first link using it, pool)
+    m_wifiPhy.SetChannel(YansWifiChannelHelper::Default().Create());
+    for (std::size_t i = 1; i < directives.size(); i++)
+    {
+        const Directive& d = directives[i];
+        const std::string& kind = d.args[0];
+        Link link;
+        link.type = kind;
+        link.addressed = Opt(d, "address", "yes") != "no";
+        if (kind == "pool")
+        {
+            NS_ABORT_MSG_UNLESS(d.args.size() == 3,
+                                m_name << ":" << d.line << ": pool <network> <mask>");
+            pools.emplace_back(m_links.size(), d);
+            continue;
+        }
+        else if (kind == "pos")
+        {
+            NS_ABORT_MSG_UNLESS(d.args.size() >= 4,
+                                m_name << ":" << d.line << ": pos <id> <x> <y> [z]");
+            uint32_t id = ParseId(d, d.args[1]);
+            double z = d.args.size() > 4 ? ToDouble(d, d.args[4]) : 0.0;
+            positions.emplace_back(id, Vector(ToDouble(d, d.args[2]), ToDouble(d, d.args[3]), z));
+            mobile[id] = true;
+            continue;
+        }
+        else if (kind == "p2p")
+        {
+            NS_ABORT_MSG_UNLESS(d.args.size() == 3, m_name << ":" << d.line << ": p2p <a> <b>");
+            link.nodes = {ParseId(d, d.args[1]), ParseId(d, d.args[2])};
+            link.devices = P2p(d).Install(m_nodes.Get(link.nodes[0]), m_nodes.Get(link.nodes[1]));
+        }
+        else if (kind == "csma")
+        {
+            NS_ABORT_MSG_UNLESS(d.args.size() == 2, m_name << ":" << d.line << ": csma <ids>");
+            link.nodes = ParseIds(d, d.args[1]);
+            NodeContainer members;
+            for (uint32_t id : link.nodes)
+            {
+                members.Add(m_nodes.Get(id));
+            }
+            link.devices = Csma(d).Install(members);
+        }
+        else if (kind == "wifi")
+        {
+            std::vector<uint32_t> aps = ParseIds(d, Opt(d, "ap", ""));
+            std::vector<uint32_t> stas = ParseIds(d, Opt(d, "sta", ""));
+            std::string standard = Opt(d, "standard", "80211g");
+            WifiHelper wifi;
+            if (standard == "80211b")
+            {
+                wifi.SetStandard(WIFI_STANDARD_80211b);
+            }
+            else if (standard == "80211g")
+            {
+                wifi.SetStandard(WIFI_STANDARD_80211g);
+            }
+            else if (standard == "80211n")
+            {
+                wifi.SetStandard(WIFI_STANDARD_80211n);
+            }
+            else if (standard == "80211ac")
+            {
+                wifi.SetStandard(WIFI_STANDARD_80211ac);
+            }
+            else
+            {
+                NS_ABORT_MSG(m_name << ":" << d.line << ": unknown standard " << standard
+                                    << " (80211b, 80211g, 80211n, 80211ac)");
+            }
+            WifiMacHelper mac;
+            Ssid ssid(Opt(d, "ssid", "ns-3-ssid"));
+            NodeContainer apNodes;
+            NodeContainer staNodes;
+            for (uint32_t id : aps)
+            {
+                apNodes.Add(m_nodes.Get(id));
+                mobile[id] = true;
+            }
+            for (uint32_t id : stas)
+            {
+                staNodes.Add(m_nodes.Get(id));
+                mobile[id] = true;
+            }
+            mac.SetType("ns3::ApWifiMac", "Ssid", SsidValue(ssid));
+            link.devices.Add(wifi.Install(m_wifiPhy, mac, apNodes));
+            mac.SetType("ns3::StaWifiMac", "Ssid", SsidValue(ssid));
+            link.devices.Add(wifi.Install(m_wifiPhy, mac, staNodes));
+            link.nodes = aps;
+            link.nodes.insert(link.nodes.end(), stas.begin(), stas.end());
+        }
+        else
+        {
+            NS_ABORT_MSG(m_name << ":" << d.line << ": unknown directive " << kind);
+        }
+        m_links.push_back(link);
+    }
+
+    // Stack and addresses
+    m_internet.Install(m_nodes);
+    Ipv4AddressHelper pool;
+    pool.SetBase("10.0.0.0", "255.255.255.0");
+    std::size_t nextPool = 0;
+    for (std::size_t l = 0; l < m_links.size(); l++)
+    {
+        while (nextPool < pools.size() && pools[nextPool].first == l)
+        {
+            const Directive& d = pools[nextPool++].second;
+            pool.SetBase(d.args[1].c_str(), d.args[2].c_str());
+        }
+        if (m_links[l].addressed)
+        {
+            Address(m_links[l], pool);
+        }
+    }
+
+    // Mobility, only where it is needed
+    MobilityHelper mobility;
+    mobility.SetMobilityModel("ns3::ConstantPositionMobilityModel");
+    NodeContainer placed;
+    for (uint32_t id = 0; id < m_nodes.GetN(); id++)
+    {
+        if (mobile[id])
+        {
+            placed.Add(m_nodes.Get(id));
+        }
+    }
+    mobility.Install(placed);
+    for (const auto& [id, position] : positions)
+    {
+        m_nodes.Get(id)->GetObject<MobilityModel>()->SetPosition(position);
+    }
+}
+
+InternetStackHelper&
+TopologyLoader::GetInternetStack()
+{
+    return m_internet;
+}
+
+NodeContainer
+TopologyLoader::GetNodes() const
+{
+    return m_nodes;
+}
+
+const std::vector<TopologyLoader::Link>&
+TopologyLoader::GetLinks() const
+{
+    return m_links;
+}
+
+YansWifiPhyHelper&
+TopologyLoader::GetWifiPhy()
+{
+    return m_wifiPhy;
+}
+
+} // namespace ns3
+
+#endif /* TOPOLOGY_LOADER_H */
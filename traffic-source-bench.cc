@@ -0,0 +1,186 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Simulation cost per packet of the traffic sources.
+ *
+ * One UDP source sends --rate of --size byte packets over a 100Gbps
+ * point-to-point link to a PacketSink for --duration simulated seconds.
+ * --source selects OnOffApplication ("onoff") or SharedPayloadSource
+ * ("shared"); with "shared", --burst packets are sent per event (see
+ * shared-payload-source.h).
+ *
+ * Delay and jitter are measured at the sink against each packet's
+ * SendTimeTag: the nominal send time of a burst packet, or the time the
+ * packet reached the sender's device for the other sources.  Jitter is the
+ * mean difference between the delays of consecutive packets.
+ *
+ * One line is printed:
+ *   source,packets_sent,packets_received,wall_s,packets_per_wall_s,events,
+ *   mean_delay_us,jitter_us
+ *
+ *   ./ns3 run "scratch/traffic-source-bench --source=onoff --rate=10Gbps"
+ *   ./ns3 run "scratch/traffic-source-bench --source=shared --rate=10Gbps --burst=16"
+ */
+
+#include "ns3/applications-module.h"
+#include "ns3/core-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/network-module.h"
+#include "ns3/point-to-point-module.h"
+
+#include "shared-payload-source.h"
+
+#include <chrono>
+#include <iostream>
+#include <string>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE("TrafficSourceBench");
+
+static uint64_t g_sent = 0;            //!< Packets sent by the source.
+static uint64_t g_timed = 0;           //!< Packets received with a send time.
+static Time g_delaySum;                //!< Sum of their delays.
+static Time g_jitterSum;               //!< Sum of the delay differences.
+static Time g_lastDelay = Seconds(-1); //!< Delay of the previous packet, negative if none.
+
+/**
+ * Count a sent packet.
+ * \param packet The packet.
+ */
+static void
+Sent(Ptr<const Packet> packet)
+{
+    g_sent++;
+}
+
+/**
+ * Stamp packets that carry no nominal send time as they reach the device.
+ * \param packet The packet.
+ */
+static void
+Stamp(Ptr<const Packet> packet)
+{
+    SendTimeTag tag;
+    if (!packet->PeekPacketTag(tag))
+    {
+        tag.SetTime(Simulator::Now());
+        packet->AddPacketTag(tag);
+    }
+}
+
+/**
+ * Measure the delay of a received packet.
+ * \param packet The packet.
+ * \param from The sender.
+ */
+static void
+Received(Ptr<const Packet> packet, const Address& from)
+{
+    SendTimeTag tag;
+    if (!packet->PeekPacketTag(tag))
+    {
+        return;
+    }
+    Time delay = Simulator::Now() - tag.GetTime();
+    if (!g_lastDelay.IsNegative())
+    {
+        g_jitterSum += Abs(delay - g_lastDelay);
+    }
+    g_lastDelay = delay;
+    g_delaySum += delay;
+    g_timed++;
+}
+
+int
+main(int argc, char* argv[])
+{
+    std::string source("shared");
+    std::string rate("10Gbps");
+    uint32_t size = 1000;
+    double duration = 1;
+    uint32_t burst = 1;
+
+    CommandLine cmd(__FILE__);
+    cmd.AddValue("source", "Traffic source (onoff, shared)", source);
+    cmd.AddValue("rate", "Sending rate", rate);
+    cmd.AddValue("size", "Payload size in bytes", size);
+    cmd.AddValue("duration", "Simulated seconds of traffic", duration);
+    cmd.AddValue("burst", "Packets per send event of the shared source", burst);
+    cmd.Parse(argc, argv);
+
+    NodeContainer nodes;
+    nodes.Create(2);
+    PointToPointHelper p2p;
+    p2p.SetDeviceAttribute("DataRate", StringValue("100Gbps"));
+    p2p.SetChannelAttribute("Delay", StringValue("10us"));
+    NetDeviceContainer devices = p2p.Install(nodes);
+    InternetStackHelper internet;
+    internet.Install(nodes);
+    Ipv4AddressHelper ipv4;
+    ipv4.SetBase("10.1.1.0", "255.255.255.252");
+    Ipv4InterfaceContainer interfaces = ipv4.Assign(devices);
+
+    uint16_t port = 9;
+    InetSocketAddress remote(interfaces.GetAddress(1), port);
+    ApplicationContainer apps;
+    if (source == "onoff")
+    {
+        OnOffHelper onoff("ns3::UdpSocketFactory", remote);
+        onoff.SetConstantRate(DataRate(rate), size);
+        apps = onoff.Install(nodes.Get(0));
+    }
+    else
+    {
+        NS_ABORT_MSG_UNLESS(source == "shared", "Unknown source " << source);
+        SharedPayloadSourceHelper shared("ns3::UdpSocketFactory", remote);
+        shared.SetAttribute("DataRate", DataRateValue(DataRate(rate)));
+        shared.SetAttribute("PacketSize", UintegerValue(size));
+        shared.SetAttribute("BurstSize", UintegerValue(burst));
+        apps = shared.Install(nodes.Get(0));
+    }
+    apps.Get(0)->TraceConnectWithoutContext("Tx", MakeCallback(&Sent));
+    apps.Start(Seconds(0));
+    apps.Stop(Seconds(duration));
+
+    PacketSinkHelper sinkHelper("ns3::UdpSocketFactory",
+                                InetSocketAddress(Ipv4Address::GetAny(), port));
+    ApplicationContainer sink = sinkHelper.Install(nodes.Get(1));
+    devices.Get(0)->TraceConnectWithoutContext("MacTx", MakeCallback(&Stamp));
+    sink.Get(0)->TraceConnectWithoutContext("Rx", MakeCallback(&Received));
+
+    auto start = std::chrono::steady_clock::now();
+    Simulator::Stop(Seconds(duration + 0.1));
+    Simulator::Run();
+    std::chrono::duration<double> wall = std::chrono::steady_clock::now() - start;
+
+    uint64_t received = DynamicCast<PacketSink>(sink.Get(0))->GetTotalRx() / size;
+    std::cout << source << "," << g_sent << "," << received << "," << wall.count() << ","
+              << g_sent / wall.count() << "," << Simulator::GetEventCount() << ",";
+    if (g_timed > 0)
+    {
+        std::cout << g_delaySum.GetSeconds() * 1e6 / g_timed << ","
+                  << (g_timed > 1 ? g_jitterSum.GetSeconds() * 1e6 / (g_timed - 1) : 0);
+    }
+    else
+    {
+        std::cout << ",";
+    }
+    std::cout << std::endl;
+
+    Simulator::Destroy();
+    return 0;
+}
@@ -0,0 +1,293 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Goodput of the answerfinal.cc AP cell with and without frame aggregation.
+ *
+ * One AP and --stas STAs 10 m around it (answerfinal.cc has N5 and five
+ * STAs).  The AP sends --offered Mbps of UDP in --packetSize datagrams,
+ * split over the STAs, more than any of the configurations carries.  Each
+ * of --configs is a standard:aggregation pair (see wifi-aggregation.h);
+ * b:none is the 802.11b cell of answerfinal.cc at the 11 Mbps an 802.11b
+ * PHY can send, n:none its HtMcs7 rate on 802.11n without aggregation.
+ * Every configuration is a separate simulation in a forked process,
+ * --jobs at a time.
+ *
+ * The traffic starts at 1 s, after association; the second after that
+ * (block ack setup, queues filling) is not measured.  One line is printed
+ * per configuration:
+ *   standard,aggregation,stas,goodput_mbps,data_frames_per_s,mpdus_per_frame,
+ *   goodput_vs_first
+ * where data frames are the PSDUs carrying data, an A-MPDU counting once,
+ * and goodput_vs_first is relative to the first configuration.
+ *
+ *   ./ns3 run "scratch/wifi-aggregation-bench"
+ *   ./ns3 run "scratch/wifi-aggregation-bench --configs=n:none,n:ampdu --stas=20"
+ */
+
+#include "ns3/applications-module.h"
+#include "ns3/core-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/mobility-module.h"
+#include "ns3/network-module.h"
+#include "ns3/wifi-module.h"
+
+#include "wifi-aggregation.h"
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE("WifiAggregationBench");
+
+static bool g_measuring = false; //!< Whether the measured window has started.
+static uint64_t g_frames = 0;    //!< Data PSDUs sent in the window.
+static uint64_t g_mpdus = 0;     //!< MPDUs in them.
+
+/**
+ * PhyTxPsduBegin sink.
+ * \param psdus The PSDU of each station.
+ * \param txVector Their TXVECTOR.
+ * \param power The TX power in W.
+ */
+static void
+PsduSent(WifiConstPsduMap psdus, WifiTxVector txVector, double power)
+{
+    if (!g_measuring)
+    {
+        return;
+    }
+    for (const auto& [staId, psdu] : psdus)
+    {
+        if (psdu->GetHeader(0).IsData())
+        {
+            g_frames++;
+            g_mpdus += psdu->GetNMpdus();
+        }
+    }
+}
+
+/**
+ * Run one configuration.
+ * \param standard b, n or ac.
+ * \param aggregation none, ampdu, amsdu or both.
+ * \param stas The number of STAs.
+ * \param offered The offered load in Mbps.
+ * \param packetSize The UDP payload size.
+ * \param duration Measured seconds.
+ * \return the result line, without goodput_vs_first.
+ */
+static std::string
+RunOne(const std::string& standard,
+       const std::string& aggregation,
+       uint32_t stas,
+       double offered,
+       uint32_t packetSize,
+       double duration)
+{
+    NodeContainer ap;
+    ap.Create(1);
+    NodeContainer sta;
+    sta.Create(stas);
+
+    WifiHelper wifi;
+    YansWifiPhyHelper phy;
+    phy.SetChannel(YansWifiChannelHelper::Default().Create());
+    SetWifiStandard(wifi, phy, standard);
+    WifiMacHelper mac;
+    Ssid ssid("network");
+    mac.SetType("ns3::ApWifiMac", "Ssid", SsidValue(ssid));
+    NetDeviceContainer apDevice = wifi.Install(phy, mac, ap);
+    mac.SetType("ns3::StaWifiMac", "Ssid", SsidValue(ssid));
+    NetDeviceContainer staDevices = wifi.Install(phy, mac, sta);
+    if (standard != "b")
+    {
+        SetWifiAggregation(NetDeviceContainer(apDevice, staDevices), aggregation);
+    }
+
+    MobilityHelper mobility;
+    Ptr<ListPositionAllocator> positions = CreateObject<ListPositionAllocator>();
+    positions->Add(Vector(0, 0, 0));
+    for (uint32_t i = 0; i < stas; i++)
+    {
+        double angle = 2 * M_PI * i / stas;
+        positions->Add(Vector(10 * std::cos(angle), 10 * std::sin(angle), 0));
+    }
+    mobility.SetPositionAllocator(positions);
+    mobility.Install(ap);
+    mobility.Install(sta);
+
+    InternetStackHelper internet;
+    internet.Install(ap);
+    internet.Install(sta);
+    Ipv4AddressHelper ipv4;
+    ipv4.SetBase("10.1.5.0", "255.255.255.0");
+    ipv4.Assign(apDevice);
+    Ipv4InterfaceContainer staInterfaces = ipv4.Assign(staDevices);
+
+    uint16_t port = 9;
+    PacketSinkHelper sinkHelper("ns3::UdpSocketFactory",
+                                InetSocketAddress(Ipv4Address::GetAny(), port));
+    ApplicationContainer sinks = sinkHelper.Install(sta);
+    double start = 1;
+    double warmup = 1;
+    for (uint32_t i = 0; i < stas; i++)
+    {
+        OnOffHelper onoff("ns3::UdpSocketFactory",
+                          InetSocketAddress(staInterfaces.GetAddress(i), port));
+        onoff.SetConstantRate(DataRate(offered * 1e6 / stas), packetSize);
+        ApplicationContainer app = onoff.Install(ap);
+        app.Start(Seconds(start + 0.001 * i));
+        app.Stop(Seconds(start + warmup + duration));
+    }
+
+    Config::ConnectWithoutContext(
+        "/NodeList/*/DeviceList/*/$ns3::WifiNetDevice/Phy/PhyTxPsduBegin",
+        MakeCallback(&PsduSent));
+    uint64_t before = 0;
+    Simulator::Schedule(Seconds(start + warmup), [&]() {
+        g_measuring = true;
+        for (uint32_t i = 0; i < stas; i++)
+        {
+            before += DynamicCast<PacketSink>(sinks.Get(i))->GetTotalRx();
+        }
+    });
+    Simulator::Stop(Seconds(start + warmup + duration));
+    Simulator::Run();
+
+    uint64_t after = 0;
+    for (uint32_t i = 0; i < stas; i++)
+    {
+        after += DynamicCast<PacketSink>(sinks.Get(i))->GetTotalRx();
+    }
+    std::ostringstream line;
+    line << standard << "," << aggregation << "," << stas << ","
+         << (after - before) * 8 / duration / 1e6 << "," << g_frames / duration << ","
+         << (g_frames ? double(g_mpdus) / g_frames : 0);
+
+    Simulator::Destroy();
+    return line.str();
+}
+
+int
+main(int argc, char* argv[])
+{
+    std::string configs("b:none,n:none,n:ampdu,n:amsdu,n:both,ac:none,ac:both");
+    uint32_t stas = 5;
+    double offered = 400;
+    uint32_t packetSize = 1472;
+    double duration = 5;
+    uint32_t jobs = std::thread::hardware_concurrency();
+
+    CommandLine cmd(__FILE__);
+    cmd.AddValue("configs", "Comma-separated standard:aggregation pairs", configs);
+    cmd.AddValue("stas", "Number of STAs", stas);
+    cmd.AddValue("offered", "UDP load offered by the AP in Mbps, over all STAs", offered);
+    cmd.AddValue("packetSize", "UDP payload size in bytes", packetSize);
+    cmd.AddValue("duration", "Measured seconds", duration);
+    cmd.AddValue("jobs", "Runs in parallel", jobs);
+    cmd.Parse(argc, argv);
+
+    NS_ABORT_MSG_UNLESS(stas >= 1, "Need at least one STA");
+
+    std::vector<std::pair<std::string, std::string>> runs;
+    std::istringstream configList(configs);
+    std::string config;
+    while (std::getline(configList, config, ','))
+    {
+        std::size_t colon = config.find(':');
+        NS_ABORT_MSG_UNLESS(colon != std::string::npos,
+                            "Expected standard:aggregation, got " << config);
+        runs.emplace_back(config.substr(0, colon), config.substr(colon + 1));
+        NS_ABORT_MSG_UNLESS(runs.back().first != "b" || runs.back().second == "none",
+                            "802.11b has no aggregation");
+    }
+
+    // One process per run: ns-3 keeps global simulation state, so runs
+    // cannot share a process concurrently.
+    std::vector<std::string> results(runs.size());
+    std::map<pid_t, std::pair<std::size_t, int>> running; // pid -> (run, pipe)
+    std::size_t next = 0;
+    while (next < runs.size() || !running.empty())
+    {
+        if (next < runs.size() && running.size() < std::max(1U, jobs))
+        {
+            int fds[2];
+            NS_ABORT_MSG_IF(pipe(fds) != 0, "pipe() failed");
+            pid_t pid = fork();
+            NS_ABORT_MSG_IF(pid < 0, "fork() failed");
+            if (pid == 0)
+            {
+                close(fds[0]);
+                std::string line = RunOne(runs[next].first,
+                                          runs[next].second,
+                                          stas,
+                                          offered,
+                                          packetSize,
+                                          duration);
+                NS_ABORT_MSG_IF(write(fds[1], line.data(), line.size()) < 0, "write() failed");
+                _exit(0);
+            }
+            close(fds[1]);
+            running[pid] = {next++, fds[0]};
+            continue;
+        }
+        int status;
+        pid_t pid = wait(&status);
+        auto [run, fd] = running[pid];
+        running.erase(pid);
+        char buffer[256];
+        ssize_t n = read(fd, buffer, sizeof(buffer));
+        close(fd);
+        results[run] = (n > 0 && WIFEXITED(status) && WEXITSTATUS(status) == 0)
+                           ? std::string(buffer, n)
+                           : runs[run].first + "," + runs[run].second + ",failed";
+    }
+
+    std::cout << "standard,aggregation,stas,goodput_mbps,data_frames_per_s,mpdus_per_frame,"
+              << "goodput_vs_first" << std::endl;
+    std::vector<double> goodputs;
+    for (const auto& line : results)
+    {
+        std::vector<std::string> fields;
+        std::istringstream stream(line);
+        std::string field;
+        while (std::getline(stream, field, ','))
+        {
+            fields.push_back(field);
+        }
+        goodputs.push_back(fields.size() == 6 ? std::stod(fields[3]) : 0);
+    }
+    for (std::size_t i = 0; i < results.size(); i++)
+    {
+        std::cout << results[i];
+        if (goodputs[i] > 0 && goodputs[0] > 0)
+        {
+            std::cout << "," << goodputs[i] / goodputs[0];
+        }
+        std::cout << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,138 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * 802.11b/n/ac cell setup with optional frame aggregation.
+ *
+ * SetWifiStandard() configures a WifiHelper and YansWifiPhyHelper for one
+ * of the standards the scratch programs compare, with a constant rate:
+ *   b:  802.11b, 2.4 GHz channel 1, DsssRate11Mbps (control DsssRate1Mbps)
+ *   n:  802.11n, 5 GHz channel 36 (20 MHz), HtMcs7 (control HtMcs0)
+ *   ac: 802.11ac, 5 GHz channel 42 (80 MHz), VhtMcs7 (control VhtMcs0)
+ * Call it before installing the devices.
+ *
+ * SetWifiAggregation() sets the best-effort aggregation of installed HT or
+ * VHT devices:
+ *   none:  one MPDU per frame, acknowledged with a normal ack
+ *   ampdu: A-MPDU up to 65535 bytes (the ns-3 default)
+ *   amsdu: A-MSDU up to 7935 bytes, no A-MPDU
+ *   both:  A-MSDUs inside A-MPDUs
+ * With A-MPDU the originator sets up a block ack agreement with each
+ * recipient (ADDBA) and the MPDUs of a frame are acknowledged with one
+ * block ack.  802.11b has no aggregation.
+ *
+ *   SetWifiStandard(wifi, phy, "n");
+ *   NetDeviceContainer devices = wifi.Install(phy, mac, nodes);
+ *   SetWifiAggregation(devices, "both");
+ *
+ * wifi-aggregation-bench.cc compares the combinations.
+ */
+
+#ifndef WIFI_AGGREGATION_H
+#define WIFI_AGGREGATION_H
+
+#include "ns3/abort.h"
+#include "ns3/net-device-container.h"
+#include "ns3/string.h"
+#include "ns3/uinteger.h"
+#include "ns3/wifi-helper.h"
+#include "ns3/wifi-mac.h"
+#include "ns3/wifi-net-device.h"
+#include "ns3/yans-wifi-helper.h"
+
+#include <string>
+
+namespace ns3
+{
+
+/**
+ * Configure the standard, channel and constant rate of a cell.
+ * \param wifi The Wi-Fi helper.
+ * \param phy The PHY helper.
+ * \param standard b, n or ac.
+ */
+void SetWifiStandard(WifiHelper& wifi, YansWifiPhyHelper& phy, const std::string& standard);
+
+/**
+ * Set the best-effort aggregation of HT or VHT devices.
+ * \param devices The installed devices.
+ * \param aggregation none, ampdu, amsdu or both.
+ */
+void SetWifiAggregation(NetDeviceContainer devices, const std::string& aggregation);
+
+void
+SetWifiStandard(WifiHelper& wifi, YansWifiPhyHelper& phy, const std::string& standard)
+{
+    std::string data;
+    std::string control;
+    if (standard == "b")
+    {
+        wifi.SetStandard(WIFI_STANDARD_80211b);
+        phy.Set("ChannelSettings", StringValue("{1, 22, BAND_2_4GHZ, 0}"));
+        data = "DsssRate11Mbps";
+        control = "DsssRate1Mbps";
+    }
+    else if (standard == "n")
+    {
+        wifi.SetStandard(WIFI_STANDARD_80211n);
+        phy.Set("ChannelSettings", StringValue("{36, 20, BAND_5GHZ, 0}"));
+        data = "HtMcs7";
+        control = "HtMcs0";
+    }
+    else if (standard == "ac")
+    {
+        wifi.SetStandard(WIFI_STANDARD_80211ac);
+        phy.Set("ChannelSettings", StringValue("{42, 80, BAND_5GHZ, 0}"));
+        data = "VhtMcs7";
+        control = "VhtMcs0";
+    }
+    else
+    {
+        NS_ABORT_MSG("Unknown Wi-Fi standard " << standard);
+    }
+    wifi.SetRemoteStationManager("ns3::ConstantRateWifiManager",
+                                 "DataMode",
+                                 StringValue(data),
+                                 "ControlMode",
+                                 StringValue(control));
+}
+
+void
+SetWifiAggregation(NetDeviceContainer devices, const std::string& aggregation)
+{
+    NS_ABORT_MSG_UNLESS(aggregation == "none" || aggregation == "ampdu" ||
+                            aggregation == "amsdu" || aggregation == "both",
+                        "Unknown aggregation " << aggregation);
+    for (uint32_t i = 0; i < devices.GetN(); i++)
+    {
+        Ptr<WifiNetDevice> device = DynamicCast<WifiNetDevice>(devices.Get(i));
+        NS_ABORT_MSG_UNLESS(device && device->GetHtConfiguration(),
+                            "Aggregation needs 802.11n or later devices");
+        Ptr<WifiMac> mac = device->GetMac();
+        // A-MPDU is on by default for HT and later, A-MSDU off
+        if (aggregation == "none" || aggregation == "amsdu")
+        {
+            mac->SetAttribute("BE_MaxAmpduSize", UintegerValue(0));
+        }
+        if (aggregation == "amsdu" || aggregation == "both")
+        {
+            mac->SetAttribute("BE_MaxAmsduSize", UintegerValue(7935));
+        }
+    }
+}
+
+} // namespace ns3
+
+#endif /* WIFI_AGGREGATION_H */
@@ -0,0 +1,239 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * One YansWifiChannel per group of overlapping Wi-Fi channels.
+ *
+ * A YansWifiChannel offers every frame to every PHY attached to it, whatever
+ * channel number the PHY operates on; a PHY on another channel only drops
+ * the frame after the channel has computed its loss and delay and scheduled
+ * its reception.  With many BSSs on non-overlapping channels sharing one
+ * channel object, most of that work is for receivers that cannot hear the
+ * frame.
+ *
+ * WifiChannelPartition hands out one YansWifiChannel per group of
+ * operating channels whose frequency ranges overlap, created from one
+ * YansWifiChannelHelper.  Every channel a BSS may operate on, including
+ * those it may switch to, is declared with Add() first; channels that
+ * overlap, directly or through another declared channel (e.g. 36 and 40
+ * through the 40 MHz channel 38), end up in the same group.  Get() then
+ * returns the YansWifiChannel of a declared channel; after the first Get()
+ * nothing can be added, since a PHY cannot leave a YansWifiChannel.
+ *
+ *   WifiChannelPartition partition(YansWifiChannelHelper::Default());
+ *   partition.Add(36, 20, WIFI_PHY_BAND_5GHZ);
+ *   partition.Add(40, 20, WIFI_PHY_BAND_5GHZ);
+ *   phy.SetChannel(partition.Get(36, 20, WIFI_PHY_BAND_5GHZ));
+ *   phy.Set("ChannelSettings", StringValue("{36, 20, BAND_5GHZ, 0}"));
+ *
+ * multi-ap-bench.cc measures the effect as the number of APs grows.
+ */
+
+#ifndef WIFI_CHANNEL_PARTITION_H
+#define WIFI_CHANNEL_PARTITION_H
+
+#include "ns3/abort.h"
+#include "ns3/wifi-phy-band.h"
+#include "ns3/yans-wifi-channel.h"
+#include "ns3/yans-wifi-helper.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <map>
+#include <tuple>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * Groups overlapping operating channels onto shared YansWifiChannels.
+ */
+class WifiChannelPartition
+{
+  public:
+    /**
+     * \param helper Creates the channel of each group.
+     */
+    WifiChannelPartition(YansWifiChannelHelper helper);
+
+    /**
+     * Declare an operating channel.
+     * \param number The channel number.
+     * \param width The width in MHz.
+     * \param band The band.
+     */
+    void Add(uint8_t number, uint16_t width, WifiPhyBand band);
+
+    /**
+     * \param number The channel number.
+     * \param width The width in MHz.
+     * \param band The band.
+     * \return the YansWifiChannel of a declared operating channel.
+     */
+    Ptr<YansWifiChannel> Get(uint8_t number, uint16_t width, WifiPhyBand band);
+
+    /** \return the number of groups, i.e. of YansWifiChannels. */
+    uint32_t GetNGroups();
+
+  private:
+    /** (channel number, width, band). */
+    using Key = std::tuple<uint8_t, uint16_t, WifiPhyBand>;
+
+    /**
+     * \param key An operating channel.
+     * \return its center frequency in MHz.
+     */
+    static uint16_t GetCenterFrequency(const Key& key);
+
+    /**
+     * \param a An operating channel.
+     * \param b Another one.
+     * \return whether their frequency ranges overlap.
+     */
+    static bool Overlap(const Key& a, const Key& b);
+
+    /**
+     * \param i A declared channel.
+     * \return the first declared channel of its group.
+     */
+    uint32_t Find(uint32_t i);
+
+    /** Create the YansWifiChannel of each group. */
+    void Build();
+
+    YansWifiChannelHelper m_helper;                 //!< Creates the channels.
+    std::vector<Key> m_keys;                        //!< Declared operating channels.
+    std::vector<uint32_t> m_parent;                 //!< Union-find parent of each.
+    std::map<Key, Ptr<YansWifiChannel>> m_channels; //!< Channel of each, once built.
+};
+
+WifiChannelPartition::WifiChannelPartition(YansWifiChannelHelper helper)
+    : m_helper(helper)
+{
+}
+
+uint16_t
+WifiChannelPartition::GetCenterFrequency(const Key& key)
+{
+    uint8_t number = std::get<0>(key);
+    switch (std::get<2>(key))
+    {
+    case WIFI_PHY_BAND_2_4GHZ:
+        return number == 14 ? 2484 : 2407 + 5 * number;
+    case WIFI_PHY_BAND_5GHZ:
+        return 5000 + 5 * number;
+    case WIFI_PHY_BAND_6GHZ:
+        return 5950 + 5 * number;
+    default:
+        NS_ABORT_MSG("WifiChannelPartition: unsupported band " << std::get<2>(key));
+    }
+    return 0;
+}
+
+bool
+WifiChannelPartition::Overlap(const Key& a, const Key& b)
+{
+    if (std::get<2>(a) != std::get<2>(b))
+    {
+        return false;
+    }
+    int fa = GetCenterFrequency(a);
+    int fb = GetCenterFrequency(b);
+    return 2 * std::abs(fa - fb) < std::get<1>(a) + std::get<1>(b);
+}
+
+void
+WifiChannelPartition::Add(uint8_t number, uint16_t width, WifiPhyBand band)
+{
+    NS_ABORT_MSG_UNLESS(m_channels.empty(), "WifiChannelPartition: Add() after Get()");
+    Key key{number, width, band};
+    if (std::find(m_keys.begin(), m_keys.end(), key) != m_keys.end())
+    {
+        return;
+    }
+    uint32_t i = m_keys.size();
+    m_keys.push_back(key);
+    m_parent.push_back(i);
+    for (uint32_t j = 0; j < i; j++)
+    {
+        if (Overlap(m_keys[i], m_keys[j]))
+        {
+            m_parent[Find(i)] = Find(j);
+        }
+    }
+}
+
+uint32_t
+WifiChannelPartition::Find(uint32_t i)
+{
+    while (m_parent[i] != i)
+    {
+        m_parent[i] = m_parent[m_parent[i]];
+        i = m_parent[i];
+    }
+    return i;
+}
+
+void
+WifiChannelPartition::Build()
+{
+    std::map<uint32_t, Ptr<YansWifiChannel>> groups;
+    for (uint32_t i = 0; i < m_keys.size(); i++)
+    {
+        Ptr<YansWifiChannel>& channel = groups[Find(i)];
+        if (!channel)
+        {
+            channel = m_helper.Create();
+        }
+        m_channels[m_keys[i]] = channel;
+    }
+}
+
+Ptr<YansWifiChannel>
+WifiChannelPartition::Get(uint8_t number, uint16_t width, WifiPhyBand band)
+{
+    if (m_channels.empty())
+    {
+        Build();
+    }
+    auto it = m_channels.find(Key{number, width, band});
+    NS_ABORT_MSG_UNLESS(it != m_channels.end(),
+                        "WifiChannelPartition: channel " << +number << " (" << width << " MHz, "
+                                                         << band << ") was not added");
+    return it->second;
+}
+
+uint32_t
+WifiChannelPartition::GetNGroups()
+{
+    if (m_channels.empty())
+    {
+        Build();
+    }
+    std::vector<YansWifiChannel*> channels;
+    for (const auto& [key, channel] : m_channels)
+    {
+        if (std::find(channels.begin(), channels.end(), PeekPointer(channel)) == channels.end())
+        {
+            channels.push_back(PeekPointer(channel));
+        }
+    }
+    return channels.size();
+}
+
+} // namespace ns3
+
+#endif /* WIFI_CHANNEL_PARTITION_H */
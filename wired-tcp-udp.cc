@@ -59,6 +59,8 @@
 //  At time 16s, stop the second flow.
 
 // - Tracing of queues and packet receptions to file "dynamic-global-routing.tr"
+// - --routeSnapshotInterval=0.1 records routing table changes to
+//   "dynamic-global-routing.rsnap" (see route-snapshot-tool.cc)
 #include "ns3/applications-module.h"
 #include "ns3/constant-velocity-mobility-model.h"
 #include "ns3/core-module.h"
@@ -72,6 +74,10 @@
 #include "ns3/point-to-point-module.h"
 #include "ns3/rip-helper.h"
 
+#include "incremental-global-routing.h"
+#include "pcap-ring.h"
+#include "routing-snapshot.h"
+
 #include <cassert>
 #include <fstream>
 #include <iostream>
@@ -81,6 +87,18 @@ using namespace ns3;
 
 NS_LOG_COMPONENT_DEFINE("DynamicGlobalRoutingExample");
 
+/**
+ * Report a pcap ring flush.
+ * \param reason What triggered it.
+ * \param packets Packets written.
+ */
+static void
+PcapFlushed(std::string reason, uint64_t packets)
+{
+    NS_LOG_UNCOND(Simulator::Now().As(Time::S) << " pcap ring: " << packets
+                                               << " packets written after " << reason);
+}
+
 int
 main(int argc, char* argv[])
 {
@@ -90,6 +108,15 @@ main(int argc, char* argv[])
     bool printRoutingTables = false;
     bool showPings = false;
     std::string SplitHorizon("PoisonReverse");
+    std::string routing("global");
+    uint32_t spfThreads = 1;
+    std::string pcap("full");
+    uint32_t pcapRingPackets = 1000;
+    double pcapRingSeconds = 0;
+    uint32_t pcapSnapLen = 96;
+    bool dynamicArp = false;
+    double routeSnapshotInterval = 0;
+    std::string routeSnapshotFile("dynamic-global-routing.rsnap");
 
     CommandLine cmd(__FILE__);
     cmd.AddValue("verbose", "turn on log components", verbose);
@@ -100,6 +127,33 @@ main(int argc, char* argv[])
     cmd.AddValue("splitHorizonStrategy",
                  "Split Horizon strategy to use (NoSplitHorizon, SplitHorizon, PoisonReverse)",
                  SplitHorizon);
+    cmd.AddValue("routing",
+                 "Routing protocol (global, rip, incremental: global routes updated by "
+                 "IncrementalGlobalRouting)",
+                 routing);
+    cmd.AddValue("spfThreads", "SPF threads with routing=incremental, 0 for all cores", spfThreads);
+    cmd.AddValue("pcap",
+                 "Pcap capture (full, ring: only around queue drops and interfaces going down, "
+                 "none)",
+                 pcap);
+    cmd.AddValue("pcapRingPackets",
+                 "Packets kept per device in ring mode, 0 for no limit (not with "
+                 "pcapRingSeconds=0)",
+                 pcapRingPackets);
+    cmd.AddValue("pcapRingSeconds",
+                 "Seconds kept per device in ring mode, 0 for no limit (not with "
+                 "pcapRingPackets=0)",
+                 pcapRingSeconds);
+    cmd.AddValue("pcapSnapLen", "Bytes captured per packet in ring mode", pcapSnapLen);
+    cmd.AddValue("dynamicArp",
+                 "Resolve the CSMA LAN addresses with ARP instead of filling the caches",
+                 dynamicArp);
+    cmd.AddValue("routeSnapshotInterval",
+                 "Seconds between binary routing snapshots until 12 s, 0 to disable",
+                 routeSnapshotInterval);
+    cmd.AddValue("routeSnapshotFile",
+                 "Routing snapshot file, read it with route-snapshot-tool",
+                 routeSnapshotFile);
     cmd.Parse(argc, argv);
 
     if (verbose)
@@ -141,7 +195,19 @@ main(int argc, char* argv[])
     NodeContainer n7n8 = NodeContainer(c.Get(6), c.Get(7));
     NodeContainer n8n10 = NodeContainer(c.Get(7), c.Get(9));
 
+    // With RIP, the split horizon strategy above applies; routes take a few
+    // seconds to converge, so the first UDP packets may be dropped.
+    NS_ABORT_MSG_UNLESS(routing == "global" || routing == "rip" || routing == "incremental",
+                        "Unknown routing " << routing);
+    RipHelper ripRouting;
+    Ipv4ListRoutingHelper listRouting;
+    listRouting.Add(ripRouting, 0);
+
     InternetStackHelper internet;
+    if (routing == "rip")
+    {
+        internet.SetRoutingHelper(listRouting);
+    }
     internet.Install(c);
 
     // We create the channels first without any IP addressing information
@@ -208,6 +274,15 @@ main(int argc, char* argv[])
     ipv4.SetBase("10.250.2.0", "255.255.255.0");
     Ipv4InterfaceContainer i10i11 = ipv4.Assign(d10d11);
 
+    // Fill the ARP caches of the CSMA LANs so the first packets do not wait
+    // for (or broadcast) ARP requests
+    if (!dynamicArp)
+    {
+        NeighborCacheHelper neighborCache;
+        neighborCache.PopulateNeighborCache(i245);
+        neighborCache.PopulateNeighborCache(i10i11);
+    }
+
     // ipv4.SetBase("172.16.1.0", "255.255.255.0");
     // Ipv4InterfaceContainer i1i6 = ipv4.Assign(d1d6);
 
@@ -215,7 +290,18 @@ main(int argc, char* argv[])
     // tables in the nodes.
     // RipHelper ripHelper;
     // ripHelper.EnablePoissonReverse(true); // Enable poison reverse
-    Ipv4GlobalRoutingHelper::PopulateRoutingTables();
+    if (routing == "global")
+    {
+        Ipv4GlobalRoutingHelper::PopulateRoutingTables();
+    }
+    Ptr<IncrementalGlobalRouting> spf;
+    if (routing == "incremental")
+    {
+        spf = Create<IncrementalGlobalRouting>();
+        spf->SetThreads(spfThreads);
+        spf->Install();
+        spf->Populate();
+    }
     // Create the OnOff application to send UDP datagrams of size
     // 210 bytes at a rate of 448 Kb/s
     NS_LOG_INFO("Create Applications.");
@@ -279,8 +365,32 @@ main(int argc, char* argv[])
     csma.EnableAsciiAll(stream);
     internet.EnableAsciiIpv4All(stream);
 
-    p2p.EnablePcapAll("dynamic-global-routing");
-    csma.EnablePcapAll("dynamic-global-routing", false);
+    Ptr<PcapRing> pcapRing;
+    if (pcap == "full")
+    {
+        p2p.EnablePcapAll("dynamic-global-routing");
+        csma.EnablePcapAll("dynamic-global-routing", false);
+    }
+    else if (pcap == "ring")
+    {
+        NetDeviceContainer wired(d1d2, d1d3);
+        wired.Add(d2d6);
+        wired.Add(d5d7);
+        wired.Add(d7d9);
+        wired.Add(d9d10);
+        wired.Add(d8d10);
+        wired.Add(d245);
+        wired.Add(d10d11);
+        wired.Add(d7d8);
+        pcapRing = Create<PcapRing>("dynamic-global-routing",
+                                    pcapRingPackets,
+                                    Seconds(pcapRingSeconds),
+                                    pcapSnapLen);
+        pcapRing->SetFlushCallback(MakeCallback(&PcapFlushed));
+        pcapRing->Enable(wired);
+        pcapRing->TriggerOnDrop(wired);
+        pcapRing->TriggerOnInterfaceDown(c);
+    }
 
     // Ptr<Node> n1 = c.Get(1);
     // Ptr<Ipv4> ipv41 = n1->GetObject<Ipv4>();
@@ -307,6 +417,14 @@ main(int argc, char* argv[])
         Create<OutputStreamWrapper>("dynamic-global-routing.routes", std::ios::out);
     Ipv4RoutingHelper::PrintRoutingTableAllAt(Seconds(12), routingStream);
 
+    // Only the changes between snapshots are written, so short intervals are cheap
+    Ptr<RoutingSnapshot> routingSnapshot;
+    if (routeSnapshotInterval > 0)
+    {
+        routingSnapshot = Create<RoutingSnapshot>(routeSnapshotFile);
+        routingSnapshot->Start(Seconds(routeSnapshotInterval), Seconds(12));
+    }
+
     AnimationInterface anim("l2q1_midsem_dem.xml");
     anim.SetConstantPosition(c.Get(0), 0.0, 0.0);
     anim.SetConstantPosition(c.Get(1), 20.0, 0.0);
@@ -328,4 +446,6 @@ main(int argc, char* argv[])
     return 0;
 }
 
-// run -> cmd command -> ./ns3 run scratch/first -- --splitHorizonStrategy=SplitHorizon
\ No newline at end of file
+// run -> cmd command -> ./ns3 run scratch/first -- --splitHorizonStrategy=SplitHorizon
+// RIP instead of global routing -> --routing=rip; convergence after link
+// failures for all strategies -> ./ns3 run "scratch/rip-convergence --src=9 --dst=2"
\ No newline at end of file
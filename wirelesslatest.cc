@@ -1,4 +1,5 @@
 #include <fstream>
+#include <iostream>
 #include "ns3/constant-position-mobility-model.h"
 #include "ns3/mobility-helper.h"
 #include "ns3/core-module.h"
@@ -14,15 +15,34 @@
 #include "ns3/ssid.h"
 #include "ns3/ipv4-routing-table-entry.h"
 
+#include "incremental-global-routing.h"
+#include "static-channel-matrix.h"
+
 using namespace ns3;
 
 NS_LOG_COMPONENT_DEFINE("FirstScriptExample");
 
 int main(int argc, char *argv[])
 {
-    CommandLine cmd(_FILE_);
+    bool staticChannel = true;
+    std::string routing("global");
+    uint32_t spfThreads = 1;
+
+    CommandLine cmd(__FILE__);
+    cmd.AddValue("staticChannel",
+                 "Precompute the Wi-Fi loss and delay matrix, and give each PHY a channel "
+                 "reaching only its neighbors, when no node moves",
+                 staticChannel);
+    cmd.AddValue("routing",
+                 "Global routes (global: Ipv4GlobalRoutingHelper, incremental: "
+                 "IncrementalGlobalRouting)",
+                 routing);
+    cmd.AddValue("spfThreads", "SPF threads with routing=incremental, 0 for all cores", spfThreads);
     cmd.Parse(argc, argv);
 
+    NS_ABORT_MSG_UNLESS(routing == "global" || routing == "incremental",
+                        "Unknown routing " << routing);
+
     Time::SetResolution(Time::NS);
     LogComponentEnable("UdpEchoClientApplication", LOG_LEVEL_INFO);
     LogComponentEnable("UdpEchoServerApplication", LOG_LEVEL_INFO);
@@ -57,7 +77,8 @@ int main(int argc, char *argv[])
 
     YansWifiChannelHelper channel = YansWifiChannelHelper::Default();
     YansWifiPhyHelper phy;
-    phy.SetChannel(channel.Create());
+    Ptr<YansWifiChannel> wifiChannel = channel.Create();
+    phy.SetChannel(wifiChannel);
     WifiHelper wifi;
     wifi.SetRemoteStationManager("ns3::AarfWifiManager");
     WifiMacHelper mac;
@@ -109,11 +130,21 @@ int main(int argc, char *argv[])
     clientApps.Stop(Seconds(10.0));
 
     NS_LOG_INFO("Configure multicasting.");
-    Ipv4GlobalRoutingHelper::PopulateRoutingTables();
+    Ptr<IncrementalGlobalRouting> spf;
+    if (routing == "global")
+    {
+        Ipv4GlobalRoutingHelper::PopulateRoutingTables();
+    }
+    else
+    {
+        spf = Create<IncrementalGlobalRouting>();
+        spf->SetThreads(spfThreads);
+        spf->Install();
+        spf->Populate();
+    }
     MobilityHelper mobility;
     mobility.SetMobilityModel("ns3::ConstantPositionMobilityModel");
     mobility.Install(nodes);
-    Ipv4GlobalRoutingHelper::PopulateRoutingTables();
 
     Ptr<ConstantPositionMobilityModel> s0 = nodes.Get(0)->GetObject<ConstantPositionMobilityModel>();
     Ptr<ConstantPositionMobilityModel> s1 = nodes.Get(1)->GetObject<ConstantPositionMobilityModel>();
@@ -142,6 +173,27 @@ int main(int argc, char *argv[])
     s10->SetPosition(Vector(200, 90, 0));
     s11->SetPosition(Vector(200, 0, 0));
     s12->SetPosition(Vector(240, 0, 0));
+
+    // Nothing moves, so the channel can read loss and delay from a table
+    // computed with the models of YansWifiChannelHelper::Default()
+    NodeContainer wifiNodes(wifiStaNodes, wifiApNode);
+    if (staticChannel && StaticChannelMatrix::IsStatic(wifiNodes))
+    {
+        Ptr<StaticChannelMatrix> matrix =
+            Create<StaticChannelMatrix>(wifiNodes,
+                                        CreateObject<LogDistancePropagationLossModel>(),
+                                        CreateObject<ConstantSpeedPropagationDelayModel>());
+        wifiChannel->SetPropagationLossModel(matrix->CreateLossModel());
+        wifiChannel->SetPropagationDelayModel(matrix->CreateDelayModel());
+        // The routes are populated, so each PHY can transmit on a channel of
+        // its own that only holds the PHYs it reaches
+        NetDeviceContainer wifiDevices(device3, device6);
+        matrix->InstallNeighborChannels(wifiDevices);
+        uint32_t n = wifiDevices.GetN();
+        std::cout << "Static Wi-Fi channel: loss and delay precomputed for " << matrix->GetN()
+                  << " nodes, " << matrix->GetNNeighbors() << " of " << n * (n - 1)
+                  << " transmitter/receiver pairs in range" << std::endl;
+    }
     AnimationInterface anim("q.xml");
     Simulator::Stop(Seconds(40.0));
     Simulator::Run();